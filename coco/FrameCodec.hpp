@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+
+namespace coco {
+
+/**
+	Codec for LED strip frames, e.g. to receive frames over a slow link or to store shows in flash memory. The byte-wise
+	difference (modulo 256) of a frame to a reference frame (normally the previous frame) gets run length coded, so
+	unchanged parts of the frame and parts that fade uniformly cost almost nothing. The difference is used instead of
+	XOR as slowly changing effects change most channels by the same small amount. The decoder applies the differences
+	in place to a frame that contains the reference frame, e.g. the buffer of the LED strip, and keeps only a few bytes
+	of state, so the encoded data can be decoded in chunks as it arrives. For a key frame, encode against an empty
+	reference and decode into a frame that is cleared to zero.
+
+	With planes > 1 (e.g. 3 for RGB) the bytes are coded plane by plane (first the red channel of all pixels, then the
+	green channel and so on) which gives longer runs if only some channels change. Sender and receiver have to agree
+	on the frame size and the number of planes, the encoded data has no header. The frame size must be a multiple of
+	the number of planes.
+
+	Tokens of the encoded data:
+	0xxxxxxx: x + 1 unchanged bytes (1 - 128)
+	10xxxxxx: x + 1 differences follow that get added to the frame (1 - 64)
+	11xxxxxx: one difference follows that gets added to x + 3 bytes of the frame (3 - 66)
+	Unchanged bytes at the end of the frame are not encoded.
+*/
+struct FrameCodec {
+	static constexpr int MAX_SKIP = 128;
+	static constexpr int MAX_LITERAL = 64;
+	static constexpr int MIN_REPEAT = 3;
+	static constexpr int MAX_REPEAT = 66;
+
+	/**
+		Maximum size of an encoded frame
+		@param size size of the frame in bytes
+		@return size in bytes
+	*/
+	static constexpr int maxSize(int size) {
+		return size + (size + MAX_LITERAL - 1) / MAX_LITERAL;
+	}
+
+	/**
+		Encode a frame
+		@param reference reference frame, e.g. the previous frame, or empty for a key frame
+		@param data frame to encode, same size as the reference frame
+		@param dst destination, must have space for maxSize() bytes
+		@param planes number of planes, 1 or the number of channels, e.g. 3 for RGB, the frame size must be a multiple of it
+		@return size of the encoded frame in bytes
+	*/
+	static int encode(std::span<const uint8_t> reference, std::span<const uint8_t> data, uint8_t *dst,
+		int planes = 1)
+	{
+		int size = int(data.size());
+		assert(size % planes == 0);
+		int count = size / planes;
+		bool key = reference.empty();
+
+		// get difference at position p in plane order
+		auto get = [&](int p) -> uint8_t {
+			int i = planes == 1 ? p : (p % count) * planes + p / count;
+			return key ? data[i] : data[i] - reference[i];
+		};
+
+		// check if a run of at least MIN_REPEAT equal bytes starts at position p
+		auto isRun = [&](int p) {
+			if (p + MIN_REPEAT > size)
+				return false;
+			uint8_t x = get(p);
+			return x == get(p + 1) && x == get(p + 2);
+		};
+
+		uint8_t *d = dst;
+		int p = 0;
+		while (p < size) {
+			uint8_t x = get(p);
+
+			// count equal bytes
+			int n = 1;
+			int max = x == 0 ? size - p : std::min(MAX_REPEAT, size - p);
+			while (n < max && get(p + n) == x)
+				++n;
+
+			if (x == 0) {
+				// unchanged bytes, stop if they extend to the end of the frame
+				if (p + n == size)
+					break;
+				p += n;
+				while (n > 0) {
+					int c = std::min(n, MAX_SKIP);
+					*d++ = c - 1;
+					n -= c;
+				}
+			} else if (n >= MIN_REPEAT) {
+				// changed bytes with the same difference
+				*d++ = 0xc0 | (n - MIN_REPEAT);
+				*d++ = x;
+				p += n;
+			} else {
+				// literal bytes until a run starts
+				int begin = p;
+				do {
+					++p;
+				} while (p < size && p - begin < MAX_LITERAL && !isRun(p));
+				*d++ = 0x80 | (p - begin - 1);
+				for (int i = begin; i < p; ++i)
+					*d++ = get(i);
+			}
+		}
+		return int(d - dst);
+	}
+
+	/**
+		Streaming decoder that applies encoded data to a frame, the encoded data can be passed in chunks of any size
+	*/
+	class Decoder {
+	public:
+		/**
+			Constructor
+			@param frame frame that contains the reference frame, gets modified in place
+			@param planes number of planes, same as for encoding, the frame size must be a multiple of it
+		*/
+		Decoder(std::span<uint8_t> frame, int planes = 1)
+			: frame(frame.data()), size(int(frame.size())), planes(planes), count(int(frame.size()) / planes)
+		{
+			assert(this->size % planes == 0);
+		}
+
+		/**
+			Reset the decoder to decode the next frame
+		*/
+		void reset() {
+			this->position = 0;
+			this->state = State::TOKEN;
+		}
+
+		/**
+			Decode a chunk of encoded data
+			@param src encoded data
+			@return true if successful, false if the encoded data exceeds the frame
+		*/
+		bool decode(std::span<const uint8_t> src) {
+			const uint8_t *s = src.data();
+			const uint8_t *end = s + src.size();
+			while (s < end) {
+				switch (this->state) {
+				case State::TOKEN: {
+					int token = *s++;
+					int n;
+					if (token < 0x80) {
+						n = token + 1;
+					} else if (token < 0xc0) {
+						n = token - 0x80 + 1;
+						this->state = State::LITERAL;
+					} else {
+						n = token - 0xc0 + MIN_REPEAT;
+						this->state = State::REPEAT;
+					}
+					if (n > this->size - this->position)
+						return false;
+					if (this->state == State::TOKEN)
+						this->position += n;
+					else
+						this->remaining = n;
+					break;
+				}
+				case State::LITERAL: {
+					int n = std::min(this->remaining, int(end - s));
+					apply(n, [s](int i) {return s[i];});
+					s += n;
+					this->remaining -= n;
+					if (this->remaining == 0)
+						this->state = State::TOKEN;
+					break;
+				}
+				case State::REPEAT: {
+					uint8_t x = *s++;
+					apply(this->remaining, [x](int) {return x;});
+					this->state = State::TOKEN;
+					break;
+				}
+				}
+			}
+			return true;
+		}
+
+		/**
+			Check if the encoded data that was passed so far ends with a complete token
+		*/
+		bool complete() const {return this->state == State::TOKEN;}
+
+		/**
+			Get the number of bytes of the frame that were decoded so far, the remaining bytes are unchanged
+		*/
+		int decoded() const {return this->position;}
+
+	protected:
+		enum class State : uint8_t {
+			TOKEN,
+			LITERAL,
+			REPEAT
+		};
+
+		// add n differences to the frame at the current position
+		template <typename F>
+		void apply(int n, F get) {
+			uint8_t *frame = this->frame;
+			int p = this->position;
+			if (this->planes == 1) {
+				frame += p;
+				for (int i = 0; i < n; ++i)
+					frame[i] += get(i);
+			} else {
+				// one strided segment per plane
+				int planes = this->planes;
+				int count = this->count;
+				int plane = p / count;
+				int pixel = p % count;
+				int i = 0;
+				while (i < n) {
+					int c = std::min(n - i, count - pixel);
+					uint8_t *f = frame + pixel * planes + plane;
+					for (int j = 0; j < c; ++j)
+						f[j * planes] += get(i + j);
+					i += c;
+					pixel = 0;
+					++plane;
+				}
+			}
+			this->position = p + n;
+		}
+
+		uint8_t *frame;
+		int size;
+		int planes;
+
+		// number of bytes per plane
+		int count;
+
+		// position in plane order
+		int position = 0;
+
+		// state of the current token and number of remaining bytes
+		State state = State::TOKEN;
+		int remaining = 0;
+	};
+
+	/**
+		Decode a frame
+		@param src encoded frame
+		@param frame frame that contains the reference frame, gets modified in place
+		@param planes number of planes, same as for encoding
+		@return true if successful, false if the encoded data is invalid
+	*/
+	static bool decode(std::span<const uint8_t> src, std::span<uint8_t> frame, int planes = 1) {
+		Decoder decoder(frame, planes);
+		return decoder.decode(src) && decoder.complete();
+	}
+};
+
+} // namespace coco
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "FrameStatistics.hpp"
+#include <coco/Frequency.hpp>
+#include <coco/Loop.hpp>
+
+
+namespace coco {
+
+/**
+	Frame scheduler for a fixed frame rate on top of the event loop. The frame slots are on a fixed grid starting at the
+	first frame, so that the output does not drift against e.g. audio or video. A frame that starts too late does not
+	shift the following slots, slots that have passed entirely get skipped and counted as missed.
+
+	Usage:
+		FrameScheduler scheduler(loop, 16667us);
+		while (true) {
+			co_await scheduler.untilFrame();
+			scheduler.beginFrame();
+			// render LED data and start the transfer (e.g. strip.show())
+			scheduler.endFrame();
+			...
+		}
+
+	All times of the statistics are in microseconds.
+*/
+class FrameScheduler {
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param period frame period, e.g. 16667us for 60 frames/s
+	*/
+	FrameScheduler(Loop &loop, Microseconds<> period) : loop(loop), period(period) {}
+
+	/**
+		Wait until the next frame slot (like vsync of a display)
+		@return use co_await on return value to await the next frame slot
+	*/
+	[[nodiscard]] auto untilFrame() {
+		auto now = this->loop.now();
+		if (!this->running) {
+			// first frame slot is now
+			this->slot = now;
+			this->running = true;
+		} else {
+			this->slot += this->period;
+
+			// skip slots that have passed entirely, e.g. when rendering took longer than the frame period
+			int late = (now - this->slot) / 1us;
+			if (late >= this->period.value) {
+				int skip = late / this->period.value;
+				this->slot += this->period * skip;
+				this->missed += skip;
+			}
+		}
+		return this->loop.sleep(this->slot);
+	}
+
+	/**
+		Begin a frame after untilFrame(), records frame time and jitter
+	*/
+	void beginFrame() {
+		auto now = this->loop.now();
+		if (this->frameCount > 0)
+			this->frameTime.add((now - this->frameStart) / 1us);
+		this->jitter.add((now - this->slot) / 1us);
+		this->frameStart = now;
+		++this->frameCount;
+	}
+
+	/**
+		End a frame after rendering and starting the transfer, records render time which includes the time for encoding
+		in start() of the buffer (e.g. for cached buffers)
+	*/
+	void endFrame() {
+		this->renderTime.add((this->loop.now() - this->frameStart) / 1us);
+	}
+
+	/**
+		Clear the statistics, the frame slots stay on the same grid
+	*/
+	void resetStatistics() {
+		this->frameTime.reset();
+		this->renderTime.reset();
+		this->jitter.reset();
+		this->missed = 0;
+	}
+
+	// time between the beginning of two successive frames
+	FrameStatistics frameTime;
+
+	// time between beginFrame() and endFrame()
+	FrameStatistics renderTime;
+
+	// delay of beginFrame() after the frame slot
+	FrameStatistics jitter;
+
+	// number of skipped frame slots
+	int missed = 0;
+
+protected:
+	Loop &loop;
+	Microseconds<> period;
+
+	// true after the first frame slot
+	bool running = false;
+
+	// number of frames
+	int frameCount = 0;
+
+	// current frame slot
+	Loop::Time slot;
+
+	// time of beginFrame()
+	Loop::Time frameStart;
+};
+
+} // namespace coco
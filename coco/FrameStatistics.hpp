@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+
+namespace coco {
+
+/**
+	Minimum, average and maximum of a time that gets measured once per frame, e.g. frame time or render time
+*/
+struct FrameStatistics {
+	// number of measurements
+	int count = 0;
+
+	// minimum and maximum time, e.g. in microseconds
+	int min = 0;
+	int max = 0;
+
+	// sum of all times for the average
+	int64_t sum = 0;
+
+	/**
+		Add a measurement
+		@param time measured time
+	*/
+	void add(int time) {
+		if (this->count == 0) {
+			this->min = time;
+			this->max = time;
+		} else {
+			this->min = std::min(this->min, time);
+			this->max = std::max(this->max, time);
+		}
+		++this->count;
+		this->sum += time;
+	}
+
+	/**
+		Get the average time
+		@return average time, 0 if there are no measurements
+	*/
+	int average() const {
+		return this->count == 0 ? 0 : int(this->sum / this->count);
+	}
+
+	/**
+		Clear all measurements
+	*/
+	void reset() {
+		*this = {};
+	}
+};
+
+} // namespace coco
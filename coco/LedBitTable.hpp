@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+
+namespace coco {
+
+/**
+	Symbol pattern that represents one LED bit on the data line, the MSB gets sent first.
+	For example a WS2812 zero bit is 0b100 and a one bit is 0b110 when the bit time is divided into 3 parts.
+*/
+struct LedSymbols {
+	// number of line bits per LED bit
+	int bitCount;
+
+	// line bits for a LED zero bit
+	uint32_t zero;
+
+	// line bits for a LED one bit
+	uint32_t one;
+
+	// get the symbol for a LED bit
+	constexpr uint32_t operator [](int bit) const {return bit ? this->one : this->zero;}
+};
+
+namespace symbols {
+
+// 3 bits per LED bit (T = 1125ns: T0H = 375ns, T1H = 750ns), e.g. WS2812B
+constexpr LedSymbols WS2812_3 = {3, 0b100, 0b110};
+
+// 4 bits per LED bit (T = 1200ns: T0H = 300ns, T1H = 600ns), e.g. SK6812
+constexpr LedSymbols SK6812_4 = {4, 0b1000, 0b1100};
+
+// 4 bits per LED bit (T = 1250ns: T0H = 312ns, T1H = 937ns) for SPI at 3.2MHz
+constexpr LedSymbols SPI_4 = {4, 0b1000, 0b1110};
+
+// 8 bits per LED bit (T = 1250ns: T0H = 312ns, T1H = 781ns) for SPI at 6.4MHz
+constexpr LedSymbols SPI_8 = {8, 0b11000000, 0b11111000};
+
+} // namespace symbols
+
+
+/**
+	Generate a lookup table that converts DATA_BITS LED bits into a continuous bit sequence of symbols, MSB first.
+	This is for peripherals that shift out the data MSB first without framing, e.g. I2S or SPI.
+	Usage: constexpr auto table = makeBitTable<uint32_t, 8, symbols::WS2812_3>();
+	@tparam T type of table entry
+	@tparam DATA_BITS number of LED bits per table entry, the table has 2^DATA_BITS entries
+	@tparam S symbol pattern
+*/
+template <typename T, int DATA_BITS, LedSymbols S>
+constexpr std::array<T, 1 << DATA_BITS> makeBitTable() {
+	static_assert(DATA_BITS * S.bitCount <= sizeof(T) * 8, "table entry too small");
+
+	std::array<T, 1 << DATA_BITS> table = {};
+	for (int j = 0; j < (1 << DATA_BITS); ++j) {
+		T entry = 0;
+		for (int i = DATA_BITS - 1; i >= 0; --i) {
+			entry = (entry << S.bitCount) | S[(j >> i) & 1];
+		}
+		table[j] = entry;
+	}
+	return table;
+}
+
+/**
+	Generate a lookup table that converts DATA_BITS LED bits into UART frames with inverted data and output. The start
+	bit, FRAME_BITS data bits and the stop bit of one frame form a sequence of symbols. Therefore the symbols have to
+	start with 1 (inverted start bit) and end with 0 (inverted stop bit) and the frame has to hold a whole number of
+	symbols. Each frame occupies one byte of a table entry, the first frame is in the lowest byte.
+	Usage: constexpr auto table = makeUartBitTable<uint16_t, 6, 7, symbols::WS2812_3>();
+	@tparam T type of table entry
+	@tparam DATA_BITS number of LED bits per table entry, the table has 2^DATA_BITS entries
+	@tparam FRAME_BITS number of data bits of a UART frame, e.g. 7
+	@tparam S symbol pattern
+*/
+template <typename T, int DATA_BITS, int FRAME_BITS, LedSymbols S>
+constexpr std::array<T, 1 << DATA_BITS> makeUartBitTable() {
+	constexpr int frameLength = FRAME_BITS + 2;
+	constexpr int frameCount = DATA_BITS * S.bitCount / frameLength;
+	static_assert(frameLength % S.bitCount == 0, "frame must hold a whole number of symbols");
+	static_assert(frameCount * frameLength == DATA_BITS * S.bitCount, "table entry must hold a whole number of frames");
+	static_assert(frameCount <= sizeof(T), "table entry too small");
+	static_assert((S.zero >> (S.bitCount - 1)) == 1 && (S.one >> (S.bitCount - 1)) == 1, "symbols must start with 1");
+	static_assert((S.zero & 1) == 0 && (S.one & 1) == 0, "symbols must end with 0");
+
+	std::array<T, 1 << DATA_BITS> table = {};
+	for (int j = 0; j < (1 << DATA_BITS); ++j) {
+		T entry = 0;
+		for (int k = 0; k < frameCount; ++k) {
+			// data bits of the frame, transmitted LSB first after the start bit
+			int frame = 0;
+			for (int b = 0; b < FRAME_BITS; ++b) {
+				// index of line bit in the sequence of symbols
+				int index = k * frameLength + 1 + b;
+				int bit = DATA_BITS - 1 - index / S.bitCount;
+				int symbol = S[(j >> bit) & 1];
+				frame |= ((symbol >> (S.bitCount - 1 - index % S.bitCount)) & 1) << b;
+			}
+			entry |= T(frame) << (k * 8);
+		}
+		table[j] = entry;
+	}
+	return table;
+}
+
+} // namespace coco
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <vector>
+
+
+namespace coco {
+
+/**
+	Capture of LED strip frames with timestamps, e.g. to run effects headless on a CI machine and compare the output
+	against a reference capture. The capture consists of a header followed by one record per frame that contains only
+	the pixels that changed since the previous frame as spans of consecutive pixels. Records are aligned to 4 bytes.
+
+	Layout:
+	LedCapture::Header
+	for each frame:
+		LedCapture::Frame
+		for each span:
+			LedCapture::Span
+			pixel data of the span, padded to 4 bytes
+*/
+namespace LedCapture {
+	// "LEDC" in little endian
+	constexpr uint32_t MAGIC = 0x4344454c;
+	constexpr int VERSION = 1;
+
+	struct Header {
+		uint32_t magic;
+		uint16_t version;
+
+		// size of a pixel in bytes, e.g. 3 for RGB
+		uint16_t pixelSize;
+	};
+
+	struct Frame {
+		// size of the record including this header in bytes
+		uint32_t size;
+
+		// number of pixels of the frame
+		uint32_t length;
+
+		// time in microseconds since the first frame
+		int64_t time;
+	};
+
+	struct Span {
+		// index of the first pixel
+		uint32_t offset;
+
+		// number of pixels
+		uint32_t count;
+	};
+
+	// a new span gets started only if at least this number of bytes is unchanged, otherwise the unchanged pixels are
+	// included in the current span as this is smaller than a new span header with padding
+	constexpr int MIN_GAP = sizeof(Span) + 3;
+
+	/**
+		Maximum size of a frame record
+		@param length number of pixels
+		@param pixelSize size of a pixel in bytes
+		@return size in bytes
+	*/
+	constexpr int maxFrameSize(int length, int pixelSize) {
+		return sizeof(Frame) + sizeof(Span) + ((length * pixelSize + 3) & ~3);
+	}
+
+	/**
+		Encode a frame record containing the pixels that differ from the previous frame
+		@param previous previous frame
+		@param data current frame
+		@param pixelSize size of a pixel in bytes
+		@param time time of the current frame in microseconds since the first frame
+		@param dst destination, must have space for maxFrameSize() bytes
+		@return size of the record in bytes
+	*/
+	inline int encode(std::span<const uint8_t> previous, std::span<const uint8_t> data, int pixelSize, int64_t time,
+		uint8_t *dst)
+	{
+		int length = int(data.size()) / pixelSize;
+
+		// pixels beyond the end of the previous frame are always changed
+		int commonLength = std::min(length, int(previous.size()) / pixelSize);
+		auto changed = [&](int i) {
+			return i >= commonLength
+				|| std::memcmp(previous.data() + i * pixelSize, data.data() + i * pixelSize, pixelSize) != 0;
+		};
+
+		int size = sizeof(Frame);
+		int i = 0;
+		while (true) {
+			// find start of span
+			while (i < length && !changed(i))
+				++i;
+			if (i >= length)
+				break;
+			int begin = i;
+
+			// find end of span, continue over short gaps of unchanged pixels
+			int end = ++i;
+			while (i < length) {
+				if (changed(i)) {
+					end = ++i;
+				} else if ((i + 1 - end) * pixelSize >= MIN_GAP) {
+					break;
+				} else {
+					++i;
+				}
+			}
+			i = end;
+
+			// write span
+			Span span = {uint32_t(begin), uint32_t(end - begin)};
+			std::memcpy(dst + size, &span, sizeof(Span));
+			size += sizeof(Span);
+			int spanSize = (end - begin) * pixelSize;
+			std::memcpy(dst + size, data.data() + begin * pixelSize, spanSize);
+			std::memset(dst + size + spanSize, 0, -spanSize & 3);
+			size += (spanSize + 3) & ~3;
+		}
+
+		Frame frame = {uint32_t(size), uint32_t(length), time};
+		std::memcpy(dst, &frame, sizeof(Frame));
+		return size;
+	}
+
+	/**
+		Writer for a capture. Derived classes provide the storage, e.g. LedRecorder writes to a memory mapped file
+	*/
+	class Writer {
+	public:
+		/**
+			Constructor
+			@param pixelSize size of a pixel in bytes, e.g. 3 for RGB
+		*/
+		Writer(int pixelSize) : pixelSize(pixelSize) {}
+
+		virtual ~Writer() {}
+
+		/**
+			Add a frame to the capture
+			@param data LED data of the frame
+			@param time time in microseconds, only the difference to the first frame gets stored
+			@return true if successful, false if there is no space
+		*/
+		bool add(std::span<const uint8_t> data, int64_t time) {
+			int headerSize = this->frameCount == 0 ? sizeof(Header) : 0;
+			uint8_t *dst = reserve(headerSize + maxFrameSize(int(data.size()) / this->pixelSize, this->pixelSize));
+			if (dst == nullptr)
+				return false;
+
+			if (this->frameCount == 0) {
+				Header header = {MAGIC, VERSION, uint16_t(this->pixelSize)};
+				std::memcpy(dst, &header, sizeof(Header));
+				this->startTime = time;
+			}
+			int size = headerSize + encode(this->previous, data, this->pixelSize, time - this->startTime,
+				dst + headerSize);
+			commit(size);
+
+			this->previous.assign(data.begin(), data.end());
+			++this->frameCount;
+			return true;
+		}
+
+		// number of frames in the capture
+		int frameCount = 0;
+
+	protected:
+		/**
+			Reserve space at the end of the capture
+			@param size size in bytes
+			@return pointer to the space or nullptr if there is no space
+		*/
+		virtual uint8_t *reserve(int size) = 0;
+
+		/**
+			Append reserved space to the capture
+			@param size number of bytes that were written, at most the reserved size
+		*/
+		virtual void commit(int size) = 0;
+
+		int pixelSize;
+		int64_t startTime = 0;
+
+		// previous frame for finding the changed pixels
+		std::vector<uint8_t> previous;
+	};
+
+	/**
+		Reader for a capture, works directly on the capture data, e.g. a memory mapped file or flash memory.
+		Usage: while (reader.next()) reader.apply(frame);
+	*/
+	class Reader {
+	public:
+		// the frames contain only the changed pixels, therefore every frame has to be applied (see LedPlayer)
+		static constexpr bool DIFFERENCES = true;
+
+		Reader() = default;
+
+		/**
+			Constructor
+			@param data capture data, an empty or invalid capture contains no frames
+		*/
+		Reader(std::span<const uint8_t> data) : data(data) {
+			Header header;
+			if (data.size() >= sizeof(Header)) {
+				std::memcpy(&header, data.data(), sizeof(Header));
+				if (header.magic == MAGIC && header.version == VERSION && header.pixelSize > 0) {
+					this->pixelSize = header.pixelSize;
+					this->nextOffset = sizeof(Header);
+				}
+			}
+		}
+
+		/**
+			Check if the capture has a valid header
+		*/
+		bool valid() const {return this->pixelSize > 0;}
+
+		/**
+			Advance to the next frame
+			@return true if successful, false at the end of the capture or if the next record is invalid
+		*/
+		bool next() {
+			if (!valid() || this->nextOffset + sizeof(Frame) > this->data.size())
+				return false;
+			std::memcpy(&this->frame, this->data.data() + this->nextOffset, sizeof(Frame));
+			if (this->frame.size < sizeof(Frame) || this->frame.size > this->data.size() - this->nextOffset)
+				return false;
+			this->frameOffset = this->nextOffset;
+			this->nextOffset += this->frame.size;
+			return true;
+		}
+
+		/**
+			Apply the changed pixels of the current frame to a frame that contains the previous frame
+			@param frame frame data, pixels beyond its size get ignored
+			@param offset index of the first pixel of the frame data, e.g. to play one part of the capture on each of
+				several LED strips
+		*/
+		void apply(std::span<uint8_t> frame, int offset = 0) const {
+			int pixelSize = this->pixelSize;
+			int frameBegin = offset;
+			int frameEnd = offset + int(frame.size()) / pixelSize;
+			const uint8_t *src = this->data.data() + this->frameOffset + sizeof(Frame);
+			const uint8_t *end = this->data.data() + this->frameOffset + this->frame.size;
+			while (src + sizeof(Span) <= end) {
+				Span span;
+				std::memcpy(&span, src, sizeof(Span));
+				src += sizeof(Span);
+				int count = std::min(int(span.count), int(end - src) / pixelSize);
+
+				// copy the part of the span that is inside the frame
+				int begin = std::max(int(span.offset), frameBegin);
+				int spanEnd = std::min(int(span.offset) + count, frameEnd);
+				if (begin < spanEnd) {
+					std::memcpy(frame.data() + (begin - frameBegin) * pixelSize,
+						src + (begin - int(span.offset)) * pixelSize, (spanEnd - begin) * pixelSize);
+				}
+				src += (count * pixelSize + 3) & ~3;
+			}
+		}
+
+		/**
+			Get the number of pixels of the current frame
+		*/
+		int length() const {return this->frame.length;}
+
+		/**
+			Get the time of the current frame
+			@return time in microseconds since the first frame
+		*/
+		int64_t time() const {return this->frame.time;}
+
+		// size of a pixel in bytes, 0 if the capture is invalid
+		int pixelSize = 0;
+
+	protected:
+		std::span<const uint8_t> data;
+
+		// offset of current and next frame record
+		size_t frameOffset = 0;
+		size_t nextOffset = 0;
+
+		// header of current frame
+		Frame frame = {};
+	};
+
+	/**
+		Compare the frames of two captures, e.g. a capture of an effect against a reference capture. The timestamps
+		are ignored
+		@param a first capture
+		@param b second capture
+		@param tolerance maximum allowed difference of a byte, e.g. 1 to allow for rounding
+		@return index of the first frame that differs, -1 if the captures are equal
+	*/
+	inline int compare(std::span<const uint8_t> a, std::span<const uint8_t> b, int tolerance = 0) {
+		Reader readerA(a);
+		Reader readerB(b);
+		if (readerA.pixelSize != readerB.pixelSize)
+			return 0;
+		std::vector<uint8_t> frameA;
+		std::vector<uint8_t> frameB;
+		int index = 0;
+		while (true) {
+			bool hasA = readerA.next();
+			bool hasB = readerB.next();
+			if (!hasA && !hasB)
+				return -1;
+			if (hasA != hasB || readerA.length() != readerB.length())
+				return index;
+			frameA.resize(readerA.length() * readerA.pixelSize);
+			frameB.resize(frameA.size());
+			readerA.apply(frameA);
+			readerB.apply(frameB);
+			for (size_t i = 0; i < frameA.size(); ++i) {
+				if (std::abs(frameA[i] - frameB[i]) > tolerance)
+					return index;
+			}
+			++index;
+		}
+	}
+}
+
+} // namespace coco
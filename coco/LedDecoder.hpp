@@ -0,0 +1,247 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+
+namespace coco {
+
+/**
+	Timing specification of a LED chip, all times in ns
+*/
+struct LedTiming {
+	// high time of a zero bit
+	double t0hMin;
+	double t0hMax;
+
+	// high time of a one bit
+	double t1hMin;
+	double t1hMax;
+
+	// low time of a zero bit
+	double t0lMin;
+	double t0lMax;
+
+	// low time of a one bit
+	double t1lMin;
+	double t1lMax;
+
+	// minimum low time that latches the data
+	double resetMin;
+};
+
+namespace timings {
+
+// WS2812B (T0H = 400ns, T1H = 800ns, T0L = 850ns, T1L = 450ns, +-150ns, TRESET >= 50us)
+constexpr LedTiming WS2812B = {250, 550, 650, 950, 700, 1000, 300, 600, 50000};
+
+// SK6812 (T0H = 300ns, T1H = 600ns, T0L = 900ns, T1L = 600ns, +-150ns, TRESET >= 80us)
+constexpr LedTiming SK6812 = {150, 450, 450, 750, 750, 1050, 450, 750, 80000};
+
+// WS2813 (T0H = 300ns - 450ns, T1H = 750ns - 1000ns, TxL = 300ns - 100us, TRESET >= 300us)
+constexpr LedTiming WS2813 = {300, 450, 750, 1000, 300, 100000, 300, 100000, 300000};
+
+} // namespace timings
+
+
+/**
+	Line level over time, run length encoded. Reconstructs the waveform from the data that a peripheral shifts out, e.g.
+	the words produced by the encoders in LedEncoder.hpp.
+*/
+class LedWaveform {
+public:
+	// a time span of constant level
+	struct Pulse {
+		bool level;
+
+		// duration in ns
+		double duration;
+	};
+
+	void clear() {this->pulses.clear();}
+
+	/**
+		Append a constant level
+		@param level line level
+		@param duration duration in ns
+	*/
+	void append(bool level, double duration) {
+		if (!this->pulses.empty() && this->pulses.back().level == level)
+			this->pulses.back().duration += duration;
+		else
+			this->pulses.push_back({level, duration});
+	}
+
+	/**
+		Append bits of a word, MSB first
+		@param word word to append
+		@param bitCount number of bits of the word
+		@param bitTime duration of one bit in ns
+	*/
+	void appendBits(uint32_t word, int bitCount, double bitTime) {
+		for (int i = bitCount - 1; i >= 0; --i)
+			append((word >> i) & 1, bitTime);
+	}
+
+	/**
+		Append 24 bit words as shifted out by the nrf52 I2S peripheral, e.g. of LedEncoder_I2S
+		@param words words to append
+		@param bitTime duration of one bit in ns
+	*/
+	void appendI2S(std::span<const uint32_t> words, double bitTime) {
+		for (uint32_t word : words)
+			appendBits(word, 24, bitTime);
+	}
+
+	/**
+		Append bytes as shifted out by a SPI peripheral, e.g. of LedEncoder_SPI
+		@param bytes bytes to append
+		@param bitTime duration of one bit in ns
+	*/
+	void appendSPI(std::span<const uint8_t> bytes, double bitTime) {
+		for (uint8_t byte : bytes)
+			appendBits(byte, 8, bitTime);
+	}
+
+	/**
+		Append UART frames with inverted data and output, e.g. of LedEncoder_UART
+		@param frames frames to append, one frame per byte
+		@param dataBits number of data bits per frame, e.g. 7
+		@param bitTime duration of one bit in ns
+	*/
+	void appendUART(std::span<const uint8_t> frames, int dataBits, double bitTime) {
+		for (uint8_t frame : frames) {
+			// inverted start bit, data bits LSB first (inverted twice), inverted stop bit
+			append(true, bitTime);
+			for (int i = 0; i < dataBits; ++i)
+				append((frame >> i) & 1, bitTime);
+			append(false, bitTime);
+		}
+	}
+
+	/**
+		Append one strip of words as written to a GPIO port, e.g. of LedEncoder_Parallel
+		@param words words to append, one word per time slot
+		@param strip index of the strip, i.e. bit index in the words
+		@param slotTime duration of one word in ns
+	*/
+	template <typename T>
+	void appendParallel(std::span<const T> words, int strip, double slotTime) {
+		for (T word : words)
+			append((word >> strip) & 1, slotTime);
+	}
+
+	std::vector<Pulse> pulses;
+};
+
+
+/**
+	Decoder that converts a waveform back into LED data and checks the timing against a LED chip specification.
+*/
+struct LedDecoder {
+	// range of measured times in ns
+	struct Range {
+		double min = std::numeric_limits<double>::infinity();
+		double max = 0;
+
+		void add(double value) {
+			if (value < this->min)
+				this->min = value;
+			if (value > this->max)
+				this->max = value;
+		}
+	};
+
+	// data between two resets
+	struct Frame {
+		std::vector<uint8_t> data;
+
+		// number of LED bits, data contains only complete bytes
+		int bitCount = 0;
+
+		// low time after the data in ns
+		double resetTime = 0;
+	};
+
+	struct Result {
+		std::vector<Frame> frames;
+
+		// number of pulses that violate the timing specification
+		int errorCount = 0;
+
+		// measured times
+		Range t0h;
+		Range t1h;
+		Range t0l;
+		Range t1l;
+		Range reset;
+	};
+
+	/**
+		Decode a waveform. Leading low level is ignored, a frame ends at a low time of at least resetMin or at the end
+		of the waveform
+		@param waveform waveform to decode
+		@param timing timing specification of the LED chip
+		@return decoded frames and timing check result
+	*/
+	static Result decode(const LedWaveform &waveform, const LedTiming &timing) {
+		Result result;
+		auto &pulses = waveform.pulses;
+		int count = pulses.size();
+
+		// high times above the threshold are one bits
+		double threshold = (timing.t0hMax + timing.t1hMin) * 0.5;
+
+		int i = (count > 0 && !pulses[0].level) ? 1 : 0;
+		bool inFrame = false;
+		int byte = 0;
+		for (; i < count; i += 2) {
+			if (!inFrame) {
+				result.frames.emplace_back();
+				inFrame = true;
+				byte = 0;
+			}
+			auto &frame = result.frames.back();
+
+			// high time determines the bit
+			double high = pulses[i].duration;
+			int bit = high >= threshold ? 1 : 0;
+			if (bit == 0) {
+				result.t0h.add(high);
+				if (high < timing.t0hMin || high > timing.t0hMax)
+					++result.errorCount;
+			} else {
+				result.t1h.add(high);
+				if (high < timing.t1hMin || high > timing.t1hMax)
+					++result.errorCount;
+			}
+			byte = (byte << 1) | bit;
+			++frame.bitCount;
+			if ((frame.bitCount & 7) == 0)
+				frame.data.push_back(byte);
+
+			// low time is either part of the bit or a reset, the last low time is always a reset
+			double low = i + 1 < count ? pulses[i + 1].duration : 0;
+			if (low >= timing.resetMin || i + 2 >= count) {
+				frame.resetTime = low;
+				result.reset.add(low);
+				if (low < timing.resetMin)
+					++result.errorCount;
+				inFrame = false;
+			} else if (bit == 0) {
+				result.t0l.add(low);
+				if (low < timing.t0lMin || low > timing.t0lMax)
+					++result.errorCount;
+			} else {
+				result.t1l.add(low);
+				if (low < timing.t1lMin || low > timing.t1lMax)
+					++result.errorCount;
+			}
+		}
+		return result;
+	}
+};
+
+} // namespace coco
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace coco {
+
+/**
+	Temporal dithering of LED data with 16 bit channels to the 8 bit channels of the LED strip. Each channel keeps the
+	fraction that got lost when reducing to 8 bits in an accumulator and adds it to the next frame, therefore the
+	average over successive frames equals the 16 bit value. This removes banding at low brightness where 8 bits are
+	too coarse. The encoders update the accumulators while encoding, so the LED data gets read only once per frame.
+	The 16 bit channels are stored MSB first, the same as for PixelFormat, so a frame looks the same on all drivers.
+	Instantiate LedDither_Buffer which contains the accumulators.
+*/
+struct LedDither {
+	// accumulator for each channel, contains the fraction that was not sent yet
+	uint8_t *residual;
+
+	// number of channels
+	int capacity;
+
+	/**
+		Constructor
+		@param residual accumulator for each channel
+		@param capacity number of channels
+	*/
+	LedDither(uint8_t *residual, int capacity) : residual(residual), capacity(capacity) {
+		reset();
+	}
+
+	/**
+		Reset the accumulators. They start with different values so that channels with the same value don't change at
+		the same frame which would be visible as flicker
+	*/
+	void reset() {
+		for (int i = 0; i < this->capacity; ++i)
+			this->residual[i] = uint8_t(i * 159);
+	}
+
+	/**
+		Reduce a 16 bit value to 8 bit and update the accumulator
+		@param value 16 bit value
+		@param residual accumulator of the channel
+		@return 8 bit value
+	*/
+	static uint8_t next(uint16_t value, uint8_t &residual) {
+		// scale to 0 - 255 * 256 so that the result does not overflow
+		int x = value - (value >> 8) + residual;
+		residual = uint8_t(x);
+		return uint8_t(x >> 8);
+	}
+
+	/**
+		Reader for dithered bytes of LED data
+	*/
+	struct Reader {
+		const uint8_t *value;
+		uint8_t *residual;
+
+		uint8_t next() {
+			auto value = this->value;
+			this->value = value + 2;
+			return LedDither::next((value[0] << 8) | value[1], *this->residual++);
+		}
+	};
+
+	/**
+		Get a reader for dithered bytes of LED data
+		@param data LED data with 16 bit channels, MSB first
+		@param index index of first channel to read
+	*/
+	Reader reader(const uint8_t *data, int index) const {
+		return {data + index * 2, this->residual + index};
+	}
+};
+
+/**
+	Temporal dithering with accumulators.
+	@tparam C number of channels, e.g. 900 for 300 RGB LEDs
+*/
+template <int C>
+struct LedDither_Buffer : public LedDither {
+	LedDither_Buffer() : LedDither(data, C) {}
+
+	uint8_t data[C];
+};
+
+} // namespace coco
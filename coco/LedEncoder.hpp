@@ -0,0 +1,629 @@
+#pragma once
+
+#include "LedBitTable.hpp"
+#include "LedDither.hpp"
+#include "LedTransform.hpp"
+#include "LedTranspose.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+namespace coco {
+
+namespace detail {
+
+// table that converts a byte into 24 bits [1 DATA 0], MSB first
+inline constexpr auto bitTable_I2S = makeBitTable<uint32_t, 8, symbols::WS2812_3>();
+
+// table that converts 6 LED bits into two 7N1 UART frames with inverted data and output
+inline constexpr auto bitTable_UART = makeUartBitTable<uint16_t, 6, 7, symbols::WS2812_3>();
+
+/*
+	Vectorized 8 bit to 24 bit [1 DATA 0] expansion for hosts, bit-exact with bitTable_I2S. The bits of each 32 bit lane
+	get spread so that bit i moves to bit 3 * i, then the data is shifted into the middle of the symbols.
+	encodeI2S() converts 16 bytes into 16 words.
+*/
+#if defined(__AVX2__)
+#define COCO_LEDENCODER_SIMD
+inline __m256i spreadI2S(__m256i x) {
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 8)), _mm256_set1_epi32(0x00F00F));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 4)), _mm256_set1_epi32(0x0C30C3));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 2)), _mm256_set1_epi32(0x249249));
+	return _mm256_or_si256(_mm256_slli_epi32(x, 1), _mm256_set1_epi32(0x924924));
+}
+
+// convert 8 bytes into 8 words
+inline __m256i spreadI2S(const uint8_t *src) {
+	return spreadI2S(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src)));
+}
+
+inline void encodeI2S(const uint8_t *src, uint32_t *dst) {
+	_mm256_storeu_si256((__m256i *)dst, spreadI2S(src));
+	_mm256_storeu_si256((__m256i *)(dst + 8), spreadI2S(src + 8));
+}
+#elif defined(__SSE2__)
+#define COCO_LEDENCODER_SIMD
+inline __m128i spreadI2S(__m128i x) {
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 8)), _mm_set1_epi32(0x00F00F));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 4)), _mm_set1_epi32(0x0C30C3));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 2)), _mm_set1_epi32(0x249249));
+	return _mm_or_si128(_mm_slli_epi32(x, 1), _mm_set1_epi32(0x924924));
+}
+
+// convert 4 bytes into 4 words
+inline __m128i spreadI2S(const uint8_t *src) {
+	__m128i zero = _mm_setzero_si128();
+	int32_t value;
+	std::memcpy(&value, src, 4);
+	__m128i x = _mm_cvtsi32_si128(value);
+	return spreadI2S(_mm_unpacklo_epi16(_mm_unpacklo_epi8(x, zero), zero));
+}
+
+inline void encodeI2S(const uint8_t *src, uint32_t *dst) {
+	__m128i zero = _mm_setzero_si128();
+	__m128i x = _mm_loadu_si128((const __m128i *)src);
+	__m128i lo = _mm_unpacklo_epi8(x, zero);
+	__m128i hi = _mm_unpackhi_epi8(x, zero);
+	_mm_storeu_si128((__m128i *)dst, spreadI2S(_mm_unpacklo_epi16(lo, zero)));
+	_mm_storeu_si128((__m128i *)(dst + 4), spreadI2S(_mm_unpackhi_epi16(lo, zero)));
+	_mm_storeu_si128((__m128i *)(dst + 8), spreadI2S(_mm_unpacklo_epi16(hi, zero)));
+	_mm_storeu_si128((__m128i *)(dst + 12), spreadI2S(_mm_unpackhi_epi16(hi, zero)));
+}
+#elif defined(__ARM_NEON)
+#define COCO_LEDENCODER_SIMD
+inline uint32x4_t spreadI2S(uint32x4_t x) {
+	x = vandq_u32(vorrq_u32(x, vshlq_n_u32(x, 8)), vdupq_n_u32(0x00F00F));
+	x = vandq_u32(vorrq_u32(x, vshlq_n_u32(x, 4)), vdupq_n_u32(0x0C30C3));
+	x = vandq_u32(vorrq_u32(x, vshlq_n_u32(x, 2)), vdupq_n_u32(0x249249));
+	return vorrq_u32(vshlq_n_u32(x, 1), vdupq_n_u32(0x924924));
+}
+
+inline void encodeI2S(const uint8_t *src, uint32_t *dst) {
+	uint8x16_t x = vld1q_u8(src);
+	uint16x8_t lo = vmovl_u8(vget_low_u8(x));
+	uint16x8_t hi = vmovl_u8(vget_high_u8(x));
+	vst1q_u32(dst, spreadI2S(vmovl_u16(vget_low_u16(lo))));
+	vst1q_u32(dst + 4, spreadI2S(vmovl_u16(vget_high_u16(lo))));
+	vst1q_u32(dst + 8, spreadI2S(vmovl_u16(vget_low_u16(hi))));
+	vst1q_u32(dst + 12, spreadI2S(vmovl_u16(vget_high_u16(hi))));
+}
+#endif
+} // namespace detail
+
+/*
+	Encoders that convert LED data (e.g. RGB bytes) into the waveform that gets transferred to the LED strip by a
+	peripheral. Each encoder converts blocks of BLOCK_BYTES source bytes into BLOCK_WORDS destination words and has
+	no state, therefore it can be used in interrupt handlers as well as in native code (e.g. for tests and benchmarks).
+	The encode() function converts as much as fits into the destination and returns the number of consumed bytes.
+*/
+
+/**
+	Encoder for I2S where each LED bit is represented by 3 bits [1 DATA 0], MSB first.
+	A byte is converted into a 24 bit word, e.g. for the nRF52 I2S peripheral in 24 bit mode.
+*/
+struct LedEncoder_I2S {
+	using Word = uint32_t;
+
+	static constexpr int BLOCK_BYTES = 1;
+	static constexpr int BLOCK_WORDS = 1;
+
+	/**
+		Get number of words that encode() generates for the given number of bytes
+		@param byteCount number of source bytes
+		@return number of destination words
+	*/
+	static constexpr int wordCount(int byteCount) {return byteCount;}
+
+	/**
+		Encode LED data. Uses SSE2, AVX2 or NEON if available, otherwise encodeTable()
+		@param src source bytes
+		@param dst destination words
+		@return number of source bytes consumed
+	*/
+	static int encode(std::span<const uint8_t> src, std::span<Word> dst) {
+#ifdef COCO_LEDENCODER_SIMD
+		int count = std::min(src.size(), dst.size());
+		int simdCount = count & ~15;
+		auto s = src.data();
+		auto end = s + simdCount;
+		auto d = dst.data();
+		for (; s != end; s += 16, d += 16) {
+			detail::encodeI2S(s, d);
+		}
+		return simdCount + encodeTable(src.subspan(simdCount, count - simdCount), dst.subspan(simdCount));
+#else
+		return encodeTable(src, dst);
+#endif
+	}
+
+	/**
+		Encode LED data using the lookup table, one load per byte
+		@param src source bytes
+		@param dst destination words
+		@return number of source bytes consumed
+	*/
+	static int encodeTable(std::span<const uint8_t> src, std::span<Word> dst) {
+		auto s = src.data();
+		auto end = s + std::min(src.size(), dst.size());
+		auto d = dst.data();
+		for (; s != end; ++s, ++d) {
+			*d = detail::bitTable_I2S[*s];
+		}
+		return end - src.data();
+	}
+
+	/**
+		Encode LED data and apply a color transform, one load per byte and table
+		@param src source bytes
+		@param dst destination words
+		@param transform color transform
+		@param channel channel of the first source byte, i.e. offset of src in the LED data modulo channelCount
+		@return number of source bytes consumed
+	*/
+	static int encode(std::span<const uint8_t> src, std::span<Word> dst, const LedTransform &transform, int channel) {
+		return encode(transform.reader(src.data(), channel), src.size(), dst);
+	}
+
+	/**
+		Encode LED data that is provided by a reader, e.g. LedTransform::Reader or LedDither::Reader
+		@param reader reader whose next() method returns the next source byte
+		@param count number of source bytes
+		@param dst destination words
+		@return number of source bytes consumed
+	*/
+	template <typename R>
+	static int encode(R reader, int count, std::span<Word> dst) {
+		count = std::min(count, int(dst.size()));
+		auto d = dst.data();
+		auto end = d + count;
+		for (; d != end; ++d) {
+			*d = detail::bitTable_I2S[reader.next()];
+		}
+		return count;
+	}
+};
+
+/**
+	Encoder for 7 bit UART (7N1) with inverted data and output where each LED bit is represented by 3 UART bits. The
+	start bit, 7 data bits and stop bit of one UART frame therefore form 3 LED bits. A 16 bit word contains two UART
+	frames, i.e. 6 LED bits, and a block of 3 bytes (one RGB LED) is converted into 4 of these, i.e. two 32 bit words.
+*/
+struct LedEncoder_UART {
+	using Word = uint32_t;
+
+	static constexpr int BLOCK_BYTES = 3;
+	static constexpr int BLOCK_WORDS = 2;
+
+	/**
+		Get number of words that encode() generates for the given number of bytes, the last block may be incomplete
+		@param byteCount number of source bytes
+		@return number of destination words
+	*/
+	static constexpr int wordCount(int byteCount) {
+		return (byteCount + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_WORDS;
+	}
+
+	/**
+		Get number of UART frames (bytes of the destination) that need to be sent for the given number of bytes. This
+		is less than wordCount() * 4 if the last block is incomplete, e.g. for RGBW LEDs with 4 bytes per pixel
+		@param byteCount number of source bytes
+		@return number of UART frames
+	*/
+	static constexpr int frameCount(int byteCount) {
+		return (byteCount * 8 + 2) / 3;
+	}
+
+	/**
+		Encode LED data. If the source size is not a multiple of BLOCK_BYTES, the last block gets padded with zeros
+		@param src source bytes
+		@param dst destination words
+		@return number of source bytes consumed
+	*/
+	static int encode(std::span<const uint8_t> src, std::span<Word> dst) {
+		auto &bitTable = detail::bitTable_UART;
+		int size = src.size();
+		int blockCount = std::min((size + BLOCK_BYTES - 1) / BLOCK_BYTES, int(dst.size()) / BLOCK_WORDS);
+		int fullCount = std::min(blockCount, size / BLOCK_BYTES);
+
+		auto s = src.data();
+		auto end = s + fullCount * BLOCK_BYTES;
+		auto d = dst.data();
+		for (; s != end; s += 3, d += 2) {
+			int a = s[0];
+			int b = s[1];
+			int c = s[2];
+
+			d[0] = bitTable[a >> 2]
+				| (bitTable[((a & 3) << 4) | b >> 4] << 16);
+			d[1] = bitTable[((b & 15) << 2) | c >> 6]
+				| (bitTable[c & 63] << 16);
+		}
+
+		// incomplete last block
+		if (blockCount > fullCount) {
+			int rest = size - fullCount * BLOCK_BYTES;
+			int a = s[0];
+			int b = rest >= 2 ? s[1] : 0;
+
+			d[0] = bitTable[a >> 2]
+				| (bitTable[((a & 3) << 4) | b >> 4] << 16);
+			d[1] = bitTable[(b & 15) << 2]
+				| (bitTable[0] << 16);
+			return size;
+		}
+
+		return fullCount * BLOCK_BYTES;
+	}
+
+	/**
+		Encode LED data and apply a color transform. If the source size is not a multiple of BLOCK_BYTES, the last block
+		gets padded with zeros
+		@param src source bytes
+		@param dst destination words
+		@param transform color transform
+		@param channel channel of the first source byte, i.e. offset of src in the LED data modulo channelCount
+		@return number of source bytes consumed
+	*/
+	static int encode(std::span<const uint8_t> src, std::span<Word> dst, const LedTransform &transform, int channel) {
+		return encode(transform.reader(src.data(), channel), src.size(), dst);
+	}
+
+	/**
+		Encode LED data that is provided by a reader, e.g. LedTransform::Reader or LedDither::Reader. If the count is
+		not a multiple of BLOCK_BYTES, the last block gets padded with zeros
+		@param reader reader whose next() method returns the next source byte
+		@param count number of source bytes
+		@param dst destination words
+		@return number of source bytes consumed
+	*/
+	template <typename R>
+	static int encode(R reader, int count, std::span<Word> dst) {
+		auto &bitTable = detail::bitTable_UART;
+		int blockCount = std::min((count + BLOCK_BYTES - 1) / BLOCK_BYTES, int(dst.size()) / BLOCK_WORDS);
+		int fullCount = std::min(blockCount, count / BLOCK_BYTES);
+
+		auto d = dst.data();
+		auto end = d + fullCount * BLOCK_WORDS;
+		for (; d != end; d += 2) {
+			int a = reader.next();
+			int b = reader.next();
+			int c = reader.next();
+
+			d[0] = bitTable[a >> 2]
+				| (bitTable[((a & 3) << 4) | b >> 4] << 16);
+			d[1] = bitTable[((b & 15) << 2) | c >> 6]
+				| (bitTable[c & 63] << 16);
+		}
+
+		// incomplete last block
+		if (blockCount > fullCount) {
+			int rest = count - fullCount * BLOCK_BYTES;
+			int a = reader.next();
+			int b = rest >= 2 ? reader.next() : 0;
+
+			d[0] = bitTable[a >> 2]
+				| (bitTable[((a & 3) << 4) | b >> 4] << 16);
+			d[1] = bitTable[(b & 15) << 2]
+				| (bitTable[0] << 16);
+			return count;
+		}
+
+		return fullCount * BLOCK_BYTES;
+	}
+};
+
+/**
+	Encoder for SPI where each LED bit is represented by N bits, MSB first. The output is a byte stream for an SPI
+	peripheral with 8 bit data size.
+	@tparam N number of SPI bits per LED bit
+*/
+template <int N>
+struct LedEncoder_SPI;
+
+/**
+	Encoder for SPI with 3 bits [100] or [110] per LED bit, e.g. at 2.4MHz SPI clock. This is the same waveform as
+	LedEncoder_I2S but packed into 3 bytes per source byte, e.g. for spidev on Linux. Uses AVX2 or SSSE3 if available.
+*/
+template <>
+struct LedEncoder_SPI<3> {
+	using Word = uint8_t;
+
+	static constexpr int BLOCK_BYTES = 1;
+	static constexpr int BLOCK_WORDS = 3;
+
+	static constexpr int wordCount(int byteCount) {return byteCount * BLOCK_WORDS;}
+
+	static int encode(std::span<const uint8_t> src, std::span<Word> dst) {
+		int count = std::min(src.size(), dst.size() / BLOCK_WORDS);
+		auto s = src.data();
+		auto end = s + count;
+		auto d = dst.data();
+#if defined(__AVX2__) || defined(__SSSE3__)
+		// convert 4 words into 12 big endian bytes per 128 bit lane, the stores write 4 extra bytes
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+#if defined(__AVX2__)
+		auto end8 = s + (std::max(count - 2, 0) & ~7);
+		for (; s != end8; s += 8, d += 24) {
+			__m256i x = _mm256_shuffle_epi8(detail::spreadI2S(s), _mm256_broadcastsi128_si256(shuffle));
+			_mm_storeu_si128((__m128i *)d, _mm256_castsi256_si128(x));
+			_mm_storeu_si128((__m128i *)(d + 12), _mm256_extracti128_si256(x, 1));
+		}
+#else
+		auto end4 = s + (std::max(count - 2, 0) & ~3);
+		for (; s != end4; s += 4, d += 12) {
+			_mm_storeu_si128((__m128i *)d, _mm_shuffle_epi8(detail::spreadI2S(s), shuffle));
+		}
+#endif
+#endif
+		for (; s != end; ++s, d += 3) {
+			uint32_t w = detail::bitTable_I2S[*s];
+			d[0] = w >> 16;
+			d[1] = w >> 8;
+			d[2] = w;
+		}
+		return count;
+	}
+};
+
+/**
+	Encoder for SPI with 4 bits [1000] or [1110] per LED bit, e.g. at 3.2MHz SPI clock.
+	A byte is converted into 4 bytes.
+*/
+template <>
+struct LedEncoder_SPI<4> {
+	using Word = uint8_t;
+
+	static constexpr int BLOCK_BYTES = 1;
+	static constexpr int BLOCK_WORDS = 4;
+
+	// table that converts two LED bits into one SPI byte
+	static constexpr auto bitTable = makeBitTable<uint8_t, 2, symbols::SPI_4>();
+
+	static constexpr int wordCount(int byteCount) {return byteCount * BLOCK_WORDS;}
+
+	static int encode(std::span<const uint8_t> src, std::span<Word> dst) {
+		auto s = src.data();
+		auto end = s + std::min(src.size(), dst.size() / BLOCK_WORDS);
+		auto d = dst.data();
+		for (; s != end; ++s, d += 4) {
+			int a = *s;
+			d[0] = bitTable[a >> 6];
+			d[1] = bitTable[(a >> 4) & 3];
+			d[2] = bitTable[(a >> 2) & 3];
+			d[3] = bitTable[a & 3];
+		}
+		return end - src.data();
+	}
+};
+
+/**
+	Encoder for SPI with 8 bits [11000000] or [11111000] per LED bit, e.g. at 6.4MHz SPI clock.
+	A byte is converted into 8 bytes.
+*/
+template <>
+struct LedEncoder_SPI<8> {
+	using Word = uint8_t;
+
+	static constexpr int BLOCK_BYTES = 1;
+	static constexpr int BLOCK_WORDS = 8;
+
+	// symbols for a zero and a one bit
+	static constexpr int ZERO = symbols::SPI_8.zero;
+	static constexpr int ONE = symbols::SPI_8.one;
+
+	static constexpr int wordCount(int byteCount) {return byteCount * BLOCK_WORDS;}
+
+	static int encode(std::span<const uint8_t> src, std::span<Word> dst) {
+		auto s = src.data();
+		auto end = s + std::min(src.size(), dst.size() / BLOCK_WORDS);
+		auto d = dst.data();
+		for (; s != end; ++s, d += 8) {
+			int a = *s;
+			for (int i = 0; i < 8; ++i) {
+				d[i] = (a & (0x80 >> i)) ? ONE : ZERO;
+			}
+		}
+		return end - src.data();
+	}
+};
+
+/**
+	Encoder for N LED strips in parallel on a GPIO port, e.g. driven by a timer triggered DMA. Each LED bit is
+	represented by 3 words [1 DATA 0] where bit i of a word is the level of strip i. The data of the strips gets
+	bit-sliced using transpose8x8() or transpose16x16(), a byte of each strip is converted into 24 words.
+	@tparam N number of strips, 8 or 16
+*/
+template <int N>
+struct LedEncoder_Parallel {
+	static_assert(N == 8 || N == 16, "number of strips must be 8 or 16");
+	using Word = std::conditional_t<N == 8, uint8_t, uint16_t>;
+
+	// one byte of each strip
+	static constexpr int BLOCK_BYTES = 1;
+	static constexpr int BLOCK_WORDS = 24;
+
+	// level of all strips
+	static constexpr Word ONES = Word(~0);
+
+	/**
+		Get number of words that encode() generates for the given number of bytes per strip
+		@param byteCount number of source bytes per strip
+		@return number of destination words
+	*/
+	static constexpr int wordCount(int byteCount) {return byteCount * BLOCK_WORDS;}
+
+	/**
+		Encode LED data of N strips
+		@param src source bytes of the first strip, strip i starts at src + i * stride
+		@param stride distance between the strips in bytes
+		@param count number of bytes per strip
+		@param dst destination words
+		@return number of source bytes per strip consumed
+	*/
+	static int encode(const uint8_t *src, int stride, int count, std::span<Word> dst) {
+		count = std::min(count, int(dst.size()) / BLOCK_WORDS);
+		auto d = dst.data();
+		int i = 0;
+		if constexpr (N == 16) {
+			// transpose two bytes of each strip at once
+			for (; i + 2 <= count; i += 2, d += 48) {
+				uint16_t rows[16];
+				uint16_t bits[16];
+				for (int j = 0; j < 16; ++j) {
+					auto s = src + j * stride + i;
+					rows[j] = (s[0] << 8) | s[1];
+				}
+				transpose16x16(rows, bits);
+				for (int j = 0; j < 16; ++j) {
+					d[j * 3] = ONES;
+					d[j * 3 + 1] = bits[15 - j];
+					d[j * 3 + 2] = 0;
+				}
+			}
+		}
+		for (; i < count; ++i, d += 24) {
+			// 8 strips per transpose
+			for (int k = 0; k < N; k += 8) {
+				uint64_t x = 0;
+				for (int j = 0; j < 8; ++j)
+					x |= uint64_t(src[(k + j) * stride + i]) << (j * 8);
+				x = transpose8x8(x);
+				for (int j = 0; j < 8; ++j) {
+					Word bits = Word((x >> ((7 - j) * 8)) & 0xff) << k;
+					if (k == 0) {
+						d[j * 3] = ONES;
+						d[j * 3 + 1] = bits;
+						d[j * 3 + 2] = 0;
+					} else {
+						d[j * 3 + 1] |= bits;
+					}
+				}
+			}
+		}
+		return count;
+	}
+};
+
+/**
+	Encoder for PWM peripherals that read one compare value per LED bit and channel via DMA, e.g. LedStrip_TIM_DMA where
+	a DMA burst writes the compare registers of several timer channels at each update event or LedStrip_PWM on nrf52
+	where EasyDMA reads a sequence of 16 bit values. Each LED bit is represented by one word which is the compare value
+	(high time in clock cycles) of a zero or a one bit. The words of the strips are interleaved, i.e. one step of
+	stepSize words contains the same LED bit of all strips. A byte of each strip is converted into 8 steps.
+	@tparam W word type, uint8_t or uint16_t
+*/
+template <typename W = uint8_t>
+struct LedEncoder_PWM {
+	static_assert(sizeof(W) <= 2, "word type must be 8 or 16 bit");
+	using Word = W;
+
+	// one byte of each strip
+	static constexpr int BLOCK_BYTES = 1;
+	static constexpr int BLOCK_WORDS = 8;
+
+	// up to 4 words that get processed at once
+	using Lanes = std::conditional_t<sizeof(W) == 1, uint32_t, uint64_t>;
+	static constexpr int LANE_BITS = sizeof(W) * 8;
+	static constexpr Lanes LANE_ONES = Lanes(-1) / Word(-1);
+
+	/**
+		Get number of words that encode() generates for the given number of bytes per strip
+		@param byteCount number of source bytes per strip
+		@param stepSize number of words per LED bit, i.e. the number of strips
+		@return number of destination words
+	*/
+	static constexpr int wordCount(int byteCount, int stepSize = 1) {return byteCount * BLOCK_WORDS * stepSize;}
+
+	/**
+		Convert the bits of a byte into 8 compare values of 8 bit, MSB first in memory order
+		@param byte source byte
+		@param zeros compare value of a zero bit in each byte
+		@param diff zero and one compare values xor'ed in each byte
+		@return 8 compare values
+	*/
+	static uint64_t expand(int byte, uint64_t zeros, uint64_t diff) {
+		// broadcast the byte and keep bit 7 - j in byte j
+		uint64_t x = (uint64_t(byte) * 0x0101010101010101u) & 0x0102040810204080u;
+
+		// set bit 7 of the bytes that are not zero and convert into a byte mask
+		x = (x + 0x7f7f7f7f7f7f7f7fu) & 0x8080808080808080u;
+		uint64_t mask = (x >> 7) * 0xffu;
+
+		return zeros ^ (diff & mask);
+	}
+
+	/**
+		Encode LED data of stripCount strips
+		@param src source bytes of the first strip, strip i starts at src + i * stride
+		@param stride distance between the strips in bytes
+		@param stripCount number of strips
+		@param count number of bytes per strip
+		@param zero compare value of a zero bit
+		@param one compare value of a one bit
+		@param dst destination words
+		@param stepSize number of words per LED bit, at least stripCount (default), the words of the missing strips are
+			set to the compare value of a zero bit, e.g. 4 for 3 strips on a peripheral that always reads 4 values per
+			step
+		@return number of source bytes per strip consumed
+	*/
+	static int encode(const uint8_t *src, int stride, int stripCount, int count, Word zero, Word one,
+		std::span<Word> dst, int stepSize = 0)
+	{
+		stepSize = std::max(stepSize, stripCount);
+		count = std::min(count, int(dst.size()) / (BLOCK_WORDS * stepSize));
+		auto d = dst.data();
+		if (sizeof(Word) == 1 && stepSize == 1) {
+			// one store of 8 compare values per byte
+			uint64_t zeros = uint64_t(zero) * 0x0101010101010101u;
+			uint64_t diff = uint64_t(zero ^ one) * 0x0101010101010101u;
+			for (int i = 0; i < count; ++i, d += 8) {
+				uint64_t w = expand(src[i], zeros, diff);
+				if constexpr (std::endian::native == std::endian::little) {
+					std::memcpy(d, &w, 8);
+				} else {
+					for (int j = 0; j < 8; ++j)
+						d[j] = Word(w >> (j * 8));
+				}
+			}
+		} else if (stepSize <= 4) {
+			// gather a byte of each strip and convert one LED bit of all strips at a time, missing strips send zero bits
+			Lanes zeros = Lanes(zero) * LANE_ONES;
+			Lanes diff = Lanes(zero ^ one) * LANE_ONES;
+			for (int i = 0; i < count; ++i, d += 8 * stepSize) {
+				Lanes x = 0;
+				for (int strip = 0; strip < stripCount; ++strip)
+					x |= Lanes(src[strip * stride + i]) << (strip * LANE_BITS);
+				for (int j = 0; j < 8; ++j) {
+					Lanes mask = ((x >> (7 - j)) & LANE_ONES) * Word(-1);
+					Lanes w = zeros ^ (diff & mask);
+					if (stepSize == 4 && std::endian::native == std::endian::little) {
+						std::memcpy(d + j * 4, &w, sizeof(Lanes));
+					} else {
+						for (int strip = 0; strip < stepSize; ++strip)
+							d[j * stepSize + strip] = Word(w >> (strip * LANE_BITS));
+					}
+				}
+			}
+		} else {
+			for (int i = 0; i < count; ++i, d += 8 * stepSize) {
+				for (int strip = 0; strip < stepSize; ++strip) {
+					int byte = strip < stripCount ? src[strip * stride + i] : 0;
+					for (int j = 0; j < 8; ++j)
+						d[j * stepSize + strip] = ((byte << j) & 0x80) != 0 ? one : zero;
+				}
+			}
+		}
+		return count;
+	}
+};
+
+} // namespace coco
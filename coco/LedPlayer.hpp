@@ -0,0 +1,251 @@
+#pragma once
+
+#include "LedCapture.hpp"
+#include <coco/Buffer.hpp>
+#include <coco/Frequency.hpp>
+#include <coco/Loop.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+
+namespace coco {
+
+/**
+	Reader for a show of raw frames that all have the same length and are played at a fixed frame rate, same interface
+	as LedCapture::Reader
+*/
+class LedRawReader {
+public:
+	// the frames are complete, therefore intermediate frames can be skipped (see LedPlayer)
+	static constexpr bool DIFFERENCES = false;
+
+	LedRawReader() = default;
+
+	/**
+		Constructor
+		@param data frames, e.g. a memory mapped file or flash memory
+		@param pixelSize size of a pixel in bytes, e.g. 3 for RGB
+		@param length number of pixels of a frame
+		@param period frame period, e.g. 16667us for 60 frames/s
+	*/
+	LedRawReader(std::span<const uint8_t> data, int pixelSize, int length, Microseconds<> period)
+		: pixelSize(pixelSize), data(data), frameLength(length), period(period.value) {}
+
+	/**
+		Check if the reader is valid
+	*/
+	bool valid() const {return this->pixelSize > 0;}
+
+	/**
+		Advance to the next frame
+		@return true if successful, false at the end of the data
+	*/
+	bool next() {
+		size_t frameSize = size_t(this->frameLength) * this->pixelSize;
+		if (!valid() || (this->index + 1) * frameSize > this->data.size())
+			return false;
+		++this->index;
+		return true;
+	}
+
+	/**
+		Copy the current frame
+		@param frame frame data, pixels beyond its size get ignored
+		@param offset index of the first pixel of the frame data
+	*/
+	void apply(std::span<uint8_t> frame, int offset = 0) const {
+		int pixelSize = this->pixelSize;
+		int count = std::min(this->frameLength - offset, int(frame.size()) / pixelSize);
+		if (count > 0) {
+			std::memcpy(frame.data(), this->data.data() + (size_t(this->index - 1) * this->frameLength + offset)
+				* pixelSize, count * pixelSize);
+		}
+	}
+
+	/**
+		Get the number of pixels of the current frame
+	*/
+	int length() const {return this->frameLength;}
+
+	/**
+		Get the time of the current frame
+		@return time in microseconds since the first frame
+	*/
+	int64_t time() const {return int64_t(this->index - 1) * this->period;}
+
+	// size of a pixel in bytes
+	int pixelSize = 0;
+
+protected:
+	std::span<const uint8_t> data;
+	int frameLength = 0;
+	int period = 0;
+
+	// number of frames that were read
+	int index = 0;
+};
+
+
+/**
+	Player for pre-rendered shows, e.g. a capture of LedRecorder or raw frames in a memory mapped file (MappedFile) on
+	native platforms or in flash memory on microcontrollers. The frames get decoded directly into the buffers of the
+	LED strip device. For a capture (LedCapture::Reader) each buffer has its own reader position and gets only the
+	changed pixels of the frames since it was filled last, therefore no working copy of the frame is needed. For raw
+	frames (LedRawReader) only the current frame gets copied into the buffer.
+	The player writes into the buffers without marking the data as dirty, therefore cached buffers (e.g.
+	LedStrip_I2S::CachedBuffer) are not supported.
+	A show can drive several LED strips: Each strip gets its own player on the same show data with the index of its
+	first pixel as offset.
+
+	Usage:
+		LedPlayer<2> player(loop, LedCapture::Reader(file.data()), 0, buffer1, buffer2);
+		while (player.next()) {
+			co_await player.untilFrame();
+			co_await player.show();
+		}
+
+	@tparam N number of buffers
+	@tparam R reader type, LedCapture::Reader or LedRawReader
+*/
+template <int N, typename R = LedCapture::Reader>
+class LedPlayer {
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param reader reader for the show at its first frame
+		@param offset index of the first pixel of the show that gets played on the LED strip
+		@param buffers N buffers of the LED strip device
+	*/
+	template <typename... B>
+	LedPlayer(Loop &loop, const R &reader, int offset, B &...buffers)
+		: loop(loop), start(reader), reader(reader), offset(offset), buffers{&buffers...}
+	{
+		static_assert(sizeof...(B) == N, "number of buffers must be N");
+		for (auto &r : this->readers)
+			r = reader;
+	}
+
+	/**
+		Decode the next frame into a free buffer, call after the buffer became free (see show())
+		@return true if successful, false at the end of the show
+	*/
+	bool next() {
+		if (!this->reader.next())
+			return false;
+		++this->frameCount;
+
+		// bring the buffer from the frame it contains to the current frame
+		int current = this->current;
+		auto buffer = this->buffers[current];
+		auto &reader = this->readers[current];
+		int pixelSize = this->reader.pixelSize;
+		std::span<uint8_t> frame(buffer->template pointer<uint8_t>(), size_t(buffer->capacity() / pixelSize
+			* pixelSize));
+		if constexpr (R::DIFFERENCES) {
+			while (this->frames[current] != this->frameCount) {
+				reader.next();
+				reader.apply(frame, this->offset);
+				++this->frames[current];
+			}
+		} else {
+			// skip the frames in between
+			reader = this->reader;
+			reader.apply(frame, this->offset);
+			this->frames[current] = this->frameCount;
+		}
+		int count = std::clamp(this->reader.length() - this->offset, 0, buffer->capacity() / pixelSize);
+		this->size = count * pixelSize;
+		return true;
+	}
+
+	/**
+		Wait until the time of the current frame, the first frame gets shown immediately. Frames that are late do not
+		shift the following frames
+		@return use co_await on return value to await the time of the current frame
+	*/
+	[[nodiscard]] auto untilFrame() {
+		int64_t time = this->reader.time();
+		if (!this->running) {
+			this->slot = this->loop.now();
+			this->running = true;
+		} else {
+			this->slot += 1us * int(time - this->time);
+		}
+		this->time = time;
+		return this->loop.sleep(this->slot);
+	}
+
+	/**
+		Start the transfer of the current frame and select a free buffer for the next frame
+		@return use co_await on return value to await a free buffer
+	*/
+	[[nodiscard]] Awaitable<> show() {
+		// start transfer of current buffer
+		int current = this->current;
+		this->buffers[current]->startWrite(this->size);
+
+		// select a free buffer, otherwise the buffer with the oldest frame which gets free first
+		int next = -1;
+		for (int i = 0; i < N; ++i) {
+			if (this->buffers[i]->ready()) {
+				next = i;
+				break;
+			}
+			if (next == -1 || this->frames[i] < this->frames[next])
+				next = i;
+		}
+		this->current = next;
+		return this->buffers[next]->untilReadyOrDisabled();
+	}
+
+	/**
+		Rewind to the start of the show, e.g. to play it in a loop
+	*/
+	void rewind() {
+		this->reader = this->start;
+		for (auto &r : this->readers)
+			r = this->start;
+		std::fill(std::begin(this->frames), std::end(this->frames), 0);
+		this->frameCount = 0;
+		this->running = false;
+	}
+
+	/**
+		Get the time of the current frame
+		@return time in microseconds since the first frame
+	*/
+	int64_t frameTime() const {return this->reader.time();}
+
+protected:
+	Loop &loop;
+
+	// reader at the start of the show and at the current frame
+	R start;
+	R reader;
+	int offset;
+
+	Buffer *buffers[N];
+
+	// reader and frame number of each buffer
+	R readers[N];
+	int frames[N] = {};
+
+	// number of frames that were read
+	int frameCount = 0;
+
+	// index of the buffer that receives the current frame
+	int current = 0;
+
+	// size of the current frame in bytes
+	int size = 0;
+
+	// time of the current frame
+	bool running = false;
+	int64_t time = 0;
+	Loop::Time slot;
+};
+
+} // namespace coco
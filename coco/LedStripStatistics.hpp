@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#ifndef __arm__
+#include <chrono>
+#endif
+
+
+// DWT cycle counter is available on Cortex-M3/M4/M7/M33 but not on Cortex-M0/M0+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#define COCO_LEDSTRIP_CYCLE_COUNTER
+#endif
+
+namespace coco {
+
+/**
+	Statistics of an LED strip device for telemetry, e.g. to decide the strip length per controller. The statistics get
+	collected only if COCO_LEDSTRIP_STATISTICS is defined, otherwise the devices contain no counters and the interrupt
+	handlers don't measure anything. As the definition changes the layout of the devices, enable it only with the
+	package option (CMake option COCO_LEDSTRIP_STATISTICS or conan option statistics=True) which exports it to all
+	users of the library.
+	The interrupt handler may update the values while the application reads them.
+*/
+struct LedStripStatistics {
+#ifdef COCO_LEDSTRIP_STATISTICS
+	static constexpr bool ENABLED = true;
+#else
+	static constexpr bool ENABLED = false;
+#endif
+
+	// number of interrupt handler calls
+	int irqCount = 0;
+
+	// maximum duration of the interrupt handler in ticks (see ticks())
+	uint32_t maxIrqTicks = 0;
+
+	// number of late refills of the LED buffer that caused a glitch on the LED strip, only for devices that can detect
+	// them (see documentation of the device)
+	int underrunCount = 0;
+
+	// number of completed transfers, i.e. frames
+	int frameCount = 0;
+
+	// number of bytes of LED data that were encoded
+	int64_t byteCount = 0;
+
+	/**
+		Get the current time in ticks which are CPU cycles on Cortex-M3/M4/M7/M33 (DWT cycle counter), nanoseconds on
+		the native platform and always zero on Cortex-M0/M0+
+	*/
+	static uint32_t ticks() {
+#if defined(COCO_LEDSTRIP_CYCLE_COUNTER)
+		// DWT_CYCCNT
+		return *reinterpret_cast<volatile uint32_t *>(0xE0001004);
+#elif defined(__arm__)
+		return 0;
+#else
+		return uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+};
+
+/**
+	Counters of LedStripStatistics that a device contains, all methods are empty and the class takes no space (as
+	[[no_unique_address]] member) if COCO_LEDSTRIP_STATISTICS is not defined.
+*/
+class LedStripCounters {
+public:
+#ifdef COCO_LEDSTRIP_STATISTICS
+	LedStripCounters() {
+#ifdef COCO_LEDSTRIP_CYCLE_COUNTER
+		// enable trace (DEMCR.TRCENA) and the cycle counter (DWT_CTRL.CYCCNTENA)
+		*reinterpret_cast<volatile uint32_t *>(0xE000EDFC) |= 1 << 24;
+		*reinterpret_cast<volatile uint32_t *>(0xE0001000) |= 1;
+#endif
+	}
+
+	/**
+		Measures an interrupt handler call from construction to destruction, create at the top of the interrupt handler
+	*/
+	class Irq {
+	public:
+		Irq(LedStripCounters &counters) : counters(counters), start(LedStripStatistics::ticks()) {}
+		~Irq() {
+			auto &statistics = this->counters.statistics;
+			uint32_t time = LedStripStatistics::ticks() - this->start;
+			++statistics.irqCount;
+			statistics.maxIrqTicks = std::max(statistics.maxIrqTicks, time);
+		}
+
+	protected:
+		LedStripCounters &counters;
+		uint32_t start;
+	};
+
+	void underrun(int count = 1) {this->statistics.underrunCount += count;}
+	void frame() {++this->statistics.frameCount;}
+	void encoded(int byteCount) {this->statistics.byteCount += byteCount;}
+
+	const LedStripStatistics &get() const {return this->statistics;}
+	void reset() {this->statistics = {};}
+
+protected:
+	LedStripStatistics statistics;
+#else
+	class Irq {
+	public:
+		Irq(LedStripCounters &) {}
+	};
+
+	void underrun(int count = 1) {}
+	void frame() {}
+	void encoded(int byteCount) {}
+
+	const LedStripStatistics &get() const {
+		static const LedStripStatistics empty;
+		return empty;
+	}
+	void reset() {}
+#endif
+};
+
+} // namespace coco
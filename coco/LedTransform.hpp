@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+
+namespace coco {
+
+/**
+	Color transform that the encoders apply while converting the LED data into the waveform, so that the LED data gets
+	read only once per frame. Global brightness, white balance and gamma correction are combined into one lookup table
+	per channel and the channels of each pixel get reordered, e.g. from RGB to GRB. Supports pixels with 8 bit channels.
+*/
+struct LedTransform {
+	// number of channels per pixel, 3 for RGB, 4 for RGBW
+	int channelCount;
+
+	// input channel for each output channel, e.g. {1, 0, 2} for RGB to GRB
+	uint8_t order[4];
+
+	// lookup table for each output channel
+	uint8_t table[4][256];
+
+	/**
+		Constructor, creates the identity transform
+		@param channelCount number of channels per pixel, 3 or 4
+	*/
+	LedTransform(int channelCount = 3) : channelCount(channelCount), order{0, 1, 2, 3} {
+		set(255, 1.0f);
+	}
+
+	/**
+		Set the order of the channels
+		@param order input channel for each output channel, e.g. {1, 0, 2} for RGB to GRB
+	*/
+	void setOrder(const uint8_t (&order)[4]) {
+		for (int i = 0; i < 4; ++i)
+			this->order[i] = order[i];
+	}
+	void setOrder(const uint8_t (&order)[3]) {
+		for (int i = 0; i < 3; ++i)
+			this->order[i] = order[i];
+	}
+
+	/**
+		Set brightness, gamma and white balance. Call setOrder() before as the white balance refers to the input
+		channels
+		@param brightness global brightness, 255 is full brightness
+		@param gamma gamma of the LEDs, e.g. 2.2, 1 for no gamma correction
+		@param balance white balance for each input channel, 255 is full brightness
+	*/
+	void set(int brightness, float gamma, const uint8_t (&balance)[4] = {255, 255, 255, 255}) {
+		for (int c = 0; c < this->channelCount; ++c) {
+			float scale = brightness * balance[this->order[c]] / 255.0f;
+			for (int i = 0; i < 256; ++i) {
+				float value = gamma == 1.0f ? i / 255.0f : std::pow(i / 255.0f, gamma);
+				this->table[c][i] = uint8_t(value * scale + 0.5f);
+			}
+		}
+	}
+
+	/**
+		Get a transformed byte of a pixel
+		@param pixel input pixel
+		@param channel output channel
+		@return transformed value
+	*/
+	uint8_t operator ()(const uint8_t *pixel, int channel) const {
+		return this->table[channel][pixel[this->order[channel]]];
+	}
+
+	/**
+		Reader for transformed bytes of LED data
+	*/
+	struct Reader {
+		const LedTransform &transform;
+
+		// current pixel and output channel
+		const uint8_t *pixel;
+		int channel;
+
+		uint8_t next() {
+			uint8_t value = this->transform(this->pixel, this->channel);
+			if (++this->channel == this->transform.channelCount) {
+				this->channel = 0;
+				this->pixel += this->transform.channelCount;
+			}
+			return value;
+		}
+	};
+
+	/**
+		Get a reader for transformed bytes of LED data
+		@param data pointer into LED data, the pixel containing the first byte must be readable entirely
+		@param channel channel of the first byte, i.e. offset of data in the LED data modulo channelCount
+	*/
+	Reader reader(const uint8_t *data, int channel) const {
+		return {*this, data - channel, channel};
+	}
+
+	/**
+		Extend a range of LED data to whole pixels, e.g. a range of changed data because a change of one input
+		channel can affect any output channel of the pixel
+		@param begin begin of the range, gets rounded down
+		@param end end of the range, gets rounded up
+	*/
+	void extend(int &begin, int &end) const {
+		int n = this->channelCount;
+		begin -= begin % n;
+		end += (n - end % n) % n;
+	}
+};
+
+} // namespace coco
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace coco {
+
+/*
+	Bit matrix transpose for driving multiple LED strips in parallel. The data of N strips gets transposed so that each
+	word contains the same bit of all strips, one bit per strip, which can then be written to a GPIO port.
+*/
+
+/**
+	Transpose a 8x8 bit matrix. Byte i of the matrix is row i, bit j of a row is column j.
+	@param x matrix
+	@return transposed matrix
+*/
+constexpr uint64_t transpose8x8(uint64_t x) {
+	uint64_t t;
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x = x ^ t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x = x ^ t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x = x ^ t ^ (t << 28);
+	return x;
+}
+
+namespace detail {
+
+// pack the low (c = 0) or high (c = 1) bytes of 4 16 bit words into 4 bytes
+constexpr uint64_t packBytes(uint64_t x, int c) {
+	x = (x >> (c * 8)) & 0x00FF00FF00FF00FFULL;
+	x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+	return (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+}
+
+// unpack 4 bytes into the low bytes of 4 16 bit words
+constexpr uint64_t unpackBytes(uint64_t x) {
+	x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+	return (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+}
+
+} // namespace detail
+
+/**
+	Transpose a 16x16 bit matrix using four 8x8 transposes. Word i of the matrix is row i, bit j of a row is column j.
+	@param src matrix, 16 words
+	@param dst transposed matrix, 16 words
+*/
+constexpr void transpose16x16(const uint16_t *src, uint16_t *dst) {
+	// 4 rows per 64 bit word
+	uint64_t rows[4];
+	for (int i = 0; i < 4; ++i) {
+		rows[i] = uint64_t(src[i * 4]) | uint64_t(src[i * 4 + 1]) << 16
+			| uint64_t(src[i * 4 + 2]) << 32 | uint64_t(src[i * 4 + 3]) << 48;
+	}
+
+	uint64_t columns[4] = {};
+	for (int r = 0; r < 2; ++r) {
+		for (int c = 0; c < 2; ++c) {
+			// 8x8 block at row r * 8, column c * 8
+			uint64_t x = detail::packBytes(rows[r * 2], c) | detail::packBytes(rows[r * 2 + 1], c) << 32;
+			x = transpose8x8(x);
+
+			// store at row c * 8, column r * 8
+			columns[c * 2] |= detail::unpackBytes(x & 0xFFFFFFFF) << (r * 8);
+			columns[c * 2 + 1] |= detail::unpackBytes(x >> 32) << (r * 8);
+		}
+	}
+
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j)
+			dst[i * 4 + j] = uint16_t(columns[i] >> (j * 16));
+	}
+}
+
+} // namespace coco
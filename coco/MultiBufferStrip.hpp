@@ -0,0 +1,124 @@
+#pragma once
+
+#include <coco/Buffer.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+
+namespace coco {
+
+/**
+	LED strip with N buffers so that rendering does not have to wait for the transfer of the previous frame. The device
+	owns up to two buffers, one in flight and one queued, while the renderer uses a free buffer. If the renderer is
+	faster than the LED strip, the queued frame gets dropped in favour of the new one, therefore the LED strip always
+	shows the most recent frame. With N = 2 this behaves like classic double buffering, i.e. show() waits until the
+	previous transfer has finished. Use N >= 3 so that show() never waits.
+
+	A frame counts as queued only while the transfer of the frame before it is still busy, only then it gets dropped
+	using cancel() of the buffer. The frame in flight never gets cancelled, so this works also for devices whose
+	cancel() aborts the transfer (e.g. LedStrip_cout and LedStrip_emu).
+
+	Usage:
+		MultiBufferStrip<Color, 3> strip(buffer1, buffer2, buffer3);
+		while (true) {
+			auto leds = strip.array();
+			// render into leds
+			co_await strip.show();
+		}
+
+	@tparam T type of one LED, e.g. a struct with members r, g, b
+	@tparam N number of buffers
+*/
+template <typename T, int N>
+class MultiBufferStrip {
+	static_assert(N >= 2, "at least two buffers are required");
+public:
+	/**
+		Constructor
+		@param buffers N buffers of the LED strip device
+	*/
+	template <typename... B>
+	MultiBufferStrip(B &...buffers) : buffers{&buffers...} {
+		static_assert(sizeof...(B) == N, "number of buffers must be N");
+		int capacity = this->buffers[0]->capacity();
+		for (auto buffer : this->buffers)
+			capacity = std::min(capacity, buffer->capacity());
+		this->count = capacity / sizeof(T);
+	}
+
+	/**
+		Get number of LEDs
+	*/
+	int size() const {return this->count;}
+
+	/**
+		Get array of LEDs to render into, only valid until show() is called
+	*/
+	std::span<T> array() {
+		return {this->buffers[this->current]->template pointer<T>(), size_t(this->count)};
+	}
+
+	/**
+		Start the transfer of the rendered frame and select a free buffer for the next frame
+		@return use co_await on return value to await a free buffer, returns immediately if N >= 3
+	*/
+	[[nodiscard]] Awaitable<> show() {
+		// drop the queued frame if the frame before it is still in flight
+		bool drop = false;
+		if (this->queued >= 0 && this->inFlight >= 0) {
+			auto queued = this->buffers[this->queued];
+			if (!queued->ready() && !this->buffers[this->inFlight]->ready()) {
+				queued->cancel();
+				drop = queued->ready();
+				if (drop)
+					++this->dropped;
+			}
+		}
+		if (!drop)
+			this->inFlight = this->queued;
+
+		// start transfer of current buffer
+		int current = this->current;
+		this->buffers[current]->startWrite(this->count * sizeof(T));
+		this->frames[current] = ++this->frameCount;
+		this->queued = current;
+
+		// select a free buffer, otherwise the buffer with the oldest frame which gets free first
+		int next = -1;
+		for (int i = 0; i < N; ++i) {
+			if (this->buffers[i]->ready()) {
+				next = i;
+				break;
+			}
+			if (next == -1 || int(this->frames[i] - this->frames[next]) < 0)
+				next = i;
+		}
+		this->current = next;
+		return this->buffers[next]->untilReadyOrDisabled();
+	}
+
+	// number of frames that were dropped because the renderer was faster than the LED strip
+	int dropped = 0;
+
+protected:
+	Buffer *buffers[N];
+
+	// number of LEDs
+	int count;
+
+	// index of the buffer for rendering
+	int current = 0;
+
+	// index of the buffer that was transferred last, -1 if none
+	int queued = -1;
+
+	// index of the buffer that was transferred before the last one, -1 if none
+	int inFlight = -1;
+
+	// frame number of each buffer to find the oldest
+	uint32_t frames[N] = {};
+	uint32_t frameCount = 0;
+};
+
+} // namespace coco
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+
+namespace coco {
+
+/**
+	Format of a pixel in the LED data, i.e. number of channels and bytes per channel. The channels are stored in the
+	order they get sent to the LED strip, 16 bit channels are stored MSB first.
+*/
+struct PixelFormat {
+	// number of color channels, 3 for RGB, 4 for RGBW
+	int channelCount;
+
+	// number of bytes per channel, 1 for 8 bit, 2 for 16 bit
+	int channelSize;
+
+	/**
+		Get the number of bytes of one pixel
+	*/
+	constexpr int size() const {return this->channelCount * this->channelSize;}
+
+	/**
+		Get a pixel as 8 bit RGB for visualization, white gets added to red, green and blue
+		@param pixel pixel data
+		@param rgb destination for red, green and blue
+	*/
+	constexpr void toRgb(const uint8_t *pixel, uint8_t *rgb) const {
+		int channelSize = this->channelSize;
+		int w = this->channelCount >= 4 ? pixel[3 * channelSize] : 0;
+		for (int i = 0; i < 3; ++i) {
+			rgb[i] = std::min(pixel[i * channelSize] + w, 255);
+		}
+	}
+
+	constexpr bool operator ==(const PixelFormat &) const = default;
+};
+
+namespace pixelFormats {
+
+// 3 x 8 bit, e.g. WS2812B
+constexpr PixelFormat RGB = {3, 1};
+
+// 4 x 8 bit, e.g. SK6812 RGBW
+constexpr PixelFormat RGBW = {4, 1};
+
+// 3 x 16 bit, e.g. HD108
+constexpr PixelFormat RGB16 = {3, 2};
+
+// 4 x 16 bit
+constexpr PixelFormat RGBW16 = {4, 2};
+
+} // namespace pixelFormats
+
+} // namespace coco
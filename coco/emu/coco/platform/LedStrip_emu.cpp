@@ -1,11 +1,12 @@
 #include "LedStrip_emu.hpp"
 #include "GuiLedStrip.hpp"
+#include <chrono>
 
 
 namespace coco {
 
-LedStrip_emu::LedStrip_emu(Loop_emu &loop)
-	: loop(loop)
+LedStrip_emu::LedStrip_emu(Loop_emu &loop, PixelFormat format)
+	: loop(loop), format(format)
 {
 	loop.guiHandlers.add(*this);
 }
@@ -35,7 +36,25 @@ LedStrip_emu::Buffer &LedStrip_emu::getBuffer(int index) {
 void LedStrip_emu::handle(Gui &gui) {
 	auto buffer = this->transfers.pop();
 	if (buffer != nullptr) {
-		gui.draw<GuiLedStrip>(buffer->p.data, buffer->p.size / 3);
+		if (this->recorder != nullptr) {
+			auto now = std::chrono::steady_clock::now();
+			this->recorder->add({buffer->p.data, size_t(buffer->p.size)},
+				std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count());
+		}
+
+		auto format = this->format;
+		int pixelSize = format.size();
+		int count = buffer->p.size / pixelSize;
+		if (format == pixelFormats::RGB) {
+			gui.draw<GuiLedStrip>(buffer->p.data, count);
+		} else {
+			// convert to 8 bit RGB
+			this->rgb.resize(count * 3);
+			for (int i = 0; i < count; ++i) {
+				format.toRgb(buffer->p.data + i * pixelSize, this->rgb.data() + i * 3);
+			}
+			gui.draw<GuiLedStrip>(this->rgb.data(), count);
+		}
 		buffer->setReady();
 	} else {
 		// draw emulated LED strip with previous content
@@ -47,7 +66,7 @@ void LedStrip_emu::handle(Gui &gui) {
 // Buffer
 
 LedStrip_emu::Buffer::Buffer(int length, LedStrip_emu &device)
-	: BufferImpl(new uint8_t[length * 3], length * 3, device.stat)
+	: BufferImpl(new uint8_t[length * device.format.size()], length * device.format.size(), device.stat)
 	, device(device)
 {
 	device.buffers.add(*this);
@@ -79,6 +98,7 @@ bool LedStrip_emu::Buffer::cancel() {
 	if (this->p.state != State::BUSY)
 		return false;
 
+	this->device.transfers.remove(*this);
 	setReady(0);
 	return true;
 }
@@ -1,8 +1,11 @@
 #include <coco/BufferImpl.hpp>
 #include <coco/BufferDevice.hpp>
 #include <coco/IntrusiveQueue.hpp>
+#include <coco/LedCapture.hpp>
+#include <coco/PixelFormat.hpp>
 #include <coco/platform/Loop_emu.hpp>
 #include <string>
+#include <vector>
 
 
 namespace coco {
@@ -12,7 +15,12 @@ namespace coco {
 */
 class LedStrip_emu : public BufferDevice, public Loop_emu::GuiHandler {
 public:
-	LedStrip_emu(Loop_emu &loop);
+	/**
+		Constructor
+		@param loop event loop
+		@param format pixel format of the LED data, e.g. pixelFormats::RGBW
+	*/
+	LedStrip_emu(Loop_emu &loop, PixelFormat format = pixelFormats::RGB);
 	~LedStrip_emu() override;
 
 	/**
@@ -23,7 +31,7 @@ public:
 	public:
 		/**
 			Constructor
-			@param length length of emulated LED strip, i.e. number of RGB triples
+			@param length length of emulated LED strip, i.e. number of pixels
 			@param device emulator device
 		*/
 		Buffer(int length, LedStrip_emu &device);
@@ -46,10 +54,21 @@ public:
 	int getBufferCount() override;
 	Buffer &getBuffer(int index) override;
 
+	/**
+		Set a recorder that records each completed buffer, e.g. LedRecorder
+		@param recorder recorder or nullptr to stop recording
+	*/
+	void setRecorder(LedCapture::Writer *recorder) {this->recorder = recorder;}
+
 protected:
 	void handle(Gui &gui) override;
 
 	Loop_native &loop;
+	PixelFormat format;
+	LedCapture::Writer *recorder = nullptr;
+
+	// LED data converted to 8 bit RGB for the gui if the pixel format is not RGB
+	std::vector<uint8_t> rgb;
 
 	// state and coroutines waiting for a state
 	State stat = State::READY;
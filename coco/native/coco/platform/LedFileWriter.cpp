@@ -0,0 +1,114 @@
+#include "LedFileWriter.hpp"
+#include <coco/LedEncoder.hpp>
+#include <cassert>
+#include <cerrno>
+#include <sys/uio.h>
+
+
+namespace coco {
+
+LedFileWriter::LedFileWriter(int fd, int symbolBits, int resetBytes)
+	: fd(fd), symbolBits(symbolBits), reset(resetBytes)
+{
+	switch (symbolBits) {
+	case 3:
+		this->encode = &LedEncoder_SPI<3>::encode;
+		break;
+	case 4:
+		this->encode = &LedEncoder_SPI<4>::encode;
+		break;
+	default:
+		assert(symbolBits == 8);
+		this->encode = &LedEncoder_SPI<8>::encode;
+	}
+
+	this->thread = std::thread(&LedFileWriter::run, this);
+}
+
+LedFileWriter::~LedFileWriter() {
+	flush();
+
+	// wake up the I/O thread and let it exit
+	this->quit.store(true);
+	this->head.fetch_add(1);
+	this->head.notify_one();
+	this->thread.join();
+}
+
+bool LedFileWriter::write(std::span<const uint8_t> data) {
+	if (full())
+		return false;
+	uint32_t head = this->head.load(std::memory_order_relaxed);
+
+	// encode into the free frame which is not accessed by the I/O thread
+	auto &frame = this->frames[head % FRAME_COUNT];
+	frame.resize(data.size() * this->symbolBits);
+	this->encode(data, frame);
+
+	// hand frame to I/O thread
+	this->head.store(head + 1, std::memory_order_release);
+	this->head.notify_one();
+	return true;
+}
+
+void LedFileWriter::flush() {
+	uint32_t head = this->head.load(std::memory_order_relaxed);
+	while (true) {
+		uint32_t tail = this->tail.load(std::memory_order_acquire);
+		if (tail == head)
+			break;
+		this->tail.wait(tail);
+	}
+}
+
+void LedFileWriter::run() {
+	uint32_t tail = this->tail.load(std::memory_order_relaxed);
+	while (true) {
+		// wait for frames
+		this->head.wait(tail, std::memory_order_acquire);
+		if (this->quit.load())
+			break;
+		uint32_t head = this->head.load(std::memory_order_acquire);
+
+		// write all available frames at once, each followed by the reset
+		iovec vec[FRAME_COUNT * 2];
+		int count = 0;
+		for (uint32_t i = tail; i != head; ++i) {
+			auto &frame = this->frames[i % FRAME_COUNT];
+			vec[count++] = {frame.data(), frame.size()};
+			vec[count++] = {this->reset.data(), this->reset.size()};
+		}
+		iovec *v = vec;
+		while (count > 0) {
+			ssize_t written = writev(this->fd, v, count);
+			if (written < 0) {
+				if (errno == EINTR)
+					continue;
+				++this->errorCount;
+				break;
+			}
+
+			// skip what was written, a pipe may accept only part of the data
+			while (count > 0 && size_t(written) >= v->iov_len) {
+				written -= v->iov_len;
+				++v;
+				--count;
+			}
+			if (count > 0) {
+				v->iov_base = static_cast<uint8_t *>(v->iov_base) + written;
+				v->iov_len -= written;
+			}
+		}
+		++this->writeCount;
+
+		// count the frames that were written completely including the reset
+		this->frameCount += (v - vec) / 2;
+
+		// free the frames
+		tail = head;
+		this->tail.store(tail, std::memory_order_release);
+		this->tail.notify_all();
+	}
+}
+
+} // namespace coco
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+namespace coco {
+
+/**
+	Writer that encodes LED data into the SPI waveform (see LedEncoder_SPI) and writes it to a file descriptor from a
+	dedicated I/O thread, e.g. to spidev on a Linux SBC, a pipe or a regular file. The encoded frames get handed to the
+	I/O thread through a lock-free single producer single consumer ring of FRAME_COUNT frames, the I/O thread writes
+	all available frames with one writev() call where each frame is followed by zeros for the reset time.
+	write() must always be called from the same thread, e.g. the event loop.
+*/
+class LedFileWriter {
+public:
+	// number of frames in the ring
+	static constexpr int FRAME_COUNT = 8;
+
+	/**
+		Constructor, starts the I/O thread
+		@param fd file descriptor to write to, stays owned by the caller and must stay open until the writer is destroyed
+		@param symbolBits number of SPI bits per LED bit, 3, 4 or 8
+		@param resetBytes number of zero bytes to append to each frame for the reset time
+	*/
+	LedFileWriter(int fd, int symbolBits, int resetBytes);
+
+	/**
+		Destructor, writes the remaining frames and stops the I/O thread
+	*/
+	~LedFileWriter();
+
+	/**
+		Calculate number of zero bytes for the reset time
+		@param symbolBits number of SPI bits per LED bit
+		@param bitTime bit time in ns
+		@param resetTime reset time in us
+		@return number of bytes
+	*/
+	static constexpr int calcResetBytes(int symbolBits, int bitTime, int resetTime) {
+		int64_t bits = int64_t(resetTime) * 1000 * symbolBits;
+		return int((bits + int64_t(bitTime) * 8 - 1) / (int64_t(bitTime) * 8));
+	}
+
+	/**
+		Check if the ring is full, i.e. the next write() fails
+	*/
+	bool full() const {
+		return this->head.load(std::memory_order_relaxed) - this->tail.load(std::memory_order_acquire) >= FRAME_COUNT;
+	}
+
+	/**
+		Encode LED data into a free frame of the ring and hand it to the I/O thread
+		@param data LED data
+		@return true if successful, false if the ring is full
+	*/
+	bool write(std::span<const uint8_t> data);
+
+	/**
+		Wait until the I/O thread has written all frames
+	*/
+	void flush();
+
+	// number of frames that were written
+	std::atomic<int> frameCount = 0;
+
+	// number of writev() calls, less than frameCount if frames got batched
+	std::atomic<int> writeCount = 0;
+
+	// number of failed writes, e.g. the frame is larger than bufsiz of spidev
+	std::atomic<int> errorCount = 0;
+
+protected:
+	void run();
+
+	int fd;
+	int (*encode)(std::span<const uint8_t>, std::span<uint8_t>);
+	int symbolBits;
+
+	// zeros for the reset time
+	std::vector<uint8_t> reset;
+
+	// ring of encoded frames, head gets advanced by write(), tail by the I/O thread
+	std::vector<uint8_t> frames[FRAME_COUNT];
+	std::atomic<uint32_t> head = 0;
+	std::atomic<uint32_t> tail = 0;
+	std::atomic<bool> quit = false;
+
+	std::thread thread;
+};
+
+} // namespace coco
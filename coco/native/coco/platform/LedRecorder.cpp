@@ -0,0 +1,30 @@
+#include "LedRecorder.hpp"
+#include <algorithm>
+
+
+namespace coco {
+
+LedRecorder::LedRecorder(const std::string &path, int pixelSize)
+	: LedCapture::Writer(pixelSize), file(path, MappedFile::Mode::WRITE)
+{
+}
+
+LedRecorder::~LedRecorder() {
+	this->file.resize(this->used);
+}
+
+uint8_t *LedRecorder::reserve(int size) {
+	size_t required = this->used + size;
+	if (required > this->file.size()) {
+		// grow by doubling so that the number of remaps stays small
+		if (!this->file.resize(std::max({required, this->file.size() * 2, size_t(65536)})))
+			return nullptr;
+	}
+	return this->file.data().data() + this->used;
+}
+
+void LedRecorder::commit(int size) {
+	this->used += size;
+}
+
+} // namespace coco
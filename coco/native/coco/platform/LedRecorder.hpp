@@ -0,0 +1,52 @@
+#pragma once
+
+#include <coco/LedCapture.hpp>
+#include <coco/platform/MappedFile.hpp>
+#include <string>
+
+
+namespace coco {
+
+/**
+	Recorder that appends LED strip frames to a memory mapped capture file (see coco/LedCapture.hpp), only the pixels
+	that changed since the previous frame get stored. Pass it to setRecorder() of LedStrip_cout or LedStrip_emu to
+	record each completed buffer. The file grows in steps of doubling size and gets truncated to the used size when
+	the recorder is destroyed.
+	Read the capture using LedCapture::Reader on MappedFile::data().
+*/
+class LedRecorder : public LedCapture::Writer {
+public:
+	/**
+		Constructor
+		@param path path of the capture file
+		@param pixelSize size of a pixel in bytes, e.g. pixelFormats::RGB.size()
+	*/
+	LedRecorder(const std::string &path, int pixelSize);
+
+	/**
+		Destructor, truncates the file to the used size
+	*/
+	~LedRecorder() override;
+
+	/**
+		Check if the file is open
+	*/
+	bool isOpen() const {return this->file.isOpen();}
+
+	/**
+		Get the size of the capture
+		@return size in bytes
+	*/
+	size_t size() const {return this->used;}
+
+protected:
+	uint8_t *reserve(int size) override;
+	void commit(int size) override;
+
+	MappedFile file;
+
+	// number of bytes of the file that are used
+	size_t used = 0;
+};
+
+} // namespace coco
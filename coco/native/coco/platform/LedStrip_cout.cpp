@@ -1,12 +1,59 @@
 #include "LedStrip_cout.hpp"
 //#include <coco/Color.hpp>
+#include <array>
 #include <iostream>
 
 
 namespace coco {
 
-LedStrip_cout::LedStrip_cout(Loop_native &loop)
-	: loop(loop), callback(makeCallback<LedStrip_cout, &LedStrip_cout::handle>(this))
+namespace {
+
+// https://stackoverflow.com/questions/30097953/ascii-art-sorting-an-array-of-ascii-characters-by-brightness-levels-c-c
+constexpr char lookup[] = " `.-':_,^=;><+!rc*/z?sLTv)J7(|Fi{C}fI31tlu[neoZ5Yxjya]2ESwqkP6h9d4VpOGbUAKXHm8RD#$Bg0MNWQ%&@@";
+
+// character for each luma value
+constexpr auto lumaTable = [] {
+	const int size = std::size(lookup) - 2;
+	std::array<char, 256> table = {};
+	for (int i = 0; i < 256; ++i)
+		table[i] = lookup[i * size / 255];
+	return table;
+}();
+
+// luma with weights 0.30, 0.59 and 0.11 in 8 bit fixed point
+inline int luma(const uint8_t *rgb) {
+	return (77 * rgb[0] + 151 * rgb[1] + 28 * rgb[2]) >> 8;
+}
+
+// decimal representation of 0 - 255
+struct Decimal {
+	int length;
+	char digits[3];
+};
+constexpr auto decimalTable = [] {
+	std::array<Decimal, 256> table = {};
+	for (int i = 0; i < 256; ++i) {
+		auto &d = table[i];
+		if (i >= 100)
+			d.digits[d.length++] = '0' + i / 100;
+		if (i >= 10)
+			d.digits[d.length++] = '0' + i / 10 % 10;
+		d.digits[d.length++] = '0' + i % 10;
+	}
+	return table;
+}();
+
+inline char *appendDecimal(char *dst, int value) {
+	auto &d = decimalTable[value];
+	for (int i = 0; i < d.length; ++i)
+		*dst++ = d.digits[i];
+	return dst;
+}
+
+} // namespace
+
+LedStrip_cout::LedStrip_cout(Loop_native &loop, PixelFormat format, Mode mode)
+	: loop(loop), format(format), mode(mode), callback(makeCallback<LedStrip_cout, &LedStrip_cout::handle>(this))
 {
 }
 
@@ -32,22 +79,96 @@ LedStrip_cout::Buffer &LedStrip_cout::getBuffer(int index) {
 	return this->buffers.get(index);
 }
 
+void LedStrip_cout::render(std::ostream &s, const uint8_t *data, int count, PixelFormat format) {
+	std::string line;
+	render(line, data, count, format);
+	s.write(line.data(), line.size());
+}
+
+void LedStrip_cout::render(std::string &line, const uint8_t *data, int count, PixelFormat format) {
+	size_t offset = line.size();
+	line.resize(offset + count + 1);
+	char *dst = line.data() + offset;
+	if (format == pixelFormats::RGB) {
+		for (int i = 0; i < count; ++i) {
+			dst[i] = lumaTable[luma(data + i * 3)];
+		}
+	} else {
+		int pixelSize = format.size();
+		for (int i = 0; i < count; ++i) {
+			uint8_t rgb[3];
+			format.toRgb(data + i * pixelSize, rgb);
+			dst[i] = lumaTable[luma(rgb)];
+		}
+	}
+	dst[count] = '\n';
+}
+
+void LedStrip_cout::renderColor(std::string &line, const uint8_t *data, int count, PixelFormat format) {
+	// reserve space for the longest escape sequence and a space per LED
+	const char color[] = "\x1b[48;2;";
+	const char reset[] = "\x1b[0m\n";
+	const int maxLength = std::size(color) - 1 + 12 + 1;
+	size_t offset = line.size();
+	line.resize(offset + count * maxLength + std::size(reset) - 1);
+	char *dst = line.data() + offset;
+
+	int pixelSize = format.size();
+	int previous = -1;
+	for (int i = 0; i < count; ++i) {
+		uint8_t rgb[3];
+		format.toRgb(data + i * pixelSize, rgb);
+
+		// set background color if it changes
+		int c = rgb[0] << 16 | rgb[1] << 8 | rgb[2];
+		if (c != previous) {
+			dst = std::copy(color, color + std::size(color) - 1, dst);
+			dst = appendDecimal(dst, rgb[0]);
+			*dst++ = ';';
+			dst = appendDecimal(dst, rgb[1]);
+			*dst++ = ';';
+			dst = appendDecimal(dst, rgb[2]);
+			*dst++ = 'm';
+			previous = c;
+		}
+		*dst++ = ' ';
+	}
+	dst = std::copy(reset, reset + std::size(reset) - 1, dst);
+	line.resize(dst - line.data());
+}
+
 void LedStrip_cout::handle() {
 	auto buffer = this->transfers.pop();
 	if (buffer != nullptr) {
-		// https://stackoverflow.com/questions/30097953/ascii-art-sorting-an-array-of-ascii-characters-by-brightness-levels-c-c
-		static const char lookup[] = " `.-':_,^=;><+!rc*/z?sLTv)J7(|Fi{C}fI31tlu[neoZ5Yxjya]2ESwqkP6h9d4VpOGbUAKXHm8RD#$Bg0MNWQ%&@@";
-		const int size = std::size(lookup) - 2;
+		auto start = std::chrono::steady_clock::now();
 
-		int count = buffer->p.size / 3;
-		Color *colors = (Color*)buffer->p.data;
-		for (int i = 0; i < count; ++i) {
-			Color color = colors[i];
-			int intensity = int((0.30f * color.r + 0.59f * color.g + 0.11f * color.b) / 255.0f * size);
-			char ch = lookup[intensity];
-			std::cout << ch;
+		// record every frame, also the skipped ones
+		if (this->recorder != nullptr) {
+			this->recorder->add({buffer->p.data, size_t(buffer->p.size)},
+				std::chrono::duration_cast<std::chrono::microseconds>(start.time_since_epoch()).count());
+		}
+
+		if (this->mode == Mode::NONE) {
+			// no output
+		} else if (start < this->skipUntil) {
+			// console is too slow
+			++this->skipped;
+		} else {
+			// render into line and write it at once
+			auto &line = this->line;
+			line.clear();
+			int count = buffer->p.size / this->format.size();
+			if (this->mode == Mode::ASCII)
+				render(line, buffer->p.data, count, this->format);
+			else
+				renderColor(line, buffer->p.data, count, this->format);
+			std::cout.write(line.data(), line.size());
+			std::cout.flush();
+
+			// skip frames for the time it took to write, so that writing takes at most about half of the time
+			auto end = std::chrono::steady_clock::now();
+			this->skipUntil = end + (end - start);
 		}
-		std::cout << std::endl;
 		buffer->setReady();
 
 		// check if there are more buffers in the list
@@ -56,11 +177,10 @@ void LedStrip_cout::handle() {
 	}
 }
 
-
 // Buffer
 
 LedStrip_cout::Buffer::Buffer(int length, LedStrip_cout &device)
-	: BufferImpl(new uint8_t[length * 3], length * 3, device.stat)
+	: BufferImpl(new uint8_t[length * device.format.size()], length * device.format.size(), device.stat)
 	, device(device)
 {
 	device.buffers.add(*this);
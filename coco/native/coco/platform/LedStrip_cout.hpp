@@ -1,18 +1,42 @@
 #include <coco/BufferImpl.hpp>
 #include <coco/BufferDevice.hpp>
 #include <coco/IntrusiveQueue.hpp>
+#include <coco/LedCapture.hpp>
+#include <coco/PixelFormat.hpp>
 #include <coco/platform/Loop_native.hpp>
+#include <chrono>
+#include <ostream>
 #include <string>
 
 
 namespace coco {
 
 /**
-	Implementation of a LED strip emulator that shows the LED strip on the console using std::cout
+	Implementation of a LED strip emulator that shows the LED strip on the console using std::cout. Each frame gets
+	rendered into a line that is written at once. If writing to the console takes longer than the time between
+	frames (e.g. slow terminal or CI log), frames get skipped so that the event loop spends at most about half of the
+	time writing.
 */
 class LedStrip_cout : public BufferDevice {
 public:
-	LedStrip_cout(Loop_native &loop);
+	enum class Mode {
+		// one ASCII character per LED according to its brightness
+		ASCII,
+
+		// one space per LED with the color as background using ANSI 24 bit color escape sequences
+		COLOR,
+
+		// no output, e.g. to run headless on a CI machine and record the frames using setRecorder()
+		NONE
+	};
+
+	/**
+		Constructor
+		@param loop event loop
+		@param format pixel format of the LED data, e.g. pixelFormats::RGBW
+		@param mode render mode
+	*/
+	LedStrip_cout(Loop_native &loop, PixelFormat format = pixelFormats::RGB, Mode mode = Mode::ASCII);
 	~LedStrip_cout() override;
 
 	/**
@@ -23,8 +47,8 @@ public:
 	public:
 		/**
 			Constructor
-			@param length length of emulated LED strip, i.e. number of RGB triples
-			@param loop event loop
+			@param length length of emulated LED strip, i.e. number of pixels
+			@param device LED strip device
 		*/
 		Buffer(int length, LedStrip_cout &device);
 		~Buffer() override;
@@ -47,18 +71,58 @@ public:
 	int getBufferCount() override;
 	Buffer &getBuffer(int index) override;
 
+	/**
+		Set a recorder that records each completed buffer, e.g. LedRecorder
+		@param recorder recorder or nullptr to stop recording
+	*/
+	void setRecorder(LedCapture::Writer *recorder) {this->recorder = recorder;}
+
+	/**
+		Render LED data as one line of ASCII characters
+		@param s stream to render into
+		@param data LED data
+		@param count number of LEDs
+		@param format pixel format of the LED data
+	*/
+	static void render(std::ostream &s, const uint8_t *data, int count, PixelFormat format = pixelFormats::RGB);
+
+	/**
+		Render LED data as one line of ASCII characters including newline
+		@param line string to append the line to
+		@param data LED data
+		@param count number of LEDs
+		@param format pixel format of the LED data
+	*/
+	static void render(std::string &line, const uint8_t *data, int count, PixelFormat format = pixelFormats::RGB);
+
+	/**
+		Render LED data as one line of colored spaces using ANSI 24 bit color escape sequences including newline
+		@param line string to append the line to
+		@param data LED data
+		@param count number of LEDs
+		@param format pixel format of the LED data
+	*/
+	static void renderColor(std::string &line, const uint8_t *data, int count, PixelFormat format = pixelFormats::RGB);
+
+	// number of frames that were skipped because the console was too slow
+	int skipped = 0;
+
 protected:
 	void handle();
 
-	struct Color {
-		uint8_t r;
-		uint8_t g;
-		uint8_t b;
-	};
-
 	Loop_native &loop;
+	PixelFormat format;
+	Mode mode;
 	TimedTask<Callback> callback;
 
+	LedCapture::Writer *recorder = nullptr;
+
+	// line that gets reused for each frame
+	std::string line;
+
+	// frames get skipped until this time
+	std::chrono::steady_clock::time_point skipUntil;
+
 	// state and coroutines waiting for a state
 	State stat = State::READY;
 	CoroutineTaskList<Condition> stateTasks;
@@ -0,0 +1,113 @@
+#include "LedStrip_file.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#endif
+
+
+namespace coco {
+
+LedStrip_file::LedStrip_file(Loop_native &loop, const std::string &path, Nanoseconds<> bitTime,
+	Microseconds<> resetTime, int symbolBits)
+	: loop(loop)
+	, fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644))
+	, writer(this->fd, symbolBits, LedFileWriter::calcResetBytes(symbolBits, bitTime.value, resetTime.value))
+	, callback(makeCallback<LedStrip_file, &LedStrip_file::handle>(this))
+	, bitTime(bitTime.value), resetTime(resetTime.value), frameTime(resetTime.value)
+	, stat(this->fd >= 0 ? State::READY : State::DISABLED)
+{
+#ifdef __linux__
+	// set clock of spidev, fails for other files
+	uint32_t speed = int64_t(symbolBits) * 1000000000 / bitTime.value;
+	ioctl(this->fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed);
+#endif
+}
+
+LedStrip_file::~LedStrip_file() {
+	// let the writer finish before closing the file
+	this->writer.flush();
+	close(this->fd);
+}
+
+Device::State LedStrip_file::state() {
+	return this->stat;
+}
+
+Awaitable<Device::Condition> LedStrip_file::until(Condition condition) {
+	// check if IN_* condition is met
+	if ((int(condition) >> int(this->stat)) & 1)
+		return {}; // don't wait
+	return {this->stateTasks, condition};
+}
+
+int LedStrip_file::getBufferCount() {
+	return this->buffers.count();
+}
+
+LedStrip_file::Buffer &LedStrip_file::getBuffer(int index) {
+	return this->buffers.get(index);
+}
+
+void LedStrip_file::handle() {
+	// hand buffers to the writer until its ring is full
+	while (!this->transfers.empty() && !this->writer.full()) {
+		auto buffer = this->transfers.pop();
+		this->writer.write({buffer->p.data, size_t(buffer->p.size)});
+		this->frameTime = int(int64_t(buffer->p.size) * 8 * this->bitTime / 1000) + this->resetTime;
+		buffer->setReady();
+	}
+
+	// try again when the I/O thread has most likely written the next frame, i.e. after the time of a frame on the
+	// line, instead of spinning on the event loop
+	if (!this->transfers.empty()) {
+		auto time = this->loop.now();
+		time += Microseconds<>{this->frameTime};
+		this->loop.invoke(this->callback, time);
+	}
+}
+
+
+// Buffer
+
+LedStrip_file::Buffer::Buffer(int size, LedStrip_file &device)
+	: BufferImpl(new uint8_t[size], size, device.stat)
+	, device(device)
+{
+	device.buffers.add(*this);
+}
+
+LedStrip_file::Buffer::~Buffer() {
+	delete [] this->p.data;
+}
+
+bool LedStrip_file::Buffer::start(Op op) {
+	if (this->p.state != State::READY) {
+		assert(this->p.state != State::BUSY);
+		return false;
+	}
+
+	// check if WRITE flag is set
+	assert((op & Op::WRITE) != 0);
+
+	// add buffer to list of transfers and let event loop call LedStrip_file::handle() when the first was added
+	if (this->device.transfers.push(*this))
+		this->device.loop.invoke(this->device.callback);
+
+	// set state
+	setBusy();
+
+	return true;
+}
+
+bool LedStrip_file::Buffer::cancel() {
+	if (this->p.state != State::BUSY)
+		return false;
+
+	this->device.transfers.remove(*this);
+	setReady(0);
+	return true;
+}
+
+} // namespace coco
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <coco/BufferImpl.hpp>
+#include <coco/BufferDevice.hpp>
+#include <coco/Frequency.hpp>
+#include <coco/IntrusiveQueue.hpp>
+#include <coco/platform/LedFileWriter.hpp>
+#include <coco/platform/Loop_native.hpp>
+#include <string>
+
+
+namespace coco {
+
+/**
+	Implementation of LED strip interface on native platforms that writes the SPI waveform to a file, e.g. to spidev on a
+	Linux SBC (MOSI connected to the data line of the LED strip), a pipe or a regular file for testing. The LED data
+	gets encoded on the event loop (few μs for 300 LEDs) and written by the I/O thread of LedFileWriter, therefore a
+	slow file does not block the event loop. A buffer is ready again as soon as it is encoded, if the I/O thread falls
+	behind by LedFileWriter::FRAME_COUNT frames, the buffers stay busy until there is space. In this case the event
+	loop checks again after the time that one frame takes on the line instead of polling the writer.
+	Note that spidev transfers at most bufsiz bytes (module parameter, default 4096) at once which is 455 RGB LEDs at
+	3 bits per LED bit.
+*/
+class LedStrip_file : public BufferDevice {
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param path path of the file, e.g. /dev/spidev0.0
+		@param bitTime bit time, e.g. T = 1250ns, also sets the clock of spidev (e.g. 2.4MHz for 3 bits per LED bit)
+		@param resetTime reset time, e.g. 80μs
+		@param symbolBits number of SPI bits per LED bit, 3, 4 or 8 (see LedEncoder_SPI)
+	*/
+	LedStrip_file(Loop_native &loop, const std::string &path, Nanoseconds<> bitTime, Microseconds<> resetTime,
+		int symbolBits = 3);
+	~LedStrip_file() override;
+
+	/**
+		Buffer for transferring data to a LED strip
+	*/
+	class Buffer : public BufferImpl, public IntrusiveListNode, public IntrusiveQueueNode {
+		friend class LedStrip_file;
+	public:
+		/**
+			Constructor
+			@param size size of the buffer in bytes, e.g. 900 for 300 RGB LEDs
+			@param device LED strip device
+		*/
+		Buffer(int size, LedStrip_file &device);
+		~Buffer() override;
+
+		// Buffer methods
+		bool start(Op op) override;
+		bool cancel() override;
+
+	protected:
+
+		LedStrip_file &device;
+	};
+
+
+	// Device methods
+	State state() override;
+	[[nodiscard]] Awaitable<Condition> until(Condition condition) override;
+
+	// BufferDevice methods
+	int getBufferCount() override;
+	Buffer &getBuffer(int index) override;
+
+protected:
+	void handle();
+
+	Loop_native &loop;
+	int fd;
+	LedFileWriter writer;
+	TimedTask<Callback> callback;
+
+	// timing of the LED strip in ns and us
+	int bitTime;
+	int resetTime;
+
+	// time of the last frame on the line in us
+	int frameTime;
+
+	// state and coroutines waiting for a state
+	State stat;
+	CoroutineTaskList<Condition> stateTasks;
+
+	// list of buffers
+	IntrusiveList<Buffer> buffers;
+
+	// list of active transfers
+	IntrusiveQueue<Buffer> transfers;
+};
+
+} // namespace coco
@@ -0,0 +1,57 @@
+#include "MappedFile.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace coco {
+
+MappedFile::MappedFile(const std::string &path, Mode mode)
+	: fd(mode == Mode::READ ? open(path.c_str(), O_RDONLY) : open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644))
+	, mode(mode)
+{
+	if (this->fd < 0 || mode != Mode::READ)
+		return;
+
+	// map the whole file
+	struct stat s;
+	if (fstat(this->fd, &s) == 0 && s.st_size > 0) {
+		void *address = mmap(nullptr, s.st_size, PROT_READ, MAP_SHARED, this->fd, 0);
+		if (address != MAP_FAILED) {
+			this->address = static_cast<uint8_t *>(address);
+			this->length = s.st_size;
+		}
+	}
+}
+
+MappedFile::~MappedFile() {
+	unmap();
+	if (this->fd >= 0)
+		close(this->fd);
+}
+
+bool MappedFile::resize(size_t size) {
+	if (this->fd < 0 || this->mode != Mode::WRITE)
+		return false;
+	unmap();
+	if (ftruncate(this->fd, size) != 0)
+		return false;
+	if (size > 0) {
+		void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+		if (address == MAP_FAILED)
+			return false;
+		this->address = static_cast<uint8_t *>(address);
+		this->length = size;
+	}
+	return true;
+}
+
+void MappedFile::unmap() {
+	if (this->address != nullptr)
+		munmap(this->address, this->length);
+	this->address = nullptr;
+	this->length = 0;
+}
+
+} // namespace coco
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+
+namespace coco {
+
+/**
+	File that is mapped into memory, e.g. a capture of LED strip frames (see coco/LedCapture.hpp). In READ mode the
+	whole file gets mapped read-only, in WRITE mode the file gets created and can be resized which maps it again, so
+	pointers into the data are invalid after resize().
+*/
+class MappedFile {
+public:
+	enum class Mode {
+		// open existing file for reading
+		READ,
+
+		// create or truncate file for reading and writing
+		WRITE
+	};
+
+	/**
+		Constructor
+		@param path path of the file
+		@param mode open mode
+	*/
+	MappedFile(const std::string &path, Mode mode = Mode::READ);
+
+	~MappedFile();
+
+	/**
+		Check if the file is open
+	*/
+	bool isOpen() const {return this->fd >= 0;}
+
+	/**
+		Get the mapped data
+	*/
+	std::span<uint8_t> data() {return {this->address, this->length};}
+	std::span<const uint8_t> data() const {return {this->address, this->length};}
+
+	/**
+		Get the size of the file
+	*/
+	size_t size() const {return this->length;}
+
+	/**
+		Resize the file and map it again, only in WRITE mode
+		@param size new size of the file in bytes
+		@return true if successful
+	*/
+	bool resize(size_t size);
+
+protected:
+	void unmap();
+
+	int fd;
+	Mode mode;
+	uint8_t *address = nullptr;
+	size_t length = 0;
+};
+
+} // namespace coco
@@ -3,17 +3,14 @@
 #include <coco/platform/platform.hpp>
 #include <coco/platform/nvic.hpp>
 #include <coco/platform/gpio.hpp>
+#include <coco/LedEncoder.hpp>
 
 
-namespace {
-#include "bitTable_I2S.hpp"
-}
-
 namespace coco {
 
-LedStrip_I2S::LedStrip_I2S(Loop_Queue &loop, gpio::Config sckPin, gpio::Config lrckPin, gpio::Config dataPin,
-	int bitTime, int resetTime)
-	: loop(loop)
+LedStrip_I2S_Base::LedStrip_I2S_Base(Loop_Queue &loop, gpio::Config sckPin, gpio::Config lrckPin, gpio::Config dataPin,
+	int bitTime, int resetTime, uint32_t *ledBuffer, int chunkSize)
+	: loop(loop), buffer(ledBuffer), chunkSize(chunkSize)
 {
 	// debug start indicator pin
 	//gpio::configureOutput(P0(19), false);
@@ -44,7 +41,7 @@ LedStrip_I2S::LedStrip_I2S(Loop_Queue &loop, gpio::Config sckPin, gpio::Config l
 	i2s->CONFIG.MCKFREQ = (value + 0x800) & 0xFFFFF000;
 	//i2s->CONFIG.MCKFREQ = N(I2S_CONFIG_MCKFREQ_MCKFREQ, 32MDIV16);
 
-	i2s->RXTXD.MAXCNT = LED_BUFFER_SIZE;
+	i2s->RXTXD.MAXCNT = chunkSize;
 	i2s->INTENSET = N(I2S_INTENSET_TXPTRUPD, Set);// | N(I2S_INTENSET_STOPPED, Set);
 	i2s->ENABLE = N(I2S_ENABLE_ENABLE, Enabled);
 
@@ -54,40 +51,105 @@ LedStrip_I2S::LedStrip_I2S(Loop_Queue &loop, gpio::Config sckPin, gpio::Config l
 	this->resetWords = (wordFreq * resetTime) / 1000000 + 1;
 }
 
-LedStrip_I2S::~LedStrip_I2S() {
+LedStrip_I2S_Base::~LedStrip_I2S_Base() {
+}
+
+void LedStrip_I2S_Base::enableUnderrunDetection(NRF_TIMER_Type *timer, int ppiChannel) {
+	// count TXPTRUPD events
+	timer->MODE = N(TIMER_MODE_MODE, Counter);
+	timer->BITMODE = N(TIMER_BITMODE_BITMODE, 32Bit);
+	timer->TASKS_CLEAR = TRIGGER;
+	timer->TASKS_START = TRIGGER;
+	this->eventCount = 0;
+	this->counter = timer;
+
+	// connect TXPTRUPD event to COUNT task
+	NRF_PPI->CH[ppiChannel].EEP = uintptr_t(&NRF_I2S->EVENTS_TXPTRUPD);
+	NRF_PPI->CH[ppiChannel].TEP = uintptr_t(&timer->TASKS_COUNT);
+	NRF_PPI->CHENSET = 1 << ppiChannel;
 }
 
-BufferDevice::State LedStrip_I2S::state() {
+BufferDevice::State LedStrip_I2S_Base::state() {
 	return State::READY;
 }
 
-Awaitable<Device::Condition> LedStrip_I2S::until(Condition condition) {
+Awaitable<Device::Condition> LedStrip_I2S_Base::until(Condition condition) {
 	// check if IN_* condition is met
 	if ((int(condition) >> int(State::READY)) & 1)
 		return {}; // don't wait
 	return {this->stateTasks, condition};
 }
 
-int LedStrip_I2S::getBufferCount() {
+int LedStrip_I2S_Base::getBufferCount() {
 	return this->buffers.count();
 }
 
-LedStrip_I2S::BufferBase &LedStrip_I2S::getBuffer(int index) {
+LedStrip_I2S_Base::BufferBase &LedStrip_I2S_Base::getBuffer(int index) {
 	return this->buffers.get(index);
 }
 
-void LedStrip_I2S::handle() {
+void LedStrip_I2S_Base::handle() {
 	auto i2s = NRF_I2S;
 	switch (this->phase) {
 	case Phase::COPY:
-		{
+		if (this->encoded != nullptr) {
+			// get LED buffer fill size (already occupied part of the buffer)
+			int size = this->size;
+
+			// encoded source data
+			const uint32_t *src = this->encoded;
+			int count = this->encodedEnd - src;
+
+			// transfer directly from the cache if the LED buffer is empty, in slices of the chunk size as only TXD.PTR
+			// is double buffered and RXTXD.MAXCNT has to stay the same for the whole transfer
+			if (size == 0 && count >= this->chunkSize) {
+				i2s->TXD.PTR = uintptr_t(src);
+				this->encoded = src + this->chunkSize;
+				this->direct = true;
+
+				// stay in copy phase
+				break;
+			}
+
+			// destination
+			int offset = this->offset;
+			uint32_t *dst = this->buffer + offset;
+			uintptr_t ptr = uintptr_t(dst);
+			dst += size;
+
+			// copy beginning or end of encoded data into the LED buffer
+			int free = this->chunkSize - size;
+			int toCopy = std::min(count, free);
+			std::copy(src, src + toCopy, dst);
+			this->encoded = src + toCopy;
+
+			// check if LED buffer is full
+			if (toCopy == free) {
+				// set DMA pointer to LED buffer
+				i2s->TXD.PTR = ptr;
+				this->direct = false;
+
+				// toggle and reset LED buffer
+				this->offset = offset ^ this->chunkSize;
+				this->size = 0;
+
+				// stay in copy phase
+				break;
+			}
+
+			// end of data: update buffer fill size
+			this->size = size + toCopy;
+
+			// go to reset phase
+			this->phase = Phase::RESET;
+		} else {
 			// get LED buffer fill size (already occupied part of the buffer)
 			int size = this->size;
 
 			// source data
 			uint8_t *begin = this->data;
 			uint8_t *src = begin;
-			uint8_t *end2 = src + (LED_BUFFER_SIZE - size);
+			uint8_t *end2 = src + (this->chunkSize - size);
 			uint8_t *end = std::min(end2, this->end);
 
 			// destination
@@ -96,11 +158,21 @@ void LedStrip_I2S::handle() {
 			uintptr_t ptr = uintptr_t(dst);
 			dst += size;
 
-			// copy/convert
-			for (; src != end; ++src, ++dst) {
-				*dst = bitTable[*src];
+			// convert
+			auto dither = this->dither;
+			auto transform = this->transform;
+			if (dither != nullptr) {
+				LedEncoder_I2S::encode(dither->reader(this->begin, src - this->begin),
+					end - src, std::span<uint32_t>(dst, end - src));
+			} else if (transform == nullptr) {
+				LedEncoder_I2S::encode({src, end}, std::span<uint32_t>(dst, end - src));
+			} else {
+				LedEncoder_I2S::encode({src, end}, std::span<uint32_t>(dst, end - src), *transform,
+					(src - this->begin) % transform->channelCount);
 			}
 
+			this->statistics.encoded(end - src);
+
 			// check if LED buffer is full
 			if (end == end2) {
 				// advance source data pointer
@@ -110,7 +182,7 @@ void LedStrip_I2S::handle() {
 				i2s->TXD.PTR = ptr;
 
 				// toggle and reset LED buffer
-				this->offset = offset ^ LED_BUFFER_SIZE;
+				this->offset = offset ^ this->chunkSize;
 				this->size = 0;
 
 				// stay in copy phase
@@ -128,11 +200,12 @@ void LedStrip_I2S::handle() {
 		{
 			// get buffer size (already occupied part of the buffer) and number of free words
 			int size = this->size;
-			int free = LED_BUFFER_SIZE - size;
+			int free = this->chunkSize - size;
 
-			// number of words to clear
+			// number of words to clear, fill the whole buffer if the I2S is still reading the last slice from the cache
+			// because the transfer may only finish after a pointer to the LED buffer has been latched
 			int count = this->resetCount;
-			int toClear = std::min(count, free);
+			int toClear = this->direct ? free : std::min(count, free);
 
 			// destination
 			int offset = this->offset;
@@ -149,13 +222,14 @@ void LedStrip_I2S::handle() {
 			// check if buffer is full
 			if (toClear == free) {
 				// decrease resetCount
-				this->resetCount = count - toClear;
+				this->resetCount = std::max(count - toClear, 0);
 
 				// set DMA pointer
 				i2s->TXD.PTR = ptr;
+				this->direct = false;
 
 				// toggle and reset buffer
-				this->offset = offset ^ LED_BUFFER_SIZE;
+				this->offset = offset ^ this->chunkSize;
 				this->size = 0;
 
 				// stay in reset phase
@@ -179,6 +253,7 @@ void LedStrip_I2S::handle() {
 			this->transfers.pop(
 				[this](BufferBase &buffer) {
 					// push finished transfer buffer to event loop so that BufferBase::handle() gets called from the event loop
+					this->statistics.frame();
 					this->loop.push(buffer);
 					return true;
 				},
@@ -204,7 +279,7 @@ void LedStrip_I2S::handle() {
 			int offset = this->offset;
 			uint32_t *dst = this->buffer + offset;
 			uintptr_t ptr = uintptr_t(dst);
-			uint32_t *end = dst + LED_BUFFER_SIZE;
+			uint32_t *end = dst + this->chunkSize;
 			dst += size;
 
 			// clear
@@ -216,7 +291,7 @@ void LedStrip_I2S::handle() {
 			i2s->TXD.PTR = ptr;
 
 			// toggle and reset buffer
-			this->offset = offset ^ LED_BUFFER_SIZE;
+			this->offset = offset ^ this->chunkSize;
 			this->size = 0;
 		} else {
 			// stop I2S
@@ -232,16 +307,17 @@ void LedStrip_I2S::handle() {
 
 // BufferBase
 
-LedStrip_I2S::BufferBase::BufferBase(uint8_t *data, int capacity, LedStrip_I2S &device)
+LedStrip_I2S_Base::BufferBase::BufferBase(uint8_t *data, int capacity, LedStrip_I2S_Base &device, uint32_t *encoded)
 	: BufferImpl(data, capacity, BufferBase::State::READY), device(device)
+	, encoded(encoded), dirtyBegin(0), dirtyEnd(capacity)
 {
 	device.buffers.add(*this);
 }
 
-LedStrip_I2S::BufferBase::~BufferBase() {
+LedStrip_I2S_Base::BufferBase::~BufferBase() {
 }
 
-bool LedStrip_I2S::BufferBase::start(Op op) {
+bool LedStrip_I2S_Base::BufferBase::start(Op op) {
 	if (this->p.state != State::READY) {
 		assert(this->p.state != State::BUSY);
 		return false;
@@ -250,6 +326,42 @@ bool LedStrip_I2S::BufferBase::start(Op op) {
 	// check if WRITE flag is set
 	assert((op & Op::WRITE) != 0);
 
+	// check if dithering is used with an uncached buffer and there is an accumulator for each channel
+	assert(this->device.dither == nullptr
+		|| (this->encoded == nullptr && int(this->p.size) / 2 <= this->device.dither->capacity));
+
+	// encode changed data into the cache
+	if (this->encoded != nullptr) {
+		int size = this->p.size;
+		int begin = this->dirtyBegin;
+		int end = this->dirtyEnd;
+		auto transform = this->device.transform;
+		if (transform == nullptr) {
+			end = std::min(end, size);
+			if (begin < end) {
+				LedEncoder_I2S::encode({this->p.data + begin, this->p.data + end}, {this->encoded + begin, this->encoded + end});
+				this->device.statistics.encoded(end - begin);
+			}
+		} else {
+			// a change affects the whole pixel
+			transform->extend(begin, end);
+			end = std::min(end, size);
+			if (begin < end) {
+				LedEncoder_I2S::encode({this->p.data + begin, this->p.data + end}, {this->encoded + begin, this->encoded + end},
+					*transform, 0);
+				this->device.statistics.encoded(end - begin);
+			}
+		}
+
+		// changes behind the transferred data stay dirty
+		if (this->dirtyEnd > size) {
+			this->dirtyBegin = std::max(begin, size);
+		} else {
+			this->dirtyBegin = capacity();
+			this->dirtyEnd = 0;
+		}
+	}
+
 	// add to list of pending transfers and start immediately if list was empty
 	if (this->device.transfers.push(I2S_IRQn, *this))
 		start();
@@ -260,7 +372,7 @@ bool LedStrip_I2S::BufferBase::start(Op op) {
 	return true;
 }
 
-bool LedStrip_I2S::BufferBase::cancel() {
+bool LedStrip_I2S_Base::BufferBase::cancel() {
 	if (this->p.state != State::BUSY)
 		return false;
 	auto &device = this->device;
@@ -272,7 +384,7 @@ bool LedStrip_I2S::BufferBase::cancel() {
 	return true;
 }
 
-void LedStrip_I2S::BufferBase::start() {
+void LedStrip_I2S_Base::BufferBase::start() {
 	// set debug start indicator pin
 	//gpio::setOutput(P0(19), true);
 
@@ -280,11 +392,15 @@ void LedStrip_I2S::BufferBase::start() {
 	auto i2s = NRF_I2S;
 
 	// set data
+	device.begin = this->p.data;
 	device.data = this->p.data;
-	device.end = this->p.data + this->p.size;
+	device.end = this->p.data + (device.dither == nullptr ? this->p.size : this->p.size / 2);
+	device.encoded = this->encoded;
+	if (this->encoded != nullptr)
+		device.encodedEnd = this->encoded + this->p.size;
 
 	// set reset count (enlarge so that at least one buffer gets filled)
-	device.resetCount = std::max(device.resetWords, LED_BUFFER_SIZE - int(this->p.size));
+	device.resetCount = std::max(device.resetWords, device.chunkSize - int(device.end - device.data));
 
 	// set idle count
 	device.idleCount = 3;
@@ -302,7 +418,7 @@ void LedStrip_I2S::BufferBase::start() {
 	//gpio::setOutput(P0(19), false);
 }
 
-void LedStrip_I2S::BufferBase::handle() {
+void LedStrip_I2S_Base::BufferBase::handle() {
 	// set debug start indicator pin
 	//gpio::setOutput(P0(19), true);
 
@@ -3,6 +3,9 @@
 #include <coco/BufferDevice.hpp>
 #include <coco/BufferImpl.hpp>
 #include <coco/Frequency.hpp>
+#include <coco/LedDither.hpp>
+#include <coco/LedStripStatistics.hpp>
+#include <coco/LedTransform.hpp>
 #include <coco/platform/Loop_Queue.hpp>
 #include <coco/platform/gpio.hpp>
 #include <coco/platform/nvic.hpp>
@@ -11,55 +14,77 @@
 namespace coco {
 
 /**
-	Implementation of LED strip interface on nrf52 using I2S.
+	Implementation of LED strip interface on nrf52 using I2S. Instantiate LedStrip_I2S or LedStrip_I2S_Chunked which
+	contain the LED buffer.
 
 	Reference manual:
 		https://infocenter.nordicsemi.com/topic/ps_nrf52840/i2s.html?cp=5_0_0_5_10
 	Resources:
 		I2S
 */
-class LedStrip_I2S : public BufferDevice {
-protected:
-	LedStrip_I2S(Loop_Queue &loop, gpio::Config sckPin, gpio::Config lrckPin, gpio::Config dataPin, int bitTime, int resetTime);
+class LedStrip_I2S_Base : public BufferDevice {
 public:
+	// maximum chunk size, RXTXD.MAXCNT has 14 bits
+	static constexpr int MAX_COUNT = 16383;
+
+protected:
 	/**
 		Constructor
 		@param loop event loop
 		@param sckPin i2s sck pin needs to be an unused pin
 		@param lrckPin i2s lrck pin needs to be an unused pin
 		@param dataPin pin that transmits data to the LED strip
-		@param bitTime bit time, e.g. T = 1125ns (T0H = 375ns, T1H = 750ns)
-		@param resetTime reset time in us, e.g. 20μs
+		@param bitTime bit time in ns
+		@param resetTime reset time in us
+		@param ledBuffer LED buffer for 2 x chunkSize words
+		@param chunkSize number of bytes of LED data that the interrupt handler encodes at once
 	*/
-	LedStrip_I2S(Loop_Queue &loop, gpio::Config sckPin, gpio::Config lrckPin, gpio::Config dataPin,
-		Nanoseconds<> bitTime, Microseconds<> resetTime)
-		: LedStrip_I2S(loop, sckPin, lrckPin, dataPin, bitTime.value, resetTime.value) {}
-
-	~LedStrip_I2S() override;
+	LedStrip_I2S_Base(Loop_Queue &loop, gpio::Config sckPin, gpio::Config lrckPin, gpio::Config dataPin, int bitTime, int resetTime,
+		uint32_t *ledBuffer, int chunkSize);
+public:
+	~LedStrip_I2S_Base() override;
 
 
 	// internal buffer base class, derives from IntrusiveListNode for the list of active transfers and Loop_Queue::Handler to be notified from the event loop
 	class BufferBase : public BufferImpl, public IntrusiveListNode, public Loop_Queue::Handler {
-		friend class LedStrip_I2S;
+		friend class LedStrip_I2S_Base;
 	public:
 		/**
 			Constructor
 			@param data data of the buffer
 			@param capacity capacity of the buffer
 			@param device led strip device to attach to
+			@param encoded cache for encoded data with one word per byte, nullptr if the buffer has no cache
 		*/
-		BufferBase(uint8_t *data, int capacity, LedStrip_I2S &device);
+		BufferBase(uint8_t *data, int capacity, LedStrip_I2S_Base &device, uint32_t *encoded = nullptr);
 		~BufferBase() override;
 
 		// Buffer methods
 		bool start(Op op) override;
 		bool cancel() override;
 
+		/**
+			Mark a range of the data as changed since the last transfer of this buffer, only for buffers with cache
+			(CachedBuffer). Only the changed data gets encoded when the next transfer starts, the rest is taken from the
+			cache. Changes that are not marked don't get transferred.
+			@param begin offset of first changed byte
+			@param end offset after last changed byte
+		*/
+		void setDirty(int begin, int end) {
+			this->dirtyBegin = std::min(this->dirtyBegin, begin);
+			this->dirtyEnd = std::max(this->dirtyEnd, end);
+		}
+
 	protected:
 		void start();
 		void handle() override;
 
-		LedStrip_I2S &device;
+		LedStrip_I2S_Base &device;
+
+		// cache for encoded data and range of data that needs to be encoded
+		uint32_t *encoded;
+		int dirtyBegin;
+		int dirtyEnd;
 	};
 
 	/**
@@ -69,10 +94,29 @@ public:
 	template <int C>
 	class Buffer : public BufferBase {
 	public:
-		Buffer(LedStrip_I2S &device) : BufferBase(data, C, device) {}
+		Buffer(LedStrip_I2S_Base &device) : BufferBase(data, C, device) {}
+
+	protected:
+		alignas(4) uint8_t data[C];
+	};
+
+	/**
+		Buffer for transferring data to LED strip that keeps the encoded data. Use setDirty() to mark changed data.
+		The interrupt handler sets the DMA pointer directly to the encoded data one chunk at a time, only the end of the
+		transfer gets copied into the LED buffer. The interrupt handler therefore only sets a pointer and may be
+		delayed by the duration of a chunk, e.g. by the radio. Use a large chunk size (up to MAX_COUNT) to tolerate
+		longer delays with few interrupts per frame. The buffer becomes ready when the I2S has finished reading the
+		cache, so it can be rendered again immediately. Needs 5 bytes of RAM per byte of LED data.
+		@tparam C capacity of buffer
+	*/
+	template <int C>
+	class CachedBuffer : public BufferBase {
+	public:
+		CachedBuffer(LedStrip_I2S_Base &device) : BufferBase(data, C, device, encoded) {}
 
 	protected:
 		alignas(4) uint8_t data[C];
+		uint32_t encoded[C];
 	};
 
 
@@ -84,13 +128,62 @@ public:
 	int getBufferCount();
 	BufferBase &getBuffer(int index);
 
+	/**
+		Set a color transform that gets applied while encoding the LED data, takes effect with the next transfer.
+		Mark all data of cached buffers as dirty when the transform changes
+		@param transform color transform, needs to stay valid, nullptr for no transform
+	*/
+	void setTransform(const LedTransform *transform) {this->transform = transform;}
+
+	/**
+		Set temporal dithering, takes effect with the next transfer. The buffers then contain 16 bit channels MSB first
+		(see PixelFormat) which get reduced to 8 bit while encoding, a transfer of size bytes sends size / 2 bytes to the
+		LED strip. Not supported for cached buffers, the color transform is not applied
+		@param dither dithering with one accumulator per channel, needs to stay valid, nullptr for no dithering
+	*/
+	void setDither(LedDither *dither) {this->dither = dither;}
+
+	/**
+		Enable detection of underruns. When the interrupt handler gets delayed beyond the next TXPTRUPD event (e.g.
+		by a higher priority interrupt of the radio), the I2S sends the previous buffer again which shows up as a
+		glitch on the LED strip. A timer in counter mode counts the TXPTRUPD events via PPI, so the interrupt handler
+		can detect the events that it missed. The underruns are counted in the statistics (see getStatistics()).
+		@param timer timer instance to use as counter, e.g. NRF_TIMER2
+		@param ppiChannel PPI channel that connects EVENTS_TXPTRUPD to TASKS_COUNT of the timer
+	*/
+	void enableUnderrunDetection(NRF_TIMER_Type *timer, int ppiChannel);
+
+	/**
+		Get the statistics, only collected if COCO_LEDSTRIP_STATISTICS is defined. Underruns are counted when
+		underrun detection is enabled
+	*/
+	const LedStripStatistics &getStatistics() const {return this->statistics.get();}
+
+	/**
+		Reset the statistics
+	*/
+	void resetStatistics() {this->statistics.reset();}
+
 	/**
 	 * I2S interrupt handler, needs to be called from global I2S interrupt handler
 	 */
 	void I2S_IRQHandler() {
+		LedStripCounters::Irq irq(this->statistics);
+
 		// check if tx pointer has been read
 		if (NRF_I2S->EVENTS_TXPTRUPD) {
 			NRF_I2S->EVENTS_TXPTRUPD = 0;
+
+			// check if the counter has counted more events than the interrupt handler has seen
+			auto counter = this->counter;
+			if (counter != nullptr) {
+				counter->TASKS_CAPTURE[0] = TRIGGER;
+				uint32_t eventCount = counter->CC[0];
+				int missed = eventCount - this->eventCount - 1;
+				this->statistics.underrun(missed);
+				this->eventCount = eventCount;
+			}
+
 			handle();
 		}
 	}
@@ -109,10 +202,24 @@ protected:
 	// list of active transfers
 	nvic::Queue<BufferBase> transfers;
 
-	// data to transfer
+	// color transform
+	const LedTransform *transform = nullptr;
+
+	// temporal dithering
+	LedDither *dither = nullptr;
+
+	// data to transfer (in units of 8 bit channels if there is dithering)
+	uint8_t *begin;
 	uint8_t *data;
 	uint8_t *end;
 
+	// encoded data to transfer (if the buffer has a cache)
+	const uint32_t *encoded;
+	const uint32_t *encodedEnd;
+
+	// the last DMA pointer points into the cache, therefore the buffer is still in use until the next pointer update
+	bool direct = false;
+
 	// reset after data
 	int resetWords;
 	int resetCount;
@@ -120,9 +227,16 @@ protected:
 	// number of idle buffers to send when no new data arrives
 	int idleCount;
 
-	// buffer for 2 x 16 LEDs
-	static constexpr int LED_BUFFER_SIZE = 16 * 3;
-	uint32_t buffer[2 * LED_BUFFER_SIZE];
+	// underrun detection: counter of TXPTRUPD events and number of events seen by the interrupt handler
+	NRF_TIMER_Type *counter = nullptr;
+	uint32_t eventCount = 0;
+
+	// statistics
+	[[no_unique_address]] LedStripCounters statistics;
+
+	// LED buffer for 2 x chunkSize bytes of LED data (one word per byte)
+	uint32_t *buffer;
+	int chunkSize;
 	int offset = 0;
 	int size = 0;
 
@@ -145,4 +259,42 @@ protected:
 	Phase phase = Phase::STOPPED;
 };
 
+/**
+	LED strip on nrf52 using I2S with LED buffer. The interrupt handler encodes C bytes of LED data at once, therefore
+	the CPU gets interrupted every C * 8 bit times, e.g. every C * 9μs for a bit time of 1125ns. A larger chunk size
+	reduces the number of interrupts per frame but increases RAM usage (8 bytes per byte of chunk size) and the duration
+	of the interrupt handler.
+	@tparam C chunk size in bytes of LED data, e.g. 48 for 16 RGB or 12 RGBW LEDs
+*/
+template <int C = 48>
+class LedStrip_I2S_Chunked : public LedStrip_I2S_Base {
+	// RXTXD.MAXCNT has 14 bits
+	static_assert(C > 0 && C <= MAX_COUNT, "invalid chunk size");
+protected:
+	LedStrip_I2S_Chunked(Loop_Queue &loop, gpio::Config sckPin, gpio::Config lrckPin, gpio::Config dataPin,
+		int bitTime, int resetTime)
+		: LedStrip_I2S_Base(loop, sckPin, lrckPin, dataPin, bitTime, resetTime, ledBuffer, C) {}
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param sckPin i2s sck pin needs to be an unused pin
+		@param lrckPin i2s lrck pin needs to be an unused pin
+		@param dataPin pin that transmits data to the LED strip
+		@param bitTime bit time, e.g. T = 1125ns (T0H = 375ns, T1H = 750ns)
+		@param resetTime reset time in us, e.g. 20μs
+	*/
+	LedStrip_I2S_Chunked(Loop_Queue &loop, gpio::Config sckPin, gpio::Config lrckPin, gpio::Config dataPin,
+		Nanoseconds<> bitTime, Microseconds<> resetTime)
+		: LedStrip_I2S_Base(loop, sckPin, lrckPin, dataPin, bitTime.value, resetTime.value, ledBuffer, C) {}
+
+protected:
+	uint32_t ledBuffer[2 * C];
+};
+
+/**
+	LED strip on nrf52 using I2S with the default chunk size of 48 bytes
+*/
+using LedStrip_I2S = LedStrip_I2S_Chunked<>;
+
 } // namespace coco
@@ -0,0 +1,244 @@
+#include "LedStrip_PWM.hpp"
+#include <algorithm>
+
+
+namespace coco {
+
+// LedStrip_PWM
+
+LedStrip_PWM::LedStrip_PWM(Loop_Queue &loop, const gpio::Config *pins, int channelCount, NRF_PWM_Type *pwm, int irq,
+	int bitTime, int t0h, int t1h, int resetTime, uint16_t *ledBuffer, int chunkSize)
+	: loop(loop)
+	, pwm(pwm), irq(irq), channelCount(channelCount)
+	, buffer(ledBuffer), chunkSize(chunkSize)
+{
+	assert(channelCount >= 1 && channelCount <= MAX_CHANNEL_COUNT);
+
+	// PWM periods per bit and compare values, bit 15 set means high until the counter reaches the compare value
+	int countertop = (bitTime * CLOCK + 500000) / 1000000;
+	this->zero = ((t0h * CLOCK + 500000) / 1000000) | 0x8000;
+	this->one = ((t1h * CLOCK + 500000) / 1000000) | 0x8000;
+	assert((this->one & 0x7fff) <= countertop);
+
+	// reset time in number of PWM periods
+	this->resetSteps = resetTime * 1000 / bitTime + 1;
+
+	// configure pins, initial state is low which is also the state after the PWM stops
+	int step = stepSize(channelCount);
+	for (int i = 0; i < channelCount; ++i) {
+		auto pin = pins[i];
+		gpio::configureOutput(pin, false);
+
+		// in grouped mode the second strip is on OUT[2] which uses the second value of each step
+		pwm->PSEL.OUT[step == 2 ? i * 2 : i] = gpio::getPinIndex(pin);
+	}
+
+	// initialize PWM
+	int load = step == 1 ? N(PWM_DECODER_LOAD, Common) : (step == 2 ? N(PWM_DECODER_LOAD, Grouped)
+		: N(PWM_DECODER_LOAD, Individual));
+	pwm->MODE = N(PWM_MODE_UPDOWN, Up);
+	pwm->PRESCALER = N(PWM_PRESCALER_PRESCALER, DIV_1);
+	pwm->COUNTERTOP = countertop;
+	pwm->DECODER = load | N(PWM_DECODER_MODE, RefreshCount);
+	for (int seq = 0; seq < 2; ++seq) {
+		pwm->SEQ[seq].REFRESH = 0;
+		pwm->SEQ[seq].ENDDELAY = 0;
+	}
+
+	// play SEQ0 and SEQ1 in an endless loop until the interrupt handler stops the PWM
+	pwm->LOOP = 1;
+	pwm->SHORTS = N(PWM_SHORTS_LOOPSDONE_SEQSTART0, Enabled);
+	pwm->INTENSET = N(PWM_INTENSET_SEQEND0, Set) | N(PWM_INTENSET_SEQEND1, Set);
+	pwm->ENABLE = N(PWM_ENABLE_ENABLE, Enabled);
+
+	nvic::setPriority(irq, nvic::Priority::MEDIUM);
+	nvic::enable(irq);
+}
+
+LedStrip_PWM::~LedStrip_PWM() {
+}
+
+BufferDevice::State LedStrip_PWM::state() {
+	return State::READY;
+}
+
+Awaitable<Device::Condition> LedStrip_PWM::until(Condition condition) {
+	// check if IN_* condition is met
+	if ((int(condition) >> int(State::READY)) & 1)
+		return {}; // don't wait
+	return {this->stateTasks, condition};
+}
+
+int LedStrip_PWM::getBufferCount() {
+	return this->buffers.count();
+}
+
+LedStrip_PWM::BufferBase &LedStrip_PWM::getBuffer(int index) {
+	return this->buffers.get(index);
+}
+
+void LedStrip_PWM::handle(int seq) {
+	auto pwm = this->pwm;
+	int step = stepSize(this->channelCount);
+	int chunkSteps = this->chunkSize * 8;
+
+	// destination sequence and number of PWM periods (steps) in it
+	uint16_t *dst = this->buffer + seq * Encoder::wordCount(this->chunkSize, step);
+	int steps = 0;
+
+	switch (this->phase) {
+	case Phase::COPY:
+		{
+			// encode next chunk of each strip
+			uint8_t *src = this->data;
+			int count = std::min(int(this->end - src), this->chunkSize);
+			Encoder::encode(src, this->stride, this->channelCount, count, this->zero, this->one,
+				{dst, dst + Encoder::wordCount(count, step)}, step);
+			steps = count * 8;
+			this->data = src + count;
+			this->statistics.encoded(count * this->channelCount);
+
+			// stay in copy phase until the end of the data
+			if (this->data < this->end)
+				break;
+
+			// go to reset phase
+			this->phase = Phase::RESET;
+		}
+		// fall through
+	case Phase::RESET:
+		{
+			// fill the rest of the sequence with zeros
+			int toClear = std::min(this->resetCount, chunkSteps - steps);
+			std::fill(dst + steps * step, dst + (steps + toClear) * step, uint16_t(0x8000));
+			steps += toClear;
+			this->resetCount -= toClear;
+
+			// stay in reset phase until the reset time is reached
+			if (this->resetCount > 0)
+				break;
+
+			// go to finished phase
+			this->phase = Phase::FINISHED;
+		}
+		// fall through
+	case Phase::FINISHED:
+		// the sequence ends with the reset, the next transfer starts with the next sequence
+		this->phase = Phase::IDLE;
+
+		this->transfers.pop(
+			[this](BufferBase &buffer) {
+				// push finished transfer buffer to event loop so that BufferBase::handle() gets called from the event loop
+				this->statistics.frame();
+				this->loop.push(buffer);
+				return true;
+			},
+			[](BufferBase &next) {
+				// start next transfer if there is one
+				next.start();
+			}
+		);
+		break;
+	case Phase::IDLE:
+		// let PWM run for one more sequence so that the reset gets played completely
+		if (--this->idleCount >= 0) {
+			steps = chunkSteps;
+			std::fill(dst, dst + steps * step, uint16_t(0x8000));
+		} else {
+			// stop PWM at the end of the current period
+			pwm->TASKS_STOP = TRIGGER;
+			this->phase = Phase::STOPPED;
+			return;
+		}
+		break;
+	default:
+		return;
+	}
+
+	// set sequence, takes effect when it starts the next time
+	pwm->SEQ[seq].PTR = uintptr_t(dst);
+	pwm->SEQ[seq].CNT = steps * step;
+}
+
+
+// BufferBase
+
+LedStrip_PWM::BufferBase::BufferBase(uint8_t *data, int capacity, LedStrip_PWM &device)
+	: BufferImpl(data, capacity, BufferBase::State::READY), device(device)
+{
+	device.buffers.add(*this);
+}
+
+LedStrip_PWM::BufferBase::~BufferBase() {
+}
+
+bool LedStrip_PWM::BufferBase::start(Op op) {
+	if (this->p.state != State::READY) {
+		assert(this->p.state != State::BUSY);
+		return false;
+	}
+	auto &device = this->device;
+
+	// check if WRITE flag is set and the size is a multiple of the number of strips
+	assert((op & Op::WRITE) != 0);
+	assert(this->p.size % device.channelCount == 0);
+
+	// add to list of pending transfers and start immediately if list was empty
+	if (device.transfers.push(device.irq, *this))
+		start();
+
+	// set state
+	setBusy();
+
+	return true;
+}
+
+bool LedStrip_PWM::BufferBase::cancel() {
+	if (this->p.state != State::BUSY)
+		return false;
+	auto &device = this->device;
+
+	// remove from pending transfers if not yet started, otherwise complete normally
+	if (device.transfers.remove(device.irq, *this, false))
+		setReady(0);
+
+	return true;
+}
+
+void LedStrip_PWM::BufferBase::start() {
+	auto &device = this->device;
+
+	// set data of first strip
+	int stride = this->p.size / device.channelCount;
+	device.data = this->p.data;
+	device.end = this->p.data + stride;
+	device.stride = stride;
+
+	// set reset count
+	device.resetCount = device.resetSteps;
+
+	// set idle count
+	device.idleCount = 1;
+
+	// get current phase
+	auto ph = device.phase;
+
+	device.phase = Phase::COPY;
+
+	// if the PWM is running, the interrupt handler continues with the sequence that ends next
+	if (ph == Phase::STOPPED) {
+		// fill both sequences and start with SEQ0
+		auto pwm = device.pwm;
+		device.handle(0);
+		device.handle(1);
+		pwm->EVENTS_SEQEND[0] = 0;
+		pwm->EVENTS_SEQEND[1] = 0;
+		pwm->TASKS_SEQSTART[0] = TRIGGER;
+	}
+}
+
+void LedStrip_PWM::BufferBase::handle() {
+	setReady();
+}
+
+} // namespace coco
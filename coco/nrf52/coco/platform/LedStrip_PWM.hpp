@@ -0,0 +1,252 @@
+#pragma once
+
+#include <coco/BufferDevice.hpp>
+#include <coco/BufferImpl.hpp>
+#include <coco/Frequency.hpp>
+#include <coco/LedEncoder.hpp>
+#include <coco/LedStripStatistics.hpp>
+#include <coco/platform/Loop_Queue.hpp>
+#include <coco/platform/gpio.hpp>
+#include <coco/platform/nvic.hpp>
+#include <coco/platform/platform.hpp>
+#include <array>
+
+
+namespace coco {
+
+/**
+	Implementation of LED strip interface on nrf52 for 1 - 4 LED strips on the channels of a PWM instance. Each LED bit
+	is one PWM period at 16MHz whose compare value (high time) comes from a sequence in RAM that EasyDMA reads (see
+	LedEncoder_PWM), therefore T0H and T1H are exact to 62.5ns independent of the bit time. The LED buffer consists of
+	the two sequences SEQ0 and SEQ1 which play alternately, when a sequence has ended (SEQEND event), the interrupt
+	handler encodes the next chunk of LED data into it while the other sequence plays. The reset is generated by
+	compare values of zero.
+	The decoder loads 1 (one strip), 2 (two strips on OUT[0] and OUT[2]) or 4 values per LED bit, so three strips use
+	as much RAM as four. The data of the strips is stored one after another in the buffer, i.e. a transfer of size
+	bytes sends size / channelCount bytes to each strip.
+
+	Reference manual:
+		https://infocenter.nordicsemi.com/topic/ps_nrf52840/pwm.html?cp=5_0_0_5_16
+	Resources:
+		PWMx
+	Instantiate LedStrip_PWM_Chunked which contains the LED buffer.
+*/
+class LedStrip_PWM : public BufferDevice {
+public:
+	// maximum number of strips
+	static constexpr int MAX_CHANNEL_COUNT = 4;
+
+	// clock frequency of the PWM in kHz (PRESCALER = DIV_1)
+	static constexpr int CLOCK = 16000;
+
+	using Encoder = LedEncoder_PWM<uint16_t>;
+
+	/**
+		Get the number of values per LED bit that the decoder loads
+		@param channelCount number of channels (strips), 1 - 4
+		@return 1 (common), 2 (grouped) or 4 (individual)
+	*/
+	static constexpr int stepSize(int channelCount) {
+		return channelCount <= 2 ? channelCount : 4;
+	}
+
+protected:
+	/**
+		Constructor
+		@param loop event loop
+		@param pins output pins for the strips
+		@param channelCount number of channels (strips), 1 - 4
+		@param pwm PWM instance to use, e.g. NRF_PWM0
+		@param irq interrupt of the PWM instance, e.g. PWM0_IRQn
+		@param bitTime bit time in ns
+		@param t0h high time of a zero bit in ns
+		@param t1h high time of a one bit in ns
+		@param resetTime reset time in us
+		@param ledBuffer LED buffer for 2 * Encoder::wordCount(chunkSize, stepSize(channelCount)) values
+		@param chunkSize number of bytes of each strip that the interrupt handler encodes at once
+	*/
+	LedStrip_PWM(Loop_Queue &loop, const gpio::Config *pins, int channelCount, NRF_PWM_Type *pwm, int irq,
+		int bitTime, int t0h, int t1h, int resetTime, uint16_t *ledBuffer, int chunkSize);
+public:
+	~LedStrip_PWM() override;
+
+
+	// internal buffer base class, derives from IntrusiveListNode for the list of buffers and Loop_Queue::Handler to be notified from the event loop
+	class BufferBase : public BufferImpl, public IntrusiveListNode, public Loop_Queue::Handler {
+		friend class LedStrip_PWM;
+	public:
+		/**
+			Constructor
+			@param data data of the buffer
+			@param capacity capacity of the buffer
+			@param device led strip device to attach to
+		*/
+		BufferBase(uint8_t *data, int capacity, LedStrip_PWM &device);
+		~BufferBase() override;
+
+		// Buffer methods
+		bool start(Op op) override;
+		bool cancel() override;
+
+	protected:
+		void start();
+		void handle() override;
+
+		LedStrip_PWM &device;
+	};
+
+	/**
+		Buffer for transferring data to the LED strips.
+		@tparam C capacity of buffer, multiple of the number of channels
+	*/
+	template <int C>
+	class Buffer : public BufferBase {
+	public:
+		Buffer(LedStrip_PWM &device) : BufferBase(data, C, device) {}
+
+	protected:
+		alignas(4) uint8_t data[C];
+	};
+
+
+	// Device methods
+	State state() override;
+	[[nodiscard]] Awaitable<Condition> until(Condition condition) override;
+
+	// BufferDevice methods
+	int getBufferCount() override;
+	BufferBase &getBuffer(int index) override;
+
+	/**
+		Get the statistics, only collected if COCO_LEDSTRIP_STATISTICS is defined. An underrun is counted when the interrupt
+		handler was too late to refill a sequence before it started again
+	*/
+	const LedStripStatistics &getStatistics() const {return this->statistics.get();}
+
+	/**
+		Reset the statistics
+	*/
+	void resetStatistics() {this->statistics.reset();}
+
+	/**
+		PWM interrupt handler, needs to be called from the interrupt handler of the PWM instance (e.g. PWM0_IRQHandler())
+	*/
+	void PWM_IRQHandler() {
+		LedStripCounters::Irq irq(this->statistics);
+		auto pwm = this->pwm;
+
+		// both sequences have ended since the last interrupt: a sequence was played again before it was refilled
+		if constexpr (LedStripStatistics::ENABLED) {
+			if (pwm->EVENTS_SEQEND[0] && pwm->EVENTS_SEQEND[1] && this->phase != Phase::STOPPED)
+				this->statistics.underrun();
+		}
+
+		// check if a sequence has ended
+		for (int seq = 0; seq < 2; ++seq) {
+			if (pwm->EVENTS_SEQEND[seq]) {
+				pwm->EVENTS_SEQEND[seq] = 0;
+				handle(seq);
+			}
+		}
+	}
+
+protected:
+	// refill a sequence that has ended
+	void handle(int seq);
+
+	Loop_Queue &loop;
+
+	// pwm
+	NRF_PWM_Type *pwm;
+	int irq;
+	int channelCount;
+
+	// dummy (state is always READY)
+	CoroutineTaskList<Condition> stateTasks;
+
+	// list of buffers
+	IntrusiveList<BufferBase> buffers;
+
+	// list of active transfers
+	nvic::Queue<BufferBase> transfers;
+
+	// sequence values of a zero and a one bit (including polarity bit)
+	uint16_t zero;
+	uint16_t one;
+
+	// data to transfer, the strips are stride bytes apart
+	uint8_t *data;
+	uint8_t *end;
+	int stride;
+
+	// reset after data in PWM periods
+	int resetSteps;
+	int resetCount;
+
+	// number of idle sequences to play when no new data arrives
+	int idleCount;
+
+	// LED buffer that consists of two sequences of Encoder::wordCount(chunkSize, stepSize(channelCount)) values
+	uint16_t *buffer;
+	int chunkSize;
+
+	enum class Phase {
+		// nothing to do, PWM is stopped
+		STOPPED,
+
+		// copy data to the LED buffer
+		COPY,
+
+		// reset LEDs (by sending zeros for the specified Treset time)
+		RESET,
+
+		// notify the main application that a buffer has finished
+		FINISHED,
+
+		// continue sending zeros for a short time before stopping PWM
+		IDLE
+	};
+	Phase phase = Phase::STOPPED;
+
+	// statistics
+	[[no_unique_address]] LedStripCounters statistics;
+};
+
+/**
+	LED strips on the channels of a nrf52 PWM instance with LED buffer. The interrupt handler encodes C bytes of each
+	strip at once, therefore the CPU gets interrupted every C * 10μs for a bit time of 1250ns. RAM usage of the LED
+	buffer is 32 * stepSize(N) bytes per byte of chunk size.
+	@tparam N number of channels (strips), 1 - 4
+	@tparam C chunk size in bytes per strip, e.g. 48 for 16 RGB or 12 RGBW LEDs
+*/
+template <int N, int C = 48>
+class LedStrip_PWM_Chunked : public LedStrip_PWM {
+	// SEQ[n].CNT has 15 bits
+	static_assert(N >= 1 && N <= MAX_CHANNEL_COUNT, "invalid number of channels");
+	static_assert(C > 0 && Encoder::wordCount(C, stepSize(N)) <= 32767, "invalid chunk size");
+protected:
+	LedStrip_PWM_Chunked(Loop_Queue &loop, const std::array<gpio::Config, N> &pins, NRF_PWM_Type *pwm, int irq,
+		int bitTime, int t0h, int t1h, int resetTime)
+		: LedStrip_PWM(loop, pins.data(), N, pwm, irq, bitTime, t0h, t1h, resetTime, ledBuffer, C) {}
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param pins output pins for the strips
+		@param pwm PWM instance to use, e.g. NRF_PWM0
+		@param irq interrupt of the PWM instance, e.g. PWM0_IRQn
+		@param bitTime bit time, e.g. 1250ns
+		@param t0h high time of a zero bit, e.g. 375ns
+		@param t1h high time of a one bit, e.g. 750ns
+		@param resetTime reset time, e.g. 75μs
+	*/
+	LedStrip_PWM_Chunked(Loop_Queue &loop, const std::array<gpio::Config, N> &pins, NRF_PWM_Type *pwm, int irq,
+		Nanoseconds<> bitTime, Nanoseconds<> t0h, Nanoseconds<> t1h, Microseconds<> resetTime)
+		: LedStrip_PWM(loop, pins.data(), N, pwm, irq, bitTime.value, t0h.value, t1h.value, resetTime.value,
+			ledBuffer, C) {}
+
+protected:
+	uint16_t ledBuffer[2 * Encoder::wordCount(C, stepSize(N))];
+};
+
+} // namespace coco
@@ -0,0 +1,201 @@
+#include "LedStrip_Parallel_TIM_DMA.hpp"
+
+
+namespace coco {
+
+// LedStrip_Parallel_TIM_DMA
+
+LedStrip_Parallel_TIM_DMA::LedStrip_Parallel_TIM_DMA(Loop_Queue &loop, GPIO_TypeDef *port, int firstPin,
+	const timer::Info &timerInfo, const dma::Info &dmaInfo, const TimerDma &timerDma, int arr, int resetCount,
+	uint8_t *ledBuffer, int chunkSize)
+	: loop(loop)
+	, timer(timerInfo.timer)
+	, dmaIrq(dmaInfo.irq), dmaChannel(timerDma)
+	, resetCount(resetCount)
+	, buffer(ledBuffer), chunkSize(chunkSize)
+{
+	assert(firstPin == 0 || firstPin == 8);
+
+	// enable clocks (note two cycles wait time until peripherals can be accessed, see STM32G4 reference manual section 7.2.17)
+	timerInfo.rcc.enableClock();
+	dmaInfo.rcc.enableClock();
+
+	// configure pins as outputs with very high speed, initial state is low
+	uint32_t mask = 0xffff << (firstPin * 2);
+	port->BSRR = 0xff << (firstPin + 16);
+	port->OSPEEDR = port->OSPEEDR | mask;
+	port->MODER = (port->MODER & ~mask) | (0x5555 << (firstPin * 2));
+
+	// initialize timer, update event triggers a DMA request three times per LED bit
+	auto timer = this->timer;
+	timer->PSC = 0;
+	timer->ARR = arr;
+	timer->DIER = TIM_DIER_UDE;
+
+	// initialize DMA channel, writes one byte to the upper or lower half of the output data register
+	this->dmaStatus = dmaInfo.status();
+	timerDma.stop();
+	timerDma.setPeripheralAddress(reinterpret_cast<volatile uint8_t *>(&port->ODR) + firstPin / 8);
+
+	// map DMA to timer update
+	timerDma.map();
+
+	nvic::setPriority(this->dmaIrq, nvic::Priority::MEDIUM);
+	nvic::enable(this->dmaIrq);
+}
+
+LedStrip_Parallel_TIM_DMA::~LedStrip_Parallel_TIM_DMA() {
+}
+
+BufferDevice::State LedStrip_Parallel_TIM_DMA::state() {
+	return State::READY;
+}
+
+Awaitable<Device::Condition> LedStrip_Parallel_TIM_DMA::until(Condition condition) {
+	// check if IN_* condition is met
+	if ((int(condition) >> int(State::READY)) & 1)
+		return {}; // don't wait
+	return {this->stateTasks, condition};
+}
+
+int LedStrip_Parallel_TIM_DMA::getBufferCount() {
+	return this->buffers.count();
+}
+
+LedStrip_Parallel_TIM_DMA::BufferBase &LedStrip_Parallel_TIM_DMA::getBuffer(int index) {
+	return this->buffers.get(index);
+}
+
+void LedStrip_Parallel_TIM_DMA::handle() {
+	auto timer = this->timer;
+	auto dmaChannel = this->dmaChannel;
+
+	// disable DMA
+	dmaChannel.stop();
+
+	// clear interrupt flag
+	this->dmaStatus.clear(dma::Status::Flags::TRANSFER_COMPLETE);
+
+	switch (this->phase) {
+	case Phase::COPY:
+		{
+			// source data
+			uint8_t *src = this->data;
+			int count = std::min(int(this->end - src), this->chunkSize);
+
+			// bit-slice the data of the strips into the LED buffer, the last word of each LED bit is zero so that the
+			// strips stay low while the interrupt handler runs
+			Encoder::encode(src, this->stride, count, {this->buffer, this->buffer + Encoder::wordCount(count)});
+
+			// start DMA
+			dmaChannel.start(this->buffer, Encoder::wordCount(count), DMA_CCR_MINC | DMA_CCR_TCIE);
+
+			// advance source data pointer
+			this->data = src + count;
+			this->statistics.encoded(count * STRIP_COUNT);
+
+			// go to reset phase if there is no more data
+			if (this->data >= this->end)
+				this->phase = Phase::RESET;
+		}
+		break;
+	case Phase::RESET:
+		{
+			// dummy DMA transfer of a zero word of the LED buffer to measure reset time
+			dmaChannel.start(this->buffer + 2, this->resetCount, DMA_CCR_TCIE);
+
+			// go to finished phase
+			this->phase = Phase::FINISHED;
+		}
+		break;
+	case Phase::FINISHED:
+		{
+			// stop timer
+			timer->CR1 = 0;
+			this->phase = Phase::STOPPED;
+
+			this->transfers.pop(
+				[this](BufferBase &buffer) {
+					// push finished transfer buffer to event loop so that BufferBase::handle() gets called from the event loop
+					this->statistics.frame();
+					this->loop.push(buffer);
+					return true;
+				},
+				[](BufferBase &next) {
+					// start next transfer if there is one
+					next.start();
+				}
+			);
+		}
+		break;
+	default:
+		;
+	}
+}
+
+
+// BufferBase
+
+LedStrip_Parallel_TIM_DMA::BufferBase::BufferBase(uint8_t *data, int capacity, LedStrip_Parallel_TIM_DMA &device)
+	: BufferImpl(data, capacity, BufferBase::State::READY), device(device)
+{
+	device.buffers.add(*this);
+}
+
+LedStrip_Parallel_TIM_DMA::BufferBase::~BufferBase() {
+}
+
+bool LedStrip_Parallel_TIM_DMA::BufferBase::start(Op op) {
+	if (this->p.state != State::READY) {
+		assert(this->p.state != State::BUSY);
+		return false;
+	}
+
+	// check if READ or WRITE flag is set and the size is a multiple of the number of strips
+	assert((op & Op::READ_WRITE) != 0);
+	assert(this->p.size % STRIP_COUNT == 0);
+
+	// add to list of pending transfers and start immediately if list was empty
+	if (this->device.transfers.push(this->device.dmaIrq, *this))
+		start();
+
+	// set state
+	setBusy();
+
+	return true;
+}
+
+bool LedStrip_Parallel_TIM_DMA::BufferBase::cancel() {
+	if (this->p.state != State::BUSY)
+		return false;
+	auto &device = this->device;
+
+	// remove from pending transfers if not yet started, otherwise complete normally
+	if (device.transfers.remove(device.dmaIrq, *this, false))
+		setReady(0);
+
+	return true;
+}
+
+void LedStrip_Parallel_TIM_DMA::BufferBase::start() {
+	auto &device = this->device;
+
+	// set data of first strip
+	int stride = this->p.size / STRIP_COUNT;
+	device.data = this->p.data;
+	device.end = this->p.data + stride;
+	device.stride = stride;
+
+	// start
+	device.phase = Phase::COPY;
+	device.handle();
+
+	// start timer
+	device.timer->CR1 = TIM_CR1_CEN;
+}
+
+void LedStrip_Parallel_TIM_DMA::BufferBase::handle() {
+	setReady();
+}
+
+} // namespace coco
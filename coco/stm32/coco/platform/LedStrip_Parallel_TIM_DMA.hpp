@@ -0,0 +1,245 @@
+#pragma once
+
+#include <coco/BufferDevice.hpp>
+#include <coco/BufferImpl.hpp>
+#include <coco/Frequency.hpp>
+#include <coco/LedEncoder.hpp>
+#include <coco/LedStripStatistics.hpp>
+#include <coco/platform/Loop_Queue.hpp>
+#include <coco/platform/TimerDma.hpp>
+#include <coco/platform/dma.hpp>
+#include <coco/platform/timer.hpp>
+#include <coco/platform/nvic.hpp>
+
+
+namespace coco {
+
+/**
+	Implementation of LED strip interface on stm32 for 8 LED strips in parallel on pins 0-7 or 8-15 of a GPIO port.
+	A timer triggers a DMA transfer to the output data register of the port three times per LED bit, the data of the
+	strips gets bit-sliced using LedEncoder_Parallel<8>. Use two instances on the same port for 16 strips.
+	The data of the strips is stored one after another in the buffer, i.e. a transfer of size bytes sends size / 8
+	bytes to each strip.
+
+	Reference manual:
+		g4:
+			https://www.st.com/resource/en/reference_manual/rm0440-stm32g4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+				GPIO: Section 9
+				DMA: Section 12
+				DMAMUX: Section 13
+				TIM1/TIM8: Section 28
+	Resources:
+		GPIO port (8 pins)
+		TIMx
+		DMA
+	Instantiate LedStrip_Parallel_TIM_DMA_Chunked which contains the LED buffer.
+*/
+class LedStrip_Parallel_TIM_DMA : public BufferDevice {
+public:
+	// number of strips
+	static constexpr int STRIP_COUNT = 8;
+
+	using Encoder = LedEncoder_Parallel<STRIP_COUNT>;
+
+protected:
+	/**
+		Constructor
+		@param loop event loop
+		@param port GPIO port
+		@param firstPin first pin of the strips, 0 for pins 0-7 or 8 for pins 8-15
+		@param timerInfo info of timer instance to use
+		@param dmaInfo info of DMA channel to use
+		@param timerDma registers and timer update request of the same DMA channel
+		@param arr auto reload value of the timer, i.e. timer clock cycles per third of a bit minus one (see calcArr())
+		@param resetCount number of timer periods for the reset time (see calcResetCount())
+		@param ledBuffer LED buffer for Encoder::wordCount(chunkSize) bytes
+		@param chunkSize number of bytes of each strip that the interrupt handler encodes at once
+	*/
+	LedStrip_Parallel_TIM_DMA(Loop_Queue &loop, GPIO_TypeDef *port, int firstPin, const timer::Info &timerInfo,
+		const dma::Info &dmaInfo, const TimerDma &timerDma, int arr, int resetCount, uint8_t *ledBuffer, int chunkSize);
+public:
+	~LedStrip_Parallel_TIM_DMA() override;
+
+	/**
+		Calculate the auto reload value of the timer so that the timer period is a third of the bit time
+		@param clock timer clock frequency in kHz
+		@param bitTime bit time in ns
+		@return auto reload value
+	*/
+	static constexpr int calcArr(int clock, int bitTime) {
+		return int((int64_t(clock) * bitTime + 1500000) / 3000000) - 1;
+	}
+
+	/**
+		Calculate the number of timer periods that take at least the reset time
+		@param clock timer clock frequency in kHz
+		@param arr auto reload value
+		@param resetTime reset time in us
+		@return number of timer periods
+	*/
+	static constexpr int calcResetCount(int clock, int arr, int resetTime) {
+		return int(int64_t(clock) * resetTime / ((arr + 1) * 1000)) + 1;
+	}
+
+
+	// internal buffer base class, derives from IntrusiveListNode for the list of buffers and Loop_Queue::Handler to be notified from the event loop
+	class BufferBase : public BufferImpl, public IntrusiveListNode, public Loop_Queue::Handler {
+		friend class LedStrip_Parallel_TIM_DMA;
+	public:
+		/**
+			Constructor
+			@param data data of the buffer
+			@param capacity capacity of the buffer
+			@param device led strip device to attach to
+		*/
+		BufferBase(uint8_t *data, int capacity, LedStrip_Parallel_TIM_DMA &device);
+		~BufferBase() override;
+
+		// Buffer methods
+		bool start(Op op) override;
+		bool cancel() override;
+
+	protected:
+		void start();
+		void handle() override;
+
+		LedStrip_Parallel_TIM_DMA &device;
+	};
+
+	/**
+		Buffer for transferring data to the LED strips.
+		@tparam C capacity of buffer, multiple of 8
+	*/
+	template <int C>
+	class Buffer : public BufferBase {
+		static_assert(C % STRIP_COUNT == 0, "capacity must be a multiple of the number of strips");
+	public:
+		Buffer(LedStrip_Parallel_TIM_DMA &device) : BufferBase(data, C, device) {}
+
+	protected:
+		alignas(4) uint8_t data[C];
+	};
+
+
+	// Device methods
+	State state() override;
+	[[nodiscard]] Awaitable<Condition> until(Condition condition) override;
+
+	// BufferDevice methods
+	int getBufferCount() override;
+	BufferBase &getBuffer(int index) override;
+
+	/**
+		Get the statistics, only collected if COCO_LEDSTRIP_STATISTICS is defined. The LED strip pauses while the
+		interrupt handler refills the LED buffer, therefore no underruns are counted
+	*/
+	const LedStripStatistics &getStatistics() const {return this->statistics.get();}
+
+	/**
+		Reset the statistics
+	*/
+	void resetStatistics() {this->statistics.reset();}
+
+	/**
+		DMA interrupt handler, needs to be called from DMA channel interrupt handler (e.g. DMA1_Channel1_IRQHandler() for dma::DMA1_CH1_INFO on STM32G4)
+	*/
+	void DMA_IRQHandler() {
+		LedStripCounters::Irq irq(this->statistics);
+
+		// check if transfer has completed
+		if ((this->dmaStatus.get() & dma::Status::Flags::TRANSFER_COMPLETE) != 0)
+			handle();
+	}
+
+protected:
+	void handle();
+
+	Loop_Queue &loop;
+
+	// timer
+	TIM_TypeDef *timer;
+
+	// dma
+	int dmaIrq;
+	dma::Status dmaStatus;
+	TimerDma dmaChannel;
+
+	// dummy (state is always READY)
+	CoroutineTaskList<Condition> stateTasks;
+
+	// list of buffers
+	IntrusiveList<BufferBase> buffers;
+
+	// list of active transfers
+	nvic::Queue<BufferBase> transfers;
+
+	// data to transfer, the strips are stride bytes apart
+	uint8_t *data;
+	uint8_t *end;
+	int stride;
+
+	// reset after data
+	int resetCount;
+
+	// LED buffer for chunkSize bytes of each strip (24 bytes per byte)
+	uint8_t *buffer;
+	int chunkSize;
+
+	enum class Phase {
+		// nothing to do, timer is stopped
+		STOPPED,
+
+		// copy data to the LED buffer
+		COPY,
+
+		// reset LEDs (by sending zeros for the specified Treset time)
+		RESET,
+
+		// notify the main application that a buffer has finished
+		FINISHED
+	};
+	Phase phase = Phase::STOPPED;
+
+	// statistics
+	[[no_unique_address]] LedStripCounters statistics;
+};
+
+/**
+	Parallel LED strips on stm32 with LED buffer. The interrupt handler encodes C bytes of each strip at once, therefore
+	the CPU gets interrupted every C * 8 bit times, e.g. every C * 9μs for a bit time of 1125ns. RAM usage of the LED
+	buffer is 24 bytes per byte of chunk size.
+	@tparam C chunk size in bytes per strip, e.g. 16 for 16 RGB or 4 RGBW LEDs
+*/
+template <int C = 16>
+class LedStrip_Parallel_TIM_DMA_Chunked : public LedStrip_Parallel_TIM_DMA {
+	// DMA transfer count is limited to 16 bit
+	static_assert(C > 0 && Encoder::wordCount(C) <= 65535, "invalid chunk size");
+protected:
+	LedStrip_Parallel_TIM_DMA_Chunked(Loop_Queue &loop, GPIO_TypeDef *port, int firstPin,
+		const timer::Info &timerInfo, const dma::Info &dmaInfo, const TimerDma &timerDma, int arr, int resetCount)
+		: LedStrip_Parallel_TIM_DMA(loop, port, firstPin, timerInfo, dmaInfo, timerDma, arr, resetCount, ledBuffer, C)
+	{}
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param port GPIO port, e.g. GPIOB
+		@param firstPin first pin of the strips, 0 for pins 0-7 or 8 for pins 8-15
+		@param timerInfo info of timer instance to use
+		@param dmaInfo info of DMA channel to use
+		@param timerDma registers and timer update request of the same DMA channel
+		@param clock timer clock frequency (e.g. APB2_TIMER_CLOCK for TIM1)
+		@param bitTime bit time, e.g. T = 1125ns (T0H = 375ns, T1H = 750ns)
+		@param resetTime reset time in us, e.g. 75μs
+	*/
+	LedStrip_Parallel_TIM_DMA_Chunked(Loop_Queue &loop, GPIO_TypeDef *port, int firstPin,
+		const timer::Info &timerInfo, const dma::Info &dmaInfo, const TimerDma &timerDma, Kilohertz<> clock,
+		Nanoseconds<> bitTime, Microseconds<> resetTime)
+		: LedStrip_Parallel_TIM_DMA(loop, port, firstPin, timerInfo, dmaInfo, timerDma, calcArr(clock.value, bitTime.value),
+		calcResetCount(clock.value, calcArr(clock.value, bitTime.value), resetTime.value), ledBuffer, C) {}
+
+protected:
+	uint8_t ledBuffer[Encoder::wordCount(C)];
+};
+
+} // namespace coco
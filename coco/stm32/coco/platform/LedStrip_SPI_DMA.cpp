@@ -0,0 +1,210 @@
+#include "LedStrip_SPI_DMA.hpp"
+#include <cstring>
+
+
+namespace coco {
+
+// LedStrip_SPI_DMA
+
+LedStrip_SPI_DMA::LedStrip_SPI_DMA(Loop_Queue &loop, gpio::Config mosiPin, const spi::Info &spiInfo,
+	const dma::Info &dmaInfo, int prescaler, int symbolBits, int resetCount, uint8_t *ledBuffer, int chunkSize)
+	: loop(loop)
+	, spi(spiInfo.spi)
+	, dmaIrq(dmaInfo.irq)
+	, encode(symbolBits == 4 ? &LedEncoder_SPI<4>::encode : &LedEncoder_SPI<3>::encode)
+	, symbolBits(symbolBits)
+	, buffer(ledBuffer), chunkSize(chunkSize)
+{
+	assert(symbolBits == 3 || symbolBits == 4);
+
+	// the reset time is generated by halves of the LED buffer that contain only zeros
+	int halfSize = symbolBits * chunkSize;
+	this->resetHalves = (resetCount + halfSize - 1) / halfSize;
+
+	// enable clocks (note two cycles wait time until peripherals can be accessed, see STM32G4 reference manual section 7.2.17)
+	spiInfo.rcc.enableClock();
+	dmaInfo.rcc.enableClock();
+
+	// configure MOSI pin, SPI drives it low when idle as the last bits of a transfer are always zero
+	gpio::setOutput(mosiPin, false);
+	gpio::configureAlternate(mosiPin);
+
+	// initialize SPI
+	auto spi = spiInfo.spi;
+	spi->CR2 = (7 << SPI_CR2_DS_Pos) // 8 bit
+		| SPI_CR2_TXDMAEN; // TX DMA mode
+	spi->CR1 = SPI_CR1_MSTR // master
+		| SPI_CR1_SSM | SPI_CR1_SSI // software slave management, no NSS pin
+		| SPI_CR1_BIDIMODE | SPI_CR1_BIDIOE // transmit only on MOSI
+		| (prescaler << SPI_CR1_BR_Pos); // baud rate
+
+	// initialize TX DMA channel
+	this->dmaStatus = dmaInfo.status();
+	this->dmaChannel = dmaInfo.channel();
+	this->dmaChannel.setPeripheralAddress(&spi->DR);
+
+	// map DMA to SPI TX
+	spiInfo.mapTx(dmaInfo);
+
+	// enable SPI
+	spi->CR1 = spi->CR1 | SPI_CR1_SPE;
+
+	// clear LED buffer
+	std::memset(ledBuffer, 0, 2 * halfSize);
+	this->zero[0] = true;
+	this->zero[1] = true;
+
+	nvic::setPriority(dmaInfo.irq, nvic::Priority::MEDIUM);
+	nvic::enable(dmaInfo.irq);
+}
+
+LedStrip_SPI_DMA::~LedStrip_SPI_DMA() {
+}
+
+BufferDevice::State LedStrip_SPI_DMA::state() {
+	return State::READY;
+}
+
+Awaitable<Device::Condition> LedStrip_SPI_DMA::until(Condition condition) {
+	// check if IN_* condition is met
+	if ((int(condition) >> int(State::READY)) & 1)
+		return {}; // don't wait
+	return {this->stateTasks, condition};
+}
+
+int LedStrip_SPI_DMA::getBufferCount() {
+	return this->buffers.count();
+}
+
+LedStrip_SPI_DMA::BufferBase &LedStrip_SPI_DMA::getBuffer(int index) {
+	return this->buffers.get(index);
+}
+
+void LedStrip_SPI_DMA::fill(int half) {
+	int halfSize = this->symbolBits * this->chunkSize;
+	uint8_t *dst = this->buffer + half * halfSize;
+	uint8_t *src = this->data;
+	if (src < this->end) {
+		// encode next chunk and pad with zeros which extend the low time of the last bit
+		uint8_t *end = std::min(src + this->chunkSize, this->end);
+		int count = this->encode({src, end}, {dst, dst + halfSize}) * this->symbolBits;
+		std::memset(dst + count, 0, halfSize - count);
+		this->zero[half] = false;
+		this->data = end;
+		this->statistics.encoded(end - src);
+	} else if (!this->zero[half]) {
+		// clear for the reset time, only once as long as the half contains only zeros
+		std::memset(dst, 0, halfSize);
+		this->zero[half] = true;
+	}
+}
+
+void LedStrip_SPI_DMA::handle() {
+	if (this->phase != Phase::RUNNING)
+		return;
+
+	// the half that has been sent
+	int half = this->sentHalves & 1;
+	++this->sentHalves;
+
+	// refill the half while the other half gets sent
+	if (this->sentHalves < this->halfCount) {
+		fill(half);
+		return;
+	}
+
+	// data and reset time have been sent, the DMA has already started to send the other half which contains zeros
+	this->dmaChannel.disable();
+	this->phase = Phase::STOPPED;
+
+	this->transfers.pop(
+		[this](BufferBase &buffer) {
+			// push finished transfer buffer to event loop so that BufferBase::handle() gets called from the event loop
+			this->statistics.frame();
+			this->loop.push(buffer);
+			return true;
+		},
+		[](BufferBase &next) {
+			// start next transfer if there is one
+			next.start();
+		}
+	);
+}
+
+
+// BufferBase
+
+LedStrip_SPI_DMA::BufferBase::BufferBase(uint8_t *data, int size, LedStrip_SPI_DMA &device)
+	: BufferImpl(data, size, BufferBase::State::READY), device(device)
+{
+	device.buffers.add(*this);
+}
+
+LedStrip_SPI_DMA::BufferBase::~BufferBase() {
+}
+
+bool LedStrip_SPI_DMA::BufferBase::start(Op op) {
+	if (this->p.state != State::READY) {
+		assert(this->p.state != State::BUSY);
+		return false;
+	}
+	auto &device = this->device;
+
+	// check if READ or WRITE flag is set
+	assert((op & Op::READ_WRITE) != 0);
+
+	// add to list of pending transfers and start immediately if list was empty
+	if (device.transfers.push(device.dmaIrq, *this))
+		start();
+
+	// set state
+	setBusy();
+
+	return true;
+}
+
+bool LedStrip_SPI_DMA::BufferBase::cancel() {
+	if (this->p.state != State::BUSY)
+		return false;
+	auto &device = this->device;
+
+	// remove from pending transfers if not yet started, otherwise complete normally
+	if (device.transfers.remove(device.dmaIrq, *this, false))
+		setReady(0);
+
+	return true;
+}
+
+void LedStrip_SPI_DMA::BufferBase::start() {
+	auto &device = this->device;
+	int chunkSize = device.chunkSize;
+
+	// set data
+	device.data = this->p.data;
+	device.end = this->p.data + this->p.size;
+
+	// number of halves for the data and the reset time
+	device.halfCount = (int(this->p.size) + chunkSize - 1) / chunkSize + device.resetHalves;
+	device.sentHalves = 0;
+
+	// fill both halves of the LED buffer
+	device.fill(0);
+	device.fill(1);
+
+	// start circular DMA, an interrupt occurs when a half has been sent
+	auto dmaChannel = device.dmaChannel;
+	dmaChannel.setMemoryAddress(device.buffer);
+	dmaChannel.setCount(2 * device.symbolBits * chunkSize);
+	device.dmaStatus.clear(dma::Status::Flags::ALL);
+	device.phase = Phase::RUNNING;
+	dmaChannel.enable(dma::Channel::Config::TX
+		| dma::Channel::Config::CIRCULAR
+		| dma::Channel::Config::HALF_TRANSFER_INTERRUPT
+		| dma::Channel::Config::TRANSFER_COMPLETE_INTERRUPT);
+}
+
+void LedStrip_SPI_DMA::BufferBase::handle() {
+	setReady();
+}
+
+} // namespace coco
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <coco/BufferDevice.hpp>
+#include <coco/BufferImpl.hpp>
+#include <coco/Frequency.hpp>
+#include <coco/LedEncoder.hpp>
+#include <coco/LedStripStatistics.hpp>
+#include <coco/platform/Loop_Queue.hpp>
+#include <coco/platform/dma.hpp>
+#include <coco/platform/gpio.hpp>
+#include <coco/platform/spi.hpp>
+#include <coco/platform/nvic.hpp>
+
+
+namespace coco {
+
+/**
+	Implementation of LED strip interface on stm32 using SPIx. Each LED bit is sent as 3 or 4 SPI bits (see
+	LedEncoder_SPI) on MOSI, the other SPI pins are not used. The DMA runs in circular mode over two halves of the LED
+	buffer, when a half has been sent (half transfer and transfer complete interrupt), the interrupt handler encodes the
+	next chunk of LED data into it while the other half gets sent. The reset is generated by sending zeros, therefore
+	no pin mode changes are needed and the UARTs stay free.
+
+	The SPI clock is the peripheral clock divided by a power of two (2 - 256), therefore only some combinations of
+	clock and symbol bits meet the timing of the LEDs, e.g. 170MHz / 64 with 3 symbol bits gives T = 1129ns, T0H = 376ns
+	and T1H = 753ns. Check with calcBitTime().
+
+	Reference manual:
+		g4:
+			https://www.st.com/resource/en/reference_manual/rm0440-stm32g4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+				SPI: Section 39
+				DMA: Section 12
+				DMAMUX: Section 13
+	Data sheet:
+		g4:
+			https://www.st.com/resource/en/datasheet/stm32g431rb.pdf
+				Alternate Functions: Section 4.11, Table 13, Page 61
+	Resources:
+		SPIx
+		DMA
+	Instantiate LedStrip_SPI_DMA_Chunked which contains the LED buffer.
+*/
+class LedStrip_SPI_DMA : public BufferDevice {
+protected:
+	/**
+		Constructor
+		@param loop event loop
+		@param mosiPin MOSI pin and alternative function (see data sheet)
+		@param spiInfo info of SPI instance to use
+		@param dmaInfo info of DMA channel to use
+		@param prescaler baud rate prescaler, BR field of SPI_CR1 (see calcPrescaler())
+		@param symbolBits number of SPI bits per LED bit, 3 or 4
+		@param resetCount number of zero bytes for the reset time (see calcResetCount())
+		@param ledBuffer LED buffer for 2 * symbolBits * chunkSize bytes
+		@param chunkSize number of bytes of LED data that the interrupt handler encodes at once
+	*/
+	LedStrip_SPI_DMA(Loop_Queue &loop, gpio::Config mosiPin, const spi::Info &spiInfo, const dma::Info &dmaInfo,
+		int prescaler, int symbolBits, int resetCount, uint8_t *ledBuffer, int chunkSize);
+public:
+	~LedStrip_SPI_DMA() override;
+
+	/**
+		Calculate the baud rate prescaler so that symbolBits SPI bits take the bit time as close as possible
+		@param clock peripheral clock frequency in kHz
+		@param bitTime bit time in ns
+		@param symbolBits number of SPI bits per LED bit, 3 or 4
+		@return value of BR field of SPI_CR1, the clock gets divided by 2 << BR
+	*/
+	static constexpr int calcPrescaler(int clock, int bitTime, int symbolBits) {
+		// find the divider with the smallest relative error
+		int64_t target = int64_t(clock) * bitTime;
+		int best = 0;
+		for (int br = 1; br < 8; ++br) {
+			int64_t time = int64_t(symbolBits) * (2 << br) * 1000000;
+			int64_t bestTime = int64_t(symbolBits) * (2 << best) * 1000000;
+			if (time * bestTime < target * target)
+				best = br;
+		}
+		return best;
+	}
+
+	/**
+		Calculate the resulting bit time
+		@param clock peripheral clock frequency in kHz
+		@param prescaler value of BR field of SPI_CR1
+		@param symbolBits number of SPI bits per LED bit
+		@return bit time in ns
+	*/
+	static constexpr int calcBitTime(int clock, int prescaler, int symbolBits) {
+		return int(int64_t(symbolBits) * (2 << prescaler) * 1000000 / clock);
+	}
+
+	/**
+		Calculate the number of zero bytes that take at least the reset time
+		@param clock peripheral clock frequency in kHz
+		@param prescaler value of BR field of SPI_CR1
+		@param resetTime reset time in us
+		@return number of bytes
+	*/
+	static constexpr int calcResetCount(int clock, int prescaler, int resetTime) {
+		return int(int64_t(clock) * resetTime / ((2 << prescaler) * 8000)) + 1;
+	}
+
+
+	// internal buffer base class, derives from IntrusiveListNode for the list of buffers and Loop_Queue::Handler to be notified from the event loop
+	class BufferBase : public BufferImpl, public IntrusiveListNode, public Loop_Queue::Handler {
+		friend class LedStrip_SPI_DMA;
+	public:
+		/**
+			Constructor
+			@param data data of the buffer
+			@param capacity capacity of the buffer
+			@param channel channel to attach to
+		*/
+		BufferBase(uint8_t *data, int size, LedStrip_SPI_DMA &device);
+		~BufferBase() override;
+
+		// Buffer methods
+		bool start(Op op) override;
+		bool cancel() override;
+
+	protected:
+		void start();
+		void handle() override;
+
+		LedStrip_SPI_DMA &device;
+	};
+
+	/**
+		Buffer for transferring data over SPI.
+		@tparam C capacity of buffer
+	*/
+	template <int C>
+	class Buffer : public BufferBase {
+	public:
+		Buffer(LedStrip_SPI_DMA &device) : BufferBase(data, C, device) {}
+
+	protected:
+		alignas(4) uint8_t data[C];
+	};
+
+
+	// Device methods
+	State state() override;
+	[[nodiscard]] Awaitable<Condition> until(Condition condition) override;
+
+	// BufferDevice methods
+	int getBufferCount() override;
+	BufferBase &getBuffer(int index) override;
+
+	/**
+		Get the statistics, only collected if COCO_LEDSTRIP_STATISTICS is defined. An underrun is counted when the
+		interrupt handler was too late to refill a half of the LED buffer before it was sent again
+	*/
+	const LedStripStatistics &getStatistics() const {return this->statistics.get();}
+
+	/**
+		Reset the statistics
+	*/
+	void resetStatistics() {this->statistics.reset();}
+
+	/**
+		DMA interrupt handler, needs to be called from DMA channel interrupt handler (e.g. DMA1_Channel1_IRQHandler() for dma::DMA1_CH1_INFO on STM32G4)
+	*/
+	void DMA_IRQHandler() {
+		LedStripCounters::Irq irq(this->statistics);
+
+		// both halves have been sent since the last interrupt: a half was sent again before it was refilled
+		if constexpr (LedStripStatistics::ENABLED) {
+			auto status = this->dmaStatus.get();
+			if ((status & dma::Status::Flags::HALF_TRANSFER) != 0
+				&& (status & dma::Status::Flags::TRANSFER_COMPLETE) != 0 && this->phase == Phase::RUNNING)
+			{
+				this->statistics.underrun();
+			}
+		}
+
+		// first half has been sent
+		if ((this->dmaStatus.get() & dma::Status::Flags::HALF_TRANSFER) != 0) {
+			this->dmaStatus.clear(dma::Status::Flags::HALF_TRANSFER);
+			handle();
+		}
+
+		// second half has been sent (read status again as handle() clears it when it starts the next transfer)
+		if ((this->dmaStatus.get() & dma::Status::Flags::TRANSFER_COMPLETE) != 0) {
+			this->dmaStatus.clear(dma::Status::Flags::TRANSFER_COMPLETE);
+			handle();
+		}
+	}
+
+protected:
+	// fill a half of the LED buffer with the next chunk of LED data or with zeros at the end of the data
+	void fill(int half);
+
+	void handle();
+
+	Loop_Queue &loop;
+
+	// spi
+	SPI_TypeDef *spi;
+
+	// dma
+	int dmaIrq;
+	dma::Status dmaStatus;
+	dma::Channel dmaChannel;
+
+	// dummy (state is always READY)
+	CoroutineTaskList<Condition> stateTasks;
+
+	// list of buffers
+	IntrusiveList<BufferBase> buffers;
+
+	// list of active transfers
+	nvic::Queue<BufferBase> transfers;
+
+	// encoder
+	int (*encode)(std::span<const uint8_t>, std::span<uint8_t>);
+	int symbolBits;
+
+	// data to transfer
+	uint8_t *data;
+	uint8_t *end;
+
+	// number of halves that are sent after the data for the reset time
+	int resetHalves;
+
+	// number of halves of the current transfer and number of halves that have been sent
+	int halfCount;
+	int sentHalves;
+
+	// LED buffer that consists of two halves of symbolBits * chunkSize bytes
+	uint8_t *buffer;
+	int chunkSize;
+
+	// true if a half of the LED buffer contains only zeros
+	bool zero[2];
+
+	enum class Phase {
+		// nothing to do, DMA is stopped
+		STOPPED,
+
+		// DMA runs, the halves get refilled with LED data and zeros for the reset
+		RUNNING
+	};
+	Phase phase = Phase::STOPPED;
+
+	// statistics
+	[[no_unique_address]] LedStripCounters statistics;
+};
+
+/**
+	LED strip on stm32 using SPIx with LED buffer. The interrupt handler encodes C bytes of LED data at once, therefore
+	the CPU gets interrupted every C * 8 bit times (the bit time is rounded to the SPI clock, see calcBitTime()). The LED
+	buffer takes 2 * 4 * C bytes of RAM to support 3 and 4 symbol bits.
+	@tparam C chunk size in bytes of LED data, e.g. 48 for 16 RGB or 12 RGBW LEDs
+*/
+template <int C = 48>
+class LedStrip_SPI_DMA_Chunked : public LedStrip_SPI_DMA {
+	// DMA transfer count is limited to 16 bit
+	static_assert(C > 0 && 2 * 4 * C <= 65535, "invalid chunk size");
+protected:
+	LedStrip_SPI_DMA_Chunked(Loop_Queue &loop, gpio::Config mosiPin, const spi::Info &spiInfo,
+		const dma::Info &dmaInfo, int prescaler, int symbolBits, int resetCount)
+		: LedStrip_SPI_DMA(loop, mosiPin, spiInfo, dmaInfo, prescaler, symbolBits, resetCount, ledBuffer, C) {}
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param mosiPin MOSI pin and alternative function (see data sheet)
+		@param spiInfo info of SPI instance to use
+		@param dmaInfo info of DMA channel to use
+		@param clock peripheral clock frequency (SPI1, SPI4: APB2_CLOCK, SPI2, SPI3: APB1_CLOCK)
+		@param bitTime bit time, gets rounded to the nearest possible SPI clock (see calcBitTime())
+		@param resetTime reset time
+		@param symbolBits number of SPI bits per LED bit, 3 or 4
+	*/
+	LedStrip_SPI_DMA_Chunked(Loop_Queue &loop, gpio::Config mosiPin, const spi::Info &spiInfo,
+		const dma::Info &dmaInfo, Kilohertz<> clock, Nanoseconds<> bitTime, Microseconds<> resetTime,
+		int symbolBits = 3)
+		: LedStrip_SPI_DMA(loop, mosiPin, spiInfo, dmaInfo, calcPrescaler(clock.value, bitTime.value, symbolBits),
+		symbolBits, calcResetCount(clock.value, calcPrescaler(clock.value, bitTime.value, symbolBits),
+		resetTime.value), ledBuffer, C) {}
+
+protected:
+	uint8_t ledBuffer[2 * 4 * C];
+};
+
+} // namespace coco
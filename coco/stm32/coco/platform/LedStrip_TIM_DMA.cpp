@@ -0,0 +1,228 @@
+#include "LedStrip_TIM_DMA.hpp"
+#include <cstddef>
+#include <cstring>
+
+
+namespace coco {
+
+// LedStrip_TIM_DMA
+
+LedStrip_TIM_DMA::LedStrip_TIM_DMA(Loop_Queue &loop, const gpio::Config *pins, int channelCount,
+	const timer::Info &timerInfo, const dma::Info &dmaInfo, const TimerDma &timerDma, int arr, int zero, int one,
+	int resetCount, uint8_t *ledBuffer, int chunkSize)
+	: loop(loop)
+	, timer(timerInfo.timer), channelCount(channelCount)
+	, dmaIrq(dmaInfo.irq), dmaChannel(timerDma)
+	, zero(zero), one(one)
+	, buffer(ledBuffer), chunkSize(chunkSize)
+{
+	assert(channelCount >= 1 && channelCount <= MAX_CHANNEL_COUNT);
+	assert(zero < one && one <= 255 && one <= arr);
+
+	// the reset time is generated by halves of the LED buffer that contain only zeros
+	int periodCount = Encoder::wordCount(chunkSize);
+	this->resetHalves = (resetCount + periodCount - 1) / periodCount;
+
+	// enable clocks (note two cycles wait time until peripherals can be accessed, see STM32G4 reference manual section 7.2.17)
+	timerInfo.rcc.enableClock();
+	dmaInfo.rcc.enableClock();
+
+	// initialize timer, update event triggers a DMA burst once per LED bit
+	auto timer = this->timer;
+	timer->PSC = 0;
+	timer->ARR = arr;
+	uint32_t ccmr[2] = {0, 0};
+	uint32_t ccer = 0;
+	for (int i = 0; i < channelCount; ++i) {
+		auto pin = pins[i];
+
+		// configure pin, initial state is low
+		gpio::setOutput(pin, false);
+		gpio::configureAlternate(pin);
+
+		// PWM mode 1 with preload, a new compare value takes effect at the next update event
+		ccmr[i >> 1] |= (TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1PE) << ((i & 1) * 8);
+
+		// enable output and invert according to INVERT flag
+		ccer |= (TIM_CCER_CC1E | (extract(pin, gpio::Config::INVERT) ? TIM_CCER_CC1P : 0)) << (i * 4);
+	}
+	timer->CCMR1 = ccmr[0];
+	timer->CCMR2 = ccmr[1];
+	timer->CCER = ccer;
+	timer->BDTR = TIM_BDTR_MOE; // main output enable of advanced control timers
+
+	// DMA burst of channelCount transfers to the compare registers starting at CCR1
+	timer->DCR = ((offsetof(TIM_TypeDef, CCR1) / 4) << TIM_DCR_DBA_Pos)
+		| ((channelCount - 1) << TIM_DCR_DBL_Pos);
+	timer->DIER = TIM_DIER_UDE;
+
+	// initialize DMA channel, writes one byte (zero extended to 16 bit) per channel and LED bit to the burst register
+	this->dmaStatus = dmaInfo.status();
+	timerDma.stop();
+	timerDma.setPeripheralAddress(&timer->DMAR);
+
+	// map DMA to timer update
+	timerDma.map();
+
+	// clear LED buffer
+	std::memset(ledBuffer, 0, 2 * Encoder::wordCount(chunkSize, channelCount));
+	this->zeroHalf[0] = true;
+	this->zeroHalf[1] = true;
+
+	nvic::setPriority(this->dmaIrq, nvic::Priority::MEDIUM);
+	nvic::enable(this->dmaIrq);
+}
+
+LedStrip_TIM_DMA::~LedStrip_TIM_DMA() {
+}
+
+BufferDevice::State LedStrip_TIM_DMA::state() {
+	return State::READY;
+}
+
+Awaitable<Device::Condition> LedStrip_TIM_DMA::until(Condition condition) {
+	// check if IN_* condition is met
+	if ((int(condition) >> int(State::READY)) & 1)
+		return {}; // don't wait
+	return {this->stateTasks, condition};
+}
+
+int LedStrip_TIM_DMA::getBufferCount() {
+	return this->buffers.count();
+}
+
+LedStrip_TIM_DMA::BufferBase &LedStrip_TIM_DMA::getBuffer(int index) {
+	return this->buffers.get(index);
+}
+
+void LedStrip_TIM_DMA::fill(int half) {
+	int halfSize = Encoder::wordCount(this->chunkSize, this->channelCount);
+	uint8_t *dst = this->buffer + half * halfSize;
+	uint8_t *src = this->data;
+	if (src < this->end) {
+		// encode next chunk of each strip and pad with zeros which extend the low time of the last bit
+		int count = std::min(int(this->end - src), this->chunkSize);
+		int size = Encoder::wordCount(count, this->channelCount);
+		Encoder::encode(src, this->stride, this->channelCount, count, this->zero, this->one, {dst, dst + size});
+		std::memset(dst + size, 0, halfSize - size);
+		this->zeroHalf[half] = false;
+		this->data = src + count;
+		this->statistics.encoded(count * this->channelCount);
+	} else if (!this->zeroHalf[half]) {
+		// clear for the reset time, only once as long as the half contains only zeros
+		std::memset(dst, 0, halfSize);
+		this->zeroHalf[half] = true;
+	}
+}
+
+void LedStrip_TIM_DMA::handle() {
+	if (this->phase != Phase::RUNNING)
+		return;
+
+	// the half that has been sent
+	int half = this->sentHalves & 1;
+	++this->sentHalves;
+
+	// refill the half while the other half gets sent
+	if (this->sentHalves < this->halfCount) {
+		fill(half);
+		return;
+	}
+
+	// data and reset time have been sent, stop DMA and timer, the compare values are zero
+	this->dmaChannel.stop();
+	this->timer->CR1 = 0;
+	this->phase = Phase::STOPPED;
+
+	this->transfers.pop(
+		[this](BufferBase &buffer) {
+			// push finished transfer buffer to event loop so that BufferBase::handle() gets called from the event loop
+			this->statistics.frame();
+			this->loop.push(buffer);
+			return true;
+		},
+		[](BufferBase &next) {
+			// start next transfer if there is one
+			next.start();
+		}
+	);
+}
+
+
+// BufferBase
+
+LedStrip_TIM_DMA::BufferBase::BufferBase(uint8_t *data, int capacity, LedStrip_TIM_DMA &device)
+	: BufferImpl(data, capacity, BufferBase::State::READY), device(device)
+{
+	device.buffers.add(*this);
+}
+
+LedStrip_TIM_DMA::BufferBase::~BufferBase() {
+}
+
+bool LedStrip_TIM_DMA::BufferBase::start(Op op) {
+	if (this->p.state != State::READY) {
+		assert(this->p.state != State::BUSY);
+		return false;
+	}
+	auto &device = this->device;
+
+	// check if READ or WRITE flag is set and the size is a multiple of the number of strips
+	assert((op & Op::READ_WRITE) != 0);
+	assert(this->p.size % device.channelCount == 0);
+
+	// add to list of pending transfers and start immediately if list was empty
+	if (device.transfers.push(device.dmaIrq, *this))
+		start();
+
+	// set state
+	setBusy();
+
+	return true;
+}
+
+bool LedStrip_TIM_DMA::BufferBase::cancel() {
+	if (this->p.state != State::BUSY)
+		return false;
+	auto &device = this->device;
+
+	// remove from pending transfers if not yet started, otherwise complete normally
+	if (device.transfers.remove(device.dmaIrq, *this, false))
+		setReady(0);
+
+	return true;
+}
+
+void LedStrip_TIM_DMA::BufferBase::start() {
+	auto &device = this->device;
+	int chunkSize = device.chunkSize;
+
+	// set data of first strip
+	int stride = this->p.size / device.channelCount;
+	device.data = this->p.data;
+	device.end = this->p.data + stride;
+	device.stride = stride;
+
+	// number of halves for the data and the reset time
+	device.halfCount = (stride + chunkSize - 1) / chunkSize + device.resetHalves;
+	device.sentHalves = 0;
+
+	// fill both halves of the LED buffer
+	device.fill(0);
+	device.fill(1);
+
+	// start circular DMA, an interrupt occurs when a half has been sent
+	device.dmaStatus.clear(dma::Status::Flags::ALL);
+	device.phase = Phase::RUNNING;
+	device.dmaChannel.start(device.buffer, 2 * Encoder::wordCount(chunkSize, device.channelCount),
+		DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE);
+
+	// start timer, the first DMA burst happens at the first update event
+	device.timer->CR1 = TIM_CR1_CEN;
+}
+
+void LedStrip_TIM_DMA::BufferBase::handle() {
+	setReady();
+}
+
+} // namespace coco
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <coco/BufferDevice.hpp>
+#include <coco/BufferImpl.hpp>
+#include <coco/Frequency.hpp>
+#include <coco/LedEncoder.hpp>
+#include <coco/LedStripStatistics.hpp>
+#include <coco/platform/Loop_Queue.hpp>
+#include <coco/platform/TimerDma.hpp>
+#include <coco/platform/dma.hpp>
+#include <coco/platform/gpio.hpp>
+#include <coco/platform/timer.hpp>
+#include <coco/platform/nvic.hpp>
+#include <array>
+
+
+namespace coco {
+
+/**
+	Implementation of LED strip interface on stm32 for 1 - 4 LED strips on the channels CH1 - CHn of a timer in PWM
+	mode. The update event of the timer triggers a DMA burst (TIMx_DCR/TIMx_DMAR) that writes the compare registers
+	of all channels once per LED bit, therefore the high times T0H and T1H are exact up to one timer clock cycle
+	independent of the bit time. The compare values are one byte per LED bit and strip (see LedEncoder_PWM). The DMA
+	runs in circular mode over two halves of the LED buffer, when a half has been sent (half transfer and transfer
+	complete interrupt), the interrupt handler encodes the next chunk of LED data into it. The reset is generated by
+	compare values of zero.
+	The data of the strips is stored one after another in the buffer, i.e. a transfer of size bytes sends
+	size / channelCount bytes to each strip.
+
+	Reference manual:
+		g4:
+			https://www.st.com/resource/en/reference_manual/rm0440-stm32g4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+				DMA: Section 12
+				DMAMUX: Section 13
+				TIM1/TIM8: Section 28
+				TIM2/TIM3/TIM4: Section 29
+	Data sheet:
+		g4:
+			https://www.st.com/resource/en/datasheet/stm32g431rb.pdf
+				Alternate Functions: Section 4.11, Table 13, Page 61
+	Resources:
+		TIMx (channels CH1 - CHn)
+		DMA
+	Instantiate LedStrip_TIM_DMA_Chunked which contains the LED buffer.
+*/
+class LedStrip_TIM_DMA : public BufferDevice {
+public:
+	// maximum number of strips
+	static constexpr int MAX_CHANNEL_COUNT = 4;
+
+	using Encoder = LedEncoder_PWM<>;
+
+protected:
+	/**
+		Constructor
+		@param loop event loop
+		@param pins output pins of the timer channels CH1 - CHn and alternative function (see data sheet)
+		@param channelCount number of channels (strips), 1 - 4
+		@param timerInfo info of timer instance to use
+		@param dmaInfo info of DMA channel to use
+		@param timerDma registers and timer update request of the same DMA channel
+		@param arr auto reload value of the timer, i.e. timer clock cycles per bit minus one (see calcArr())
+		@param zero compare value of a zero bit, i.e. T0H in timer clock cycles (see calcCompare())
+		@param one compare value of a one bit, i.e. T1H in timer clock cycles, at most 255
+		@param resetCount number of timer periods for the reset time (see calcResetCount())
+		@param ledBuffer LED buffer for 2 * Encoder::wordCount(chunkSize, channelCount) bytes
+		@param chunkSize number of bytes of each strip that the interrupt handler encodes at once
+	*/
+	LedStrip_TIM_DMA(Loop_Queue &loop, const gpio::Config *pins, int channelCount, const timer::Info &timerInfo,
+		const dma::Info &dmaInfo, const TimerDma &timerDma, int arr, int zero, int one, int resetCount,
+		uint8_t *ledBuffer, int chunkSize);
+public:
+	~LedStrip_TIM_DMA() override;
+
+	/**
+		Calculate the auto reload value of the timer so that the timer period is the bit time
+		@param clock timer clock frequency in kHz
+		@param bitTime bit time in ns
+		@return auto reload value
+	*/
+	static constexpr int calcArr(int clock, int bitTime) {
+		return calcCompare(clock, bitTime) - 1;
+	}
+
+	/**
+		Calculate the compare value for a high time
+		@param clock timer clock frequency in kHz
+		@param time high time in ns
+		@return compare value
+	*/
+	static constexpr int calcCompare(int clock, int time) {
+		return int((int64_t(clock) * time + 500000) / 1000000);
+	}
+
+	/**
+		Calculate the number of timer periods that take at least the reset time
+		@param clock timer clock frequency in kHz
+		@param arr auto reload value
+		@param resetTime reset time in us
+		@return number of timer periods
+	*/
+	static constexpr int calcResetCount(int clock, int arr, int resetTime) {
+		return int(int64_t(clock) * resetTime / ((arr + 1) * 1000)) + 1;
+	}
+
+
+	// internal buffer base class, derives from IntrusiveListNode for the list of buffers and Loop_Queue::Handler to be notified from the event loop
+	class BufferBase : public BufferImpl, public IntrusiveListNode, public Loop_Queue::Handler {
+		friend class LedStrip_TIM_DMA;
+	public:
+		/**
+			Constructor
+			@param data data of the buffer
+			@param capacity capacity of the buffer
+			@param device led strip device to attach to
+		*/
+		BufferBase(uint8_t *data, int capacity, LedStrip_TIM_DMA &device);
+		~BufferBase() override;
+
+		// Buffer methods
+		bool start(Op op) override;
+		bool cancel() override;
+
+	protected:
+		void start();
+		void handle() override;
+
+		LedStrip_TIM_DMA &device;
+	};
+
+	/**
+		Buffer for transferring data to the LED strips.
+		@tparam C capacity of buffer, multiple of the number of channels
+	*/
+	template <int C>
+	class Buffer : public BufferBase {
+	public:
+		Buffer(LedStrip_TIM_DMA &device) : BufferBase(data, C, device) {}
+
+	protected:
+		alignas(4) uint8_t data[C];
+	};
+
+
+	// Device methods
+	State state() override;
+	[[nodiscard]] Awaitable<Condition> until(Condition condition) override;
+
+	// BufferDevice methods
+	int getBufferCount() override;
+	BufferBase &getBuffer(int index) override;
+
+	/**
+		Get the statistics, only collected if COCO_LEDSTRIP_STATISTICS is defined. An underrun is counted when the
+		interrupt handler was too late to refill a half of the LED buffer before it was sent again
+	*/
+	const LedStripStatistics &getStatistics() const {return this->statistics.get();}
+
+	/**
+		Reset the statistics
+	*/
+	void resetStatistics() {this->statistics.reset();}
+
+	/**
+		DMA interrupt handler, needs to be called from DMA channel interrupt handler (e.g. DMA1_Channel1_IRQHandler() for dma::DMA1_CH1_INFO on STM32G4)
+	*/
+	void DMA_IRQHandler() {
+		LedStripCounters::Irq irq(this->statistics);
+
+		// both halves have been sent since the last interrupt: a half was sent again before it was refilled
+		if constexpr (LedStripStatistics::ENABLED) {
+			auto status = this->dmaStatus.get();
+			if ((status & dma::Status::Flags::HALF_TRANSFER) != 0
+				&& (status & dma::Status::Flags::TRANSFER_COMPLETE) != 0 && this->phase == Phase::RUNNING)
+			{
+				this->statistics.underrun();
+			}
+		}
+
+		// first half has been sent
+		if ((this->dmaStatus.get() & dma::Status::Flags::HALF_TRANSFER) != 0) {
+			this->dmaStatus.clear(dma::Status::Flags::HALF_TRANSFER);
+			handle();
+		}
+
+		// second half has been sent (read status again as handle() clears it when it starts the next transfer)
+		if ((this->dmaStatus.get() & dma::Status::Flags::TRANSFER_COMPLETE) != 0) {
+			this->dmaStatus.clear(dma::Status::Flags::TRANSFER_COMPLETE);
+			handle();
+		}
+	}
+
+protected:
+	// fill a half of the LED buffer with the next chunk of LED data or with zeros at the end of the data
+	void fill(int half);
+
+	void handle();
+
+	Loop_Queue &loop;
+
+	// timer
+	TIM_TypeDef *timer;
+	int channelCount;
+
+	// dma
+	int dmaIrq;
+	dma::Status dmaStatus;
+	TimerDma dmaChannel;
+
+	// dummy (state is always READY)
+	CoroutineTaskList<Condition> stateTasks;
+
+	// list of buffers
+	IntrusiveList<BufferBase> buffers;
+
+	// list of active transfers
+	nvic::Queue<BufferBase> transfers;
+
+	// compare values of a zero and a one bit
+	uint8_t zero;
+	uint8_t one;
+
+	// data to transfer, the strips are stride bytes apart
+	uint8_t *data;
+	uint8_t *end;
+	int stride;
+
+	// number of halves that are sent after the data for the reset time
+	int resetHalves;
+
+	// number of halves of the current transfer and number of halves that have been sent
+	int halfCount;
+	int sentHalves;
+
+	// LED buffer that consists of two halves of Encoder::wordCount(chunkSize, channelCount) bytes
+	uint8_t *buffer;
+	int chunkSize;
+
+	// true if a half of the LED buffer contains only zeros
+	bool zeroHalf[2];
+
+	enum class Phase {
+		// nothing to do, timer is stopped
+		STOPPED,
+
+		// DMA runs, the halves get refilled with LED data and zeros for the reset
+		RUNNING
+	};
+	Phase phase = Phase::STOPPED;
+
+	// statistics
+	[[no_unique_address]] LedStripCounters statistics;
+};
+
+/**
+	LED strips on the channels of a stm32 timer with LED buffer. The interrupt handler encodes C bytes of each strip at
+	once, therefore the CPU gets interrupted every C * 8 bit times, e.g. every C * 10μs for a bit time of 1250ns. RAM
+	usage of the LED buffer is 16 * N bytes per byte of chunk size.
+	@tparam N number of channels (strips), 1 - 4
+	@tparam C chunk size in bytes per strip, e.g. 48 for 16 RGB or 12 RGBW LEDs
+*/
+template <int N, int C = 48>
+class LedStrip_TIM_DMA_Chunked : public LedStrip_TIM_DMA {
+	// DMA transfer count is limited to 16 bit
+	static_assert(N >= 1 && N <= MAX_CHANNEL_COUNT, "invalid number of channels");
+	static_assert(C > 0 && 2 * Encoder::wordCount(C, N) <= 65535, "invalid chunk size");
+protected:
+	LedStrip_TIM_DMA_Chunked(Loop_Queue &loop, const std::array<gpio::Config, N> &pins,
+		const timer::Info &timerInfo, const dma::Info &dmaInfo, const TimerDma &timerDma, int arr, int zero, int one,
+		int resetCount)
+		: LedStrip_TIM_DMA(loop, pins.data(), N, timerInfo, dmaInfo, timerDma, arr, zero, one, resetCount, ledBuffer,
+		C) {}
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param pins output pins of the timer channels CH1 - CHN and alternative function (see data sheet), e.g.
+			{gpio::Config::PA8 | gpio::Config::AF6, gpio::Config::PA9 | gpio::Config::AF6} for CH1 and CH2 of TIM1
+		@param timerInfo info of timer instance to use
+		@param dmaInfo info of DMA channel to use
+		@param timerDma registers and timer update request of the same DMA channel
+		@param clock timer clock frequency (e.g. APB2_TIMER_CLOCK for TIM1), at most 255 clock cycles for T1H
+		@param bitTime bit time, e.g. 1250ns
+		@param t0h high time of a zero bit, e.g. 400ns
+		@param t1h high time of a one bit, e.g. 800ns
+		@param resetTime reset time, e.g. 75μs
+	*/
+	LedStrip_TIM_DMA_Chunked(Loop_Queue &loop, const std::array<gpio::Config, N> &pins,
+		const timer::Info &timerInfo, const dma::Info &dmaInfo, const TimerDma &timerDma, Kilohertz<> clock,
+		Nanoseconds<> bitTime, Nanoseconds<> t0h, Nanoseconds<> t1h, Microseconds<> resetTime)
+		: LedStrip_TIM_DMA(loop, pins.data(), N, timerInfo, dmaInfo, timerDma, calcArr(clock.value, bitTime.value),
+		calcCompare(clock.value, t0h.value), calcCompare(clock.value, t1h.value),
+		calcResetCount(clock.value, calcArr(clock.value, bitTime.value), resetTime.value), ledBuffer, C) {}
+
+protected:
+	uint8_t ledBuffer[2 * Encoder::wordCount(C, N)];
+};
+
+} // namespace coco
@@ -2,20 +2,17 @@
 //#include <coco/debug.hpp>
 
 
-namespace {
-#include "bitTable_UART.hpp"
-}
-
 namespace coco {
 
-// LedStrip_UART_DMA
+// LedStrip_UART_DMA_Base
 
-LedStrip_UART_DMA::LedStrip_UART_DMA(Loop_Queue &loop, gpio::Config txPin, const usart::Info &uartInfo,
-	const dma::Info &dmaInfo, uint32_t brr, int resetCount)
+LedStrip_UART_DMA_Base::LedStrip_UART_DMA_Base(Loop_Queue &loop, gpio::Config txPin, const usart::Info &uartInfo,
+	const dma::Info &dmaInfo, uint32_t brr, int resetCount, uint32_t *ledBuffer, int chunkSize)
 	: loop(loop)
 	, txPin(txPin)
 	, uart(uartInfo.usart), uartIrq(uartInfo.irq)
 	, resetCount(resetCount)
+	, buffer(ledBuffer), chunkSize(chunkSize)
 {
 	//gpio::configureOutput(gpio::PA(15), false);
 
@@ -70,29 +67,29 @@ LedStrip_UART_DMA::LedStrip_UART_DMA(Loop_Queue &loop, gpio::Config txPin, const
 	nvic::enable(dmaInfo.irq);
 }
 
-LedStrip_UART_DMA::~LedStrip_UART_DMA() {
+LedStrip_UART_DMA_Base::~LedStrip_UART_DMA_Base() {
 }
 
-BufferDevice::State LedStrip_UART_DMA::state() {
+BufferDevice::State LedStrip_UART_DMA_Base::state() {
 	return State::READY;
 }
 
-Awaitable<Device::Condition> LedStrip_UART_DMA::until(Condition condition) {
+Awaitable<Device::Condition> LedStrip_UART_DMA_Base::until(Condition condition) {
 	// check if IN_* condition is met
 	if ((int(condition) >> int(State::READY)) & 1)
 		return {}; // don't wait
 	return {this->stateTasks, condition};
 }
 
-int LedStrip_UART_DMA::getBufferCount() {
+int LedStrip_UART_DMA_Base::getBufferCount() {
 	return this->buffers.count();
 }
 
-LedStrip_UART_DMA::BufferBase &LedStrip_UART_DMA::getBuffer(int index) {
+LedStrip_UART_DMA_Base::BufferBase &LedStrip_UART_DMA_Base::getBuffer(int index) {
 	return this->buffers.get(index);
 }
 
-void LedStrip_UART_DMA::handle() {
+void LedStrip_UART_DMA_Base::handle() {
 	auto uart = this->uart;
 	auto dmaChannel = this->dmaChannel;
 
@@ -104,12 +101,25 @@ void LedStrip_UART_DMA::handle() {
 
 	switch (this->phase) {
 	case Phase::COPY:
-		{
+		if (this->encoded != nullptr) {
+			// transfer all encoded data at once
+			dmaChannel.setMemoryAddress(this->encoded);
+			dmaChannel.setCount(LedEncoder_UART::frameCount(this->end - this->data));
+
+			// enable DMA (without transfer complete interrupt, we use UART transmission complete interrupt instead)
+			dmaChannel.enable(dma::Channel::Config::TX);
+
+			// enable UART transmission complete interrupt (TC flag gets cleared automatically by new data)
+			uart->CR1 = uart->CR1 | USART_CR1_TCIE;
+
+			// go to reset phase
+			this->phase = Phase::RESET;
+		} else {
 			//gpio::setOutput(gpio::PA(15), true);
 
 			// source data
 			uint8_t *src = this->data;
-			uint8_t *end = std::min(src + LED_BUFFER_SIZE, this->end);
+			uint8_t *end = std::min(src + this->chunkSize, this->end);
 
 			// destination
 			uint32_t *dst = this->buffer;
@@ -117,21 +127,24 @@ void LedStrip_UART_DMA::handle() {
 			// set DMA pointer
 			dmaChannel.setMemoryAddress(dst);//->CMAR = uintptr_t(dst);
 
-			// copy/convert
-			for (; src < end; src += 3, dst += 2) {
-				int a = src[0];
-				int b = src[1];
-				int c = src[2];
-
-				dst[0] = bitTable[a >> 2]
-					| (bitTable[((a & 3) << 4) | b >> 4] << 16);
-				dst[1] = bitTable[((b & 15) << 2) | c >> 6]
-					| (bitTable[c & 63] << 16);
+			// convert
+			int count;
+			auto dither = this->dither;
+			auto transform = this->transform;
+			if (dither != nullptr) {
+				count = LedEncoder_UART::encode(dither->reader(this->begin, src - this->begin), end - src,
+					{dst, dst + LedEncoder_UART::wordCount(end - src)});
+			} else if (transform == nullptr) {
+				count = LedEncoder_UART::encode({src, end}, {dst, dst + LedEncoder_UART::wordCount(end - src)});
+			} else {
+				count = LedEncoder_UART::encode({src, end}, {dst, dst + LedEncoder_UART::wordCount(end - src)},
+					*transform, (src - this->begin) % transform->channelCount);
 			}
 			//gpio::setOutput(gpio::PA(15), false);
+			this->statistics.encoded(end - src);
 
-			// set DMA count
-			dmaChannel.setCount(uintptr_t(dst) - uintptr_t(this->buffer));
+			// set DMA count in bytes (one byte per UART frame), a padded last block gets sent only partially
+			dmaChannel.setCount(LedEncoder_UART::frameCount(count));
 
 			// check if more source data to transfer
 			if (end < this->end) {
@@ -183,6 +196,7 @@ void LedStrip_UART_DMA::handle() {
 			this->transfers.pop(
 				[this](BufferBase &buffer) {
 					// push finished transfer buffer to event loop so that BufferBase::handle() gets called from the event loop
+					this->statistics.frame();
 					this->loop.push(buffer);
 					return true;
 				},
@@ -201,16 +215,17 @@ void LedStrip_UART_DMA::handle() {
 
 // BufferBase
 
-LedStrip_UART_DMA::BufferBase::BufferBase(uint8_t *data, int size, LedStrip_UART_DMA &device)
+LedStrip_UART_DMA_Base::BufferBase::BufferBase(uint8_t *data, int size, LedStrip_UART_DMA_Base &device, uint32_t *encoded)
 	: BufferImpl(data, size, BufferBase::State::READY), device(device)
+	, encoded(encoded), dirtyBegin(0), dirtyEnd(size)
 {
 	device.buffers.add(*this);
 }
 
-LedStrip_UART_DMA::BufferBase::~BufferBase() {
+LedStrip_UART_DMA_Base::BufferBase::~BufferBase() {
 }
 
-bool LedStrip_UART_DMA::BufferBase::start(Op op) {
+bool LedStrip_UART_DMA_Base::BufferBase::start(Op op) {
 	if (this->p.state != State::READY) {
 		assert(this->p.state != State::BUSY);
 		return false;
@@ -220,6 +235,52 @@ bool LedStrip_UART_DMA::BufferBase::start(Op op) {
 	// check if READ or WRITE flag is set
 	assert((op & Op::READ_WRITE) != 0);
 
+	// check if dithering is used with an uncached buffer and there is an accumulator for each channel
+	assert(device.dither == nullptr || (this->encoded == nullptr && int(this->p.size) / 2 <= device.dither->capacity));
+
+	// encode changed data into the cache
+	if (this->encoded != nullptr) {
+		constexpr int BLOCK_BYTES = LedEncoder_UART::BLOCK_BYTES;
+		int size = this->p.size;
+
+		// the last block is padded, encode it again when the size changes
+		if (size != this->encodedSize) {
+			int last = std::min(size, this->encodedSize) / BLOCK_BYTES * BLOCK_BYTES;
+			setDirty(last, last + BLOCK_BYTES);
+			this->encodedSize = size;
+		}
+
+		// a change affects the whole pixel if there is a transform
+		int begin = this->dirtyBegin;
+		int end = this->dirtyEnd;
+		auto transform = device.transform;
+		if (transform != nullptr)
+			transform->extend(begin, end);
+
+		// encode whole blocks
+		begin = begin / BLOCK_BYTES * BLOCK_BYTES;
+		end = std::min((end + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES, size);
+		if (begin < end) {
+			auto dst = this->encoded + LedEncoder_UART::wordCount(begin);
+			if (transform == nullptr) {
+				LedEncoder_UART::encode({this->p.data + begin, this->p.data + end},
+					{dst, dst + LedEncoder_UART::wordCount(end - begin)});
+			} else {
+				LedEncoder_UART::encode({this->p.data + begin, this->p.data + end},
+					{dst, dst + LedEncoder_UART::wordCount(end - begin)}, *transform, begin % transform->channelCount);
+			}
+			device.statistics.encoded(end - begin);
+		}
+
+		// changes behind the transferred data stay dirty
+		if (this->dirtyEnd > size) {
+			this->dirtyBegin = std::max(begin, size);
+		} else {
+			this->dirtyBegin = capacity();
+			this->dirtyEnd = 0;
+		}
+	}
+
 	// add to list of pending transfers and start immediately if list was empty
 	if (this->device.transfers.push(device.uartIrq, *this))
 		start();
@@ -230,7 +291,7 @@ bool LedStrip_UART_DMA::BufferBase::start(Op op) {
 	return true;
 }
 
-bool LedStrip_UART_DMA::BufferBase::cancel() {
+bool LedStrip_UART_DMA_Base::BufferBase::cancel() {
 	if (this->p.state != State::BUSY)
 		return false;
 	auto &device = this->device;
@@ -242,12 +303,14 @@ bool LedStrip_UART_DMA::BufferBase::cancel() {
 	return true;
 }
 
-void LedStrip_UART_DMA::BufferBase::start() {
+void LedStrip_UART_DMA_Base::BufferBase::start() {
 	auto &device = this->device;
 
 	// set data
+	device.begin = this->p.data;
 	device.data = this->p.data;
-	device.end = this->p.data + this->p.size;
+	device.end = this->p.data + (device.dither == nullptr ? this->p.size : this->p.size / 2);
+	device.encoded = this->encoded;
 
 	// connect tx pin to UART
 	gpio::setMode(device.txPin, gpio::Mode::ALTERNATE);
@@ -257,7 +320,7 @@ void LedStrip_UART_DMA::BufferBase::start() {
 	device.handle();
 }
 
-void LedStrip_UART_DMA::BufferBase::handle() {
+void LedStrip_UART_DMA_Base::BufferBase::handle() {
 	setReady();
 }
 
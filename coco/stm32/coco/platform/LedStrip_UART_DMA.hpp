@@ -3,6 +3,8 @@
 #include <coco/BufferDevice.hpp>
 #include <coco/BufferImpl.hpp>
 #include <coco/Frequency.hpp>
+#include <coco/LedEncoder.hpp>
+#include <coco/LedStripStatistics.hpp>
 #include <coco/platform/Loop_Queue.hpp>
 #include <coco/platform/dma.hpp>
 #include <coco/platform/gpio.hpp>
@@ -38,49 +40,90 @@ namespace coco {
 	Resources:
 		USART or UART
 		DMA
+	Instantiate LedStrip_UART_DMA or LedStrip_UART_DMA_Chunked which contain the LED buffer.
 */
-class LedStrip_UART_DMA : public BufferDevice {
+class LedStrip_UART_DMA_Base : public BufferDevice {
 protected:
-	LedStrip_UART_DMA(Loop_Queue &loop, gpio::Config txPin, const usart::Info &uartInfo, const dma::Info &dmaInfo,
-		uint32_t brr, int resetCount);
-public:
 	/**
 		Constructor
 		@param loop event loop
 		@param txPin transmit (TX) pin and alternative function (see data sheet)
 		@param usartInfo info of USART/UART instance to use
 		@param dmaInfo info of DMA channel to use
-		@param clock peripheral clock frequency (USART1: USART1_CLOCK, USART2: USART2_CLOCK, USART3: USART3_CLOCK, UART4 - UART5: APB1_CLOCK)
+		@param brr baud rate divider (see calcBrr())
+		@param resetCount number of UART frames for the reset time (see calcResetCount())
+		@param ledBuffer LED buffer for LedEncoder_UART::wordCount(chunkSize) words
+		@param chunkSize number of bytes of LED data that the interrupt handler encodes at once, multiple of 3
+	*/
+	LedStrip_UART_DMA_Base(Loop_Queue &loop, gpio::Config txPin, const usart::Info &uartInfo, const dma::Info &dmaInfo,
+		uint32_t brr, int resetCount, uint32_t *ledBuffer, int chunkSize);
+public:
+	~LedStrip_UART_DMA_Base() override;
+
+	/**
+		Calculate the baud rate divider so that 3 UART bits take at least the bit time (minimum is 8)
+		@param clock peripheral clock frequency in kHz
+		@param bitTime bit time in ns
+		@return baud rate divider
 	*/
-	LedStrip_UART_DMA(Loop_Queue &loop, gpio::Config txPin, const usart::Info &uartInfo, const dma::Info &dmaInfo,
-		Kilohertz<> clock, Nanoseconds<> bitTime, Microseconds<> resetTime) : LedStrip_UART_DMA(loop, txPin,
-		uartInfo, dmaInfo, std::max(int(clock * bitTime / 3) + 1, 8), int(clock / ((int(clock * bitTime / 3) + 1) * 9) * resetTime)) {}
+	static constexpr int calcBrr(int clock, int bitTime) {
+		return std::max(int(int64_t(clock) * bitTime / 3000000) + 1, 8);
+	}
 
-	~LedStrip_UART_DMA() override;
+	/**
+		Calculate the number of UART frames (9 bits) that take at least the reset time
+		@param clock peripheral clock frequency in kHz
+		@param brr baud rate divider
+		@param resetTime reset time in us
+		@return number of UART frames
+	*/
+	static constexpr int calcResetCount(int clock, int brr, int resetTime) {
+		return int(int64_t(clock) * resetTime / (brr * 9000)) + 1;
+	}
 
 
 	// internal buffer base class, derives from IntrusiveListNode for the list of buffers and Loop_Queue::Handler to be notified from the event loop
 	class BufferBase : public BufferImpl, public IntrusiveListNode, public Loop_Queue::Handler {
-		friend class LedStrip_UART_DMA;
+		friend class LedStrip_UART_DMA_Base;
 	public:
 		/**
 			Constructor
 			@param data data of the buffer
 			@param capacity capacity of the buffer
 			@param channel channel to attach to
+			@param encoded cache for encoded data (LedEncoder_UART::wordCount(size) words), nullptr if the buffer
+				has no cache
 		*/
-		BufferBase(uint8_t *data, int size, LedStrip_UART_DMA &device);
+		BufferBase(uint8_t *data, int size, LedStrip_UART_DMA_Base &device, uint32_t *encoded = nullptr);
 		~BufferBase() override;
 
 		// Buffer methods
 		bool start(Op op) override;
 		bool cancel() override;
 
+		/**
+			Mark a range of the data as changed since the last transfer of this buffer, only for buffers with cache
+			(CachedBuffer). Only the changed data gets encoded when the next transfer starts, the rest is taken from the
+			cache. Changes that are not marked don't get transferred.
+			@param begin offset of first changed byte
+			@param end offset after last changed byte
+		*/
+		void setDirty(int begin, int end) {
+			this->dirtyBegin = std::min(this->dirtyBegin, begin);
+			this->dirtyEnd = std::max(this->dirtyEnd, end);
+		}
+
 	protected:
 		void start();
 		void handle() override;
 
-		LedStrip_UART_DMA &device;
+		LedStrip_UART_DMA_Base &device;
+
+		// cache for encoded data and range of data that needs to be encoded
+		uint32_t *encoded;
+		int encodedSize = 0;
+		int dirtyBegin;
+		int dirtyEnd;
 	};
 
 	/**
@@ -90,12 +133,30 @@ public:
 	template <int C>
 	class Buffer : public BufferBase {
 	public:
-		Buffer(LedStrip_UART_DMA &device) : BufferBase(data, C, device) {}
+		Buffer(LedStrip_UART_DMA_Base &device) : BufferBase(data, C, device) {}
 
 	protected:
 		alignas(4) uint8_t data[C];
 	};
 
+	/**
+		Buffer for transferring data over UART that keeps the encoded data. Use setDirty() to mark changed data.
+		The whole data gets transferred by one DMA transfer, therefore the CPU gets interrupted only at the end of
+		the data and at the end of the reset time. Needs 11/3 bytes of RAM per byte of LED data.
+		@tparam C capacity of buffer
+	*/
+	template <int C>
+	class CachedBuffer : public BufferBase {
+		// DMA transfer count is limited to 16 bit
+		static_assert(LedEncoder_UART::frameCount(C) <= 65535, "capacity too large for one DMA transfer");
+	public:
+		CachedBuffer(LedStrip_UART_DMA_Base &device) : BufferBase(data, C, device, encoded) {}
+
+	protected:
+		alignas(4) uint8_t data[C];
+		uint32_t encoded[LedEncoder_UART::wordCount(C)];
+	};
+
 
 	// Device methods
 	State state() override;
@@ -105,10 +166,37 @@ public:
 	int getBufferCount() override;
 	BufferBase &getBuffer(int index) override;
 
+	/**
+		Set a color transform that gets applied while encoding the LED data, takes effect with the next transfer.
+		Mark all data of cached buffers as dirty when the transform changes
+		@param transform color transform, needs to stay valid, nullptr for no transform
+	*/
+	void setTransform(const LedTransform *transform) {this->transform = transform;}
+
+	/**
+		Set temporal dithering, takes effect with the next transfer. The buffers then contain 16 bit channels MSB first
+		(see PixelFormat) which get reduced to 8 bit while encoding, a transfer of size bytes sends size / 2 bytes to the
+		LED strip. Not supported for cached buffers, the color transform is not applied
+		@param dither dithering with one accumulator per channel, needs to stay valid, nullptr for no dithering
+	*/
+	void setDither(LedDither *dither) {this->dither = dither;}
+
+	/**
+		Get the statistics, only collected if COCO_LEDSTRIP_STATISTICS is defined. The LED strip pauses while the
+		interrupt handler refills the LED buffer, therefore no underruns are counted
+	*/
+	const LedStripStatistics &getStatistics() const {return this->statistics.get();}
+
+	/**
+		Reset the statistics
+	*/
+	void resetStatistics() {this->statistics.reset();}
+
 	/**
 	 * UART interrupt handler, needs to be called from global USART/UART interrupt handler (e.g. USART1_IRQHandler() for usart::USART1_INFO on STM32G4)
 	 */
 	void UART_IRQHandler() {
+		LedStripCounters::Irq irq(this->statistics);
 		auto uart = this->uart;
 
 		// check if transmission has completed
@@ -124,6 +212,8 @@ public:
 		DMA interrupt handler, needs to be called from DMA channel interrupt handler (e.g. DMA1_Channel1_IRQHandler() for dma::DMA1_CH1_INFO on STM32G4)
 	*/
 	void DMA_IRQHandler() {
+		LedStripCounters::Irq irq(this->statistics);
+
 		// check if receive has completed
 		if ((this->dmaStatus.get() & dma::Status::Flags::TRANSFER_COMPLETE) != 0)
 			handle();
@@ -153,16 +243,27 @@ protected:
 	// list of active transfers
 	nvic::Queue<BufferBase> transfers;
 
-	// data to transfer
+	// color transform
+	const LedTransform *transform = nullptr;
+
+	// temporal dithering
+	LedDither *dither = nullptr;
+
+	// data to transfer (in units of 8 bit channels if there is dithering)
+	uint8_t *begin;
 	uint8_t *data;
 	uint8_t *end;
 
+	// encoded data to transfer (if the buffer has a cache)
+	const uint32_t *encoded;
+
 	// reset after data
 	int resetCount;
 
-	// buffer for 2 x 16 LEDs
-	static constexpr int LED_BUFFER_SIZE = 16 * 3;
-	uint32_t buffer[(LED_BUFFER_SIZE * 4) / 3 / 2]; // need 4 x uint16_t for one LED which are 3 bytes
+	// LED buffer for chunkSize bytes of LED data (4 x uint16_t for 3 bytes). The chunk size is a multiple of the encoder
+	// block size (3 bytes) so that only the last chunk can contain an incomplete block
+	uint32_t *buffer;
+	int chunkSize;
 
 	enum class Phase {
 		// nothing to do, I2S is stopped
@@ -178,6 +279,48 @@ protected:
 		FINISHED
 	};
 	Phase phase = Phase::STOPPED;
+
+	// statistics
+	[[no_unique_address]] LedStripCounters statistics;
+};
+
+/**
+	LED strip on stm32 using USARTx, UARTx or LPUARTx with LED buffer. The interrupt handler encodes C bytes of LED data
+	at once, therefore the CPU gets interrupted every C * 8 bit times, e.g. every C * 9μs for a bit time of 1125ns. A
+	larger chunk size reduces the number of interrupts per frame but increases RAM usage (8/3 bytes per byte of chunk
+	size) and the duration of the interrupt handler.
+	@tparam C chunk size in bytes of LED data, multiple of 3, e.g. 48 for 16 RGB or 12 RGBW LEDs
+*/
+template <int C = 48>
+class LedStrip_UART_DMA_Chunked : public LedStrip_UART_DMA_Base {
+	// DMA transfer count is limited to 16 bit
+	static_assert(C > 0 && C % LedEncoder_UART::BLOCK_BYTES == 0 && LedEncoder_UART::frameCount(C) <= 65535,
+		"invalid chunk size");
+protected:
+	LedStrip_UART_DMA_Chunked(Loop_Queue &loop, gpio::Config txPin, const usart::Info &uartInfo,
+		const dma::Info &dmaInfo, uint32_t brr, int resetCount)
+		: LedStrip_UART_DMA_Base(loop, txPin, uartInfo, dmaInfo, brr, resetCount, ledBuffer, C) {}
+public:
+	/**
+		Constructor
+		@param loop event loop
+		@param txPin transmit (TX) pin and alternative function (see data sheet)
+		@param usartInfo info of USART/UART instance to use
+		@param dmaInfo info of DMA channel to use
+		@param clock peripheral clock frequency (USART1: USART1_CLOCK, USART2: USART2_CLOCK, USART3: USART3_CLOCK, UART4 - UART5: APB1_CLOCK)
+	*/
+	LedStrip_UART_DMA_Chunked(Loop_Queue &loop, gpio::Config txPin, const usart::Info &uartInfo,
+		const dma::Info &dmaInfo, Kilohertz<> clock, Nanoseconds<> bitTime, Microseconds<> resetTime)
+		: LedStrip_UART_DMA_Base(loop, txPin, uartInfo, dmaInfo, calcBrr(clock.value, bitTime.value),
+		calcResetCount(clock.value, calcBrr(clock.value, bitTime.value), resetTime.value), ledBuffer, C) {}
+
+protected:
+	uint32_t ledBuffer[LedEncoder_UART::wordCount(C)];
 };
 
+/**
+	LED strip on stm32 using USARTx, UARTx or LPUARTx with the default chunk size of 48 bytes
+*/
+using LedStrip_UART_DMA = LedStrip_UART_DMA_Chunked<>;
+
 } // namespace coco
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <coco/platform/dma.hpp>
+
+
+namespace coco {
+
+/**
+	DMA channel that gets triggered by the update event of a timer, used by LedStrip_TIM_DMA and
+	LedStrip_Parallel_TIM_DMA. The platform layer neither maps timer requests to DMA channels nor supports 16 bit
+	peripheral transfers (dma::Channel), therefore the drivers program the channel and the DMAMUX directly on the
+	registers. dma::Info of the same channel is still used for clock, interrupt and status flags.
+
+	Reference manual:
+		g4:
+			https://www.st.com/resource/en/reference_manual/rm0440-stm32g4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+				DMA: Section 12
+				DMAMUX: Section 13
+*/
+struct TimerDma {
+	// registers of the DMA channel, e.g. DMA1_Channel1 for dma::DMA1_CH1_INFO
+	DMA_Channel_TypeDef *channel;
+
+	// configuration register of the DMAMUX channel that belongs to the DMA channel (e.g. &DMAMUX1_Channel0->CCR for
+	// DMA1_Channel1), nullptr on devices without DMAMUX (e.g. STM32F3) where the request is fixed per DMA channel
+	volatile uint32_t *mux;
+
+	// DMAMUX request of the timer update event (TIMx_UP, see request mapping in the reference manual)
+	int request;
+
+	/**
+		Map the update request of the timer to the DMA channel
+	*/
+	void map() const {
+		if (this->mux != nullptr)
+			*this->mux = this->request; // DMAREQ_ID
+	}
+
+	/**
+		Set the peripheral address
+		@param address address of the peripheral register
+	*/
+	void setPeripheralAddress(const volatile void *address) const {
+		this->channel->CPAR = uintptr_t(address);
+	}
+
+	/**
+		Start a transfer from memory to the peripheral
+		@param data data to transfer
+		@param count number of transfers
+		@param config DMA_CCR_* flags, e.g. DMA_CCR_MINC | DMA_CCR_TCIE
+	*/
+	void start(const void *data, int count, uint32_t config) const {
+		auto channel = this->channel;
+		channel->CMAR = uintptr_t(data);
+		channel->CNDTR = count;
+		channel->CCR = config | DMA_CCR_DIR | DMA_CCR_EN;
+	}
+
+	/**
+		Stop the current transfer
+	*/
+	void stop() const {
+		this->channel->CCR = 0;
+	}
+};
+
+} // namespace coco
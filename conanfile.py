@@ -1,3 +1,4 @@
+import os
 from conan import ConanFile
 from conan.tools.files import copy
 from conan.tools.cmake import CMake
@@ -9,11 +10,13 @@ class Project(ConanFile):
     license = "MIT"
     settings = "os", "compiler", "build_type", "arch"
     options = {
-        "platform": [None, "ANY"]}
+        "platform": [None, "ANY"],
+        "statistics": [True, False]}
     default_options = {
-        "platform": None}
+        "platform": None,
+        "statistics": False}
     generators = "CMakeDeps", "CMakeToolchain"
-    exports_sources = "conanfile.py", "CMakeLists.txt", "coco/*", "generator/*", "test/*"
+    exports_sources = "conanfile.py", "CMakeLists.txt", "coco/*", "test/*"
 
 
     # check if we are cross compiling
@@ -29,6 +32,9 @@ class Project(ConanFile):
     def build_requirements(self):
         self.tool_requires("coco-toolchain/pow10", options={"platform": self.options.platform})
         self.test_requires("coco-devboards/pow10", options={"platform": self.options.platform})
+        if self.options.platform == "native":
+            self.test_requires("gtest/1.14.0")
+            self.test_requires("benchmark/1.8.3")
 
     keep_imports = True
     def imports(self):
@@ -38,12 +44,12 @@ class Project(ConanFile):
 
     def build(self):
         cmake = CMake(self)
-        cmake.configure()
+        cmake.configure(variables={"COCO_LEDSTRIP_STATISTICS": "ON" if self.options.statistics else "OFF"})
         cmake.build()
 
         # run unit tests if CONAN_RUN_TESTS environment variable is set to 1
-        #if os.getenv("CONAN_RUN_TESTS") == "1" and not self.cross():
-        #    cmake.test()
+        if os.getenv("CONAN_RUN_TESTS") == "1" and not self.cross():
+            cmake.test()
 
     def package(self):
         # install from build directory into package directory
@@ -52,3 +58,7 @@ class Project(ConanFile):
 
     def package_info(self):
         self.cpp_info.libs = [self.name]
+
+        # statistics change the layout of the drivers, therefore users of the package need the same definition
+        if self.options.statistics:
+            self.cpp_info.defines = ["COCO_LEDSTRIP_STATISTICS"]
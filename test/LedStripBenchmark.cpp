@@ -0,0 +1,411 @@
+#include <benchmark/benchmark.h>
+#include <coco/FrameCodec.hpp>
+#include <coco/LedDecoder.hpp>
+#include <coco/LedDither.hpp>
+#include <coco/LedEncoder.hpp>
+#include <coco/LedTransform.hpp>
+#include <coco/platform/LedStrip_cout.hpp>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+
+/*
+	Benchmarks of the hot paths of the LED strip drivers on the native platform.
+	Each benchmark gets the strip length in number of RGB LEDs as argument and reports time/LED and bytes/s of LED data.
+	Use --benchmark_format=json or --benchmark_out=<file> for machine readable output.
+*/
+
+using namespace coco;
+
+// strip lengths from 16 to 65536 LEDs
+#define STRIP_LENGTHS RangeMultiplier(4)->Range(16, 65536)
+
+// chunk sizes of the interrupt handlers in bytes, multiples of 3
+#define CHUNK_SIZES Arg(12)->Arg(48)->Arg(192)->Arg(768)->Arg(3000)
+
+// generate test data
+static std::vector<uint8_t> generateData(int size) {
+	std::vector<uint8_t> data(size);
+	uint32_t x = 12345;
+	for (int i = 0; i < size; ++i) {
+		x = x * 1103515245 + 12345;
+		data[i] = x >> 16;
+	}
+	return data;
+}
+
+// set counters for time per LED (e.g. 2.5ns) and bytes/s
+static void setCounters(benchmark::State &state, int ledCount, int byteCount) {
+	state.counters["time/LED"] = benchmark::Counter(ledCount,
+		benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+	state.SetBytesProcessed(int64_t(state.iterations()) * byteCount);
+}
+
+
+// encoders
+
+template <typename E>
+static void encode(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(ledCount * 3);
+	std::vector<typename E::Word> buffer(E::wordCount(data.size()));
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(E::encode(data, buffer));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, data.size());
+}
+BENCHMARK(encode<LedEncoder_I2S>)->STRIP_LENGTHS;
+BENCHMARK(encode<LedEncoder_SPI<3>>)->STRIP_LENGTHS;
+BENCHMARK(encode<LedEncoder_UART>)->STRIP_LENGTHS;
+BENCHMARK(encode<LedEncoder_SPI<4>>)->STRIP_LENGTHS;
+BENCHMARK(encode<LedEncoder_SPI<8>>)->STRIP_LENGTHS;
+
+// encoders with color transform, fused and as separate pass over the data
+
+static LedTransform makeTransform() {
+	LedTransform transform;
+	transform.setOrder({1, 0, 2});
+	transform.set(200, 2.2f);
+	return transform;
+}
+
+template <typename E>
+static void encodeTransform(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(ledCount * 3);
+	std::vector<typename E::Word> buffer(E::wordCount(data.size()));
+	auto transform = makeTransform();
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(E::encode(data, buffer, transform, 0));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, data.size());
+}
+BENCHMARK(encodeTransform<LedEncoder_I2S>)->STRIP_LENGTHS;
+BENCHMARK(encodeTransform<LedEncoder_UART>)->STRIP_LENGTHS;
+
+template <typename E>
+static void transformThenEncode(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(ledCount * 3);
+	std::vector<uint8_t> transformed(data.size());
+	std::vector<typename E::Word> buffer(E::wordCount(data.size()));
+	auto transform = makeTransform();
+
+	for (auto _ : state) {
+		for (int i = 0; i < int(data.size()); i += 3) {
+			for (int c = 0; c < 3; ++c)
+				transformed[i + c] = transform(data.data() + i, c);
+		}
+		benchmark::DoNotOptimize(E::encode(transformed, buffer));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, data.size());
+}
+BENCHMARK(transformThenEncode<LedEncoder_I2S>)->STRIP_LENGTHS;
+BENCHMARK(transformThenEncode<LedEncoder_UART>)->STRIP_LENGTHS;
+
+// encoders with temporal dithering of 16 bit channels, fused and as separate pass over the data. The argument 300
+// corresponds to a 300 LED strip, at 400 frames/s the encoder gets 8.3μs per LED
+
+template <typename E>
+static void encodeDither(benchmark::State &state) {
+	int ledCount = state.range(0);
+	int channelCount = ledCount * 3;
+	auto bytes = generateData(channelCount * 2);
+	std::vector<uint8_t> residual(channelCount);
+	LedDither dither(residual.data(), residual.size());
+	std::vector<typename E::Word> buffer(E::wordCount(channelCount));
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(E::encode(dither.reader(bytes.data(), 0), channelCount, buffer));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, bytes.size());
+}
+BENCHMARK(encodeDither<LedEncoder_I2S>)->Arg(300)->STRIP_LENGTHS;
+BENCHMARK(encodeDither<LedEncoder_UART>)->Arg(300)->STRIP_LENGTHS;
+
+template <typename E>
+static void ditherThenEncode(benchmark::State &state) {
+	int ledCount = state.range(0);
+	int channelCount = ledCount * 3;
+	auto bytes = generateData(channelCount * 2);
+	std::vector<uint8_t> residual(channelCount);
+	std::vector<uint8_t> dithered(channelCount);
+	std::vector<typename E::Word> buffer(E::wordCount(channelCount));
+
+	for (auto _ : state) {
+		for (int i = 0; i < channelCount; ++i)
+			dithered[i] = LedDither::next((bytes[i * 2] << 8) | bytes[i * 2 + 1], residual[i]);
+		benchmark::DoNotOptimize(E::encode(dithered, buffer));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, bytes.size());
+}
+BENCHMARK(ditherThenEncode<LedEncoder_I2S>)->Arg(300)->STRIP_LENGTHS;
+BENCHMARK(ditherThenEncode<LedEncoder_UART>)->Arg(300)->STRIP_LENGTHS;
+
+
+// bit-sliced encoder for parallel strips, the argument is the length of each strip, time/LED is per LED of all strips
+
+template <int N>
+static void encodeParallel(benchmark::State &state) {
+	using Encoder = LedEncoder_Parallel<N>;
+	int ledCount = state.range(0);
+	auto data = generateData(N * ledCount * 3);
+	std::vector<typename Encoder::Word> buffer(Encoder::wordCount(ledCount * 3));
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Encoder::encode(data.data(), ledCount * 3, ledCount * 3, buffer));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, N * ledCount, data.size());
+}
+BENCHMARK(encodeParallel<8>)->STRIP_LENGTHS;
+BENCHMARK(encodeParallel<16>)->STRIP_LENGTHS;
+
+// PWM encoder for N interleaved strips, the argument is the length of each strip, time/LED is per LED of all strips
+
+template <int N>
+static void encodePWM(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(N * ledCount * 3);
+	std::vector<uint8_t> buffer(LedEncoder_PWM<>::wordCount(ledCount * 3, N));
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(LedEncoder_PWM<>::encode(data.data(), ledCount * 3, N, ledCount * 3, 64, 128,
+			buffer));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, N * ledCount, data.size());
+}
+BENCHMARK(encodePWM<1>)->STRIP_LENGTHS;
+BENCHMARK(encodePWM<4>)->STRIP_LENGTHS;
+
+// bit matrix transpose kernels of the parallel encoder
+
+static void transpose8x8(benchmark::State &state) {
+	auto data = generateData(8 * 1024);
+	std::vector<uint64_t> matrices(1024);
+	std::memcpy(matrices.data(), data.data(), data.size());
+
+	for (auto _ : state) {
+		for (auto &x : matrices)
+			x = transpose8x8(x);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(int64_t(state.iterations()) * matrices.size());
+}
+BENCHMARK(transpose8x8);
+
+static void transpose16x16(benchmark::State &state) {
+	auto data = generateData(32 * 1024);
+	std::vector<uint16_t> matrices(16 * 1024);
+	std::memcpy(matrices.data(), data.data(), data.size());
+	uint16_t dst[16];
+
+	for (auto _ : state) {
+		for (int i = 0; i < 1024; ++i) {
+			transpose16x16(matrices.data() + i * 16, dst);
+			benchmark::DoNotOptimize(dst);
+		}
+	}
+	state.SetItemsProcessed(int64_t(state.iterations()) * 1024);
+}
+BENCHMARK(transpose16x16);
+
+
+// encoding of one chunk as done by the interrupt handlers of LedStrip_I2S and LedStrip_UART_DMA, gets the chunk size
+// in bytes as argument and reports the number of interrupts for a strip of 2000 RGB LEDs (see chunk size table in
+// README.md)
+
+template <typename E>
+static void encodeChunk(benchmark::State &state) {
+	int chunkSize = state.range(0);
+	auto data = generateData(chunkSize);
+	std::vector<typename E::Word> buffer(E::wordCount(chunkSize));
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(E::encode(data, buffer));
+		benchmark::ClobberMemory();
+	}
+	state.counters["irqs/frame"] = (2000 * 3 + chunkSize - 1) / chunkSize;
+	state.SetBytesProcessed(int64_t(state.iterations()) * chunkSize);
+}
+BENCHMARK(encodeChunk<LedEncoder_I2S>)->CHUNK_SIZES;
+BENCHMARK(encodeChunk<LedEncoder_UART>)->CHUNK_SIZES;
+
+// I2S encoder using the lookup table instead of SIMD
+static void encodeTable_I2S(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(ledCount * 3);
+	std::vector<uint32_t> buffer(data.size());
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(LedEncoder_I2S::encodeTable(data, buffer));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, data.size());
+}
+BENCHMARK(encodeTable_I2S)->STRIP_LENGTHS;
+
+
+// waveform decoder with timing check, e.g. for fuzzing the encoders
+
+static void decode_I2S(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(ledCount * 3);
+	std::vector<uint32_t> words(data.size());
+	LedEncoder_I2S::encode(data, words);
+	LedWaveform waveform;
+	waveform.appendI2S(words, 375);
+	waveform.append(false, 80000);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(LedDecoder::decode(waveform, timings::WS2812B));
+	}
+	setCounters(state, ledCount, data.size());
+}
+BENCHMARK(decode_I2S)->STRIP_LENGTHS;
+
+
+// reset padding (clear I2S words after the LED data)
+
+static void resetFill(benchmark::State &state) {
+	int ledCount = state.range(0);
+	std::vector<uint32_t> buffer(ledCount * 3);
+
+	for (auto _ : state) {
+		std::fill(buffer.begin(), buffer.end(), 0);
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, buffer.size() * sizeof(uint32_t));
+}
+BENCHMARK(resetFill)->STRIP_LENGTHS;
+
+
+// ASCII renderer of LedStrip_cout
+
+static void renderAscii(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(ledCount * 3);
+	std::ostringstream s;
+
+	for (auto _ : state) {
+		s.str({});
+		LedStrip_cout::render(s, data.data(), ledCount);
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, data.size());
+}
+BENCHMARK(renderAscii)->STRIP_LENGTHS;
+
+// render into a line that gets reused as LedStrip_cout does for each frame
+static void renderLine(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(ledCount * 3);
+	std::string line;
+
+	for (auto _ : state) {
+		line.clear();
+		LedStrip_cout::render(line, data.data(), ledCount);
+		benchmark::DoNotOptimize(line.data());
+	}
+	setCounters(state, ledCount, data.size());
+}
+BENCHMARK(renderLine)->STRIP_LENGTHS;
+
+static void renderColor(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto data = generateData(ledCount * 3);
+	std::string line;
+
+	for (auto _ : state) {
+		line.clear();
+		LedStrip_cout::renderColor(line, data.data(), ledCount);
+		benchmark::DoNotOptimize(line.data());
+	}
+	setCounters(state, ledCount, data.size());
+}
+BENCHMARK(renderColor)->STRIP_LENGTHS;
+
+
+
+// frame codec, reports the compression ratio (frame size / encoded size)
+
+// two successive frames at 60 frames/s of the effect in test/LedStripTest.cpp (all LEDs change slowly) or of a
+// sparkle effect where 5% of the LEDs change
+static std::pair<std::vector<uint8_t>, std::vector<uint8_t>> generateFrames(int ledCount, bool sparkle) {
+	std::vector<uint8_t> frames[2];
+	for (int f = 0; f < 2; ++f) {
+		auto &frame = frames[f];
+		if (sparkle) {
+			frame = generateData(ledCount * 3);
+			if (f == 1) {
+				auto other = generateData(ledCount * 3 + 1);
+				for (int i = 0; i < ledCount; i += 20)
+					std::copy(&other[i * 3 + 1], &other[i * 3 + 4], &frame[i * 3]);
+			}
+		} else {
+			int time = 1000 + f * 17;
+			frame.resize(ledCount * 3);
+			for (int i = 0; i < ledCount; ++i) {
+				for (int c = 0; c < 3; ++c) {
+					int x = i + time * (c + 1) / 32;
+					frame[i * 3 + c] = (x & 256) ? 255 - x : x;
+				}
+			}
+		}
+	}
+	return {frames[0], frames[1]};
+}
+
+template <int P, bool S>
+static void frameEncode(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto [previous, current] = generateFrames(ledCount, S);
+	std::vector<uint8_t> encoded(FrameCodec::maxSize(current.size()));
+
+	int size = 0;
+	for (auto _ : state) {
+		size = FrameCodec::encode(previous, current, encoded.data(), P);
+		benchmark::DoNotOptimize(size);
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, current.size());
+	state.counters["ratio"] = double(current.size()) / std::max(size, 1);
+}
+BENCHMARK(frameEncode<1, false>)->Arg(300)->STRIP_LENGTHS;
+BENCHMARK(frameEncode<3, false>)->Arg(300)->STRIP_LENGTHS;
+BENCHMARK(frameEncode<1, true>)->Arg(300)->STRIP_LENGTHS;
+BENCHMARK(frameEncode<3, true>)->Arg(300)->STRIP_LENGTHS;
+
+template <int P, bool S>
+static void frameDecode(benchmark::State &state) {
+	int ledCount = state.range(0);
+	auto [previous, current] = generateFrames(ledCount, S);
+	std::vector<uint8_t> encoded(FrameCodec::maxSize(current.size()));
+	encoded.resize(FrameCodec::encode(previous, current, encoded.data(), P));
+
+	// decoding toggles the frame between previous and current
+	auto frame = previous;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(FrameCodec::decode(encoded, frame, P));
+		benchmark::ClobberMemory();
+	}
+	setCounters(state, ledCount, current.size());
+	state.counters["ratio"] = double(current.size()) / std::max(int(encoded.size()), 1);
+}
+BENCHMARK(frameDecode<1, false>)->Arg(300)->STRIP_LENGTHS;
+BENCHMARK(frameDecode<3, false>)->Arg(300)->STRIP_LENGTHS;
+BENCHMARK(frameDecode<1, true>)->Arg(300)->STRIP_LENGTHS;
+BENCHMARK(frameDecode<3, true>)->Arg(300)->STRIP_LENGTHS;
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,1113 @@
+#include <gtest/gtest.h>
+#include <coco/platform/LedStrip_I2S.hpp>
+#include <coco/platform/LedStrip_PWM.hpp>
+#include <coco/platform/LedStrip_UART_DMA.hpp>
+#include <coco/platform/LedStrip_SPI_DMA.hpp>
+#include <coco/platform/LedStrip_TIM_DMA.hpp>
+#include <coco/platform/LedStrip_Parallel_TIM_DMA.hpp>
+#include <coco/MultiBufferStrip.hpp>
+#include <Simulator.hpp>
+#include <vector>
+
+
+/*
+	Tests of the firmware drivers on simulated peripherals (see sim/). The simulators record the waveform so that it
+	can be decoded and checked against the timing specification of the LEDs.
+*/
+
+using namespace coco;
+
+// helpers
+
+// generate test data
+std::vector<uint8_t> generateData(int size) {
+	std::vector<uint8_t> data(size);
+	uint32_t x = 12345;
+	for (int i = 0; i < size; ++i) {
+		x = x * 1103515245 + 12345;
+		data[i] = x >> 16;
+	}
+	return data;
+}
+
+// drivers with reset time 75us
+template <int C = 48>
+class LedStrip_I2S_sim : public LedStrip_I2S_Chunked<C> {
+public:
+	LedStrip_I2S_sim(Loop_Queue &loop, int bitTime = 1125)
+		: LedStrip_I2S_Chunked<C>(loop, gpio::Config::P1_14, gpio::Config::P0_2, gpio::Config::P0_3, bitTime, 75) {}
+};
+
+// PWM0 OUT[0] - OUT[N-1] with T0H = 375ns and T1H = 750ns
+template <int N, int C = 48>
+class LedStrip_PWM_sim : public LedStrip_PWM_Chunked<N, C> {
+public:
+	LedStrip_PWM_sim(Loop_Queue &loop, sim::NrfPwmSimulator &sim, int bitTime = 1250)
+		: LedStrip_PWM_Chunked<N, C>(loop, pins(), sim.pwm(), PWM0_IRQn, bitTime, 375, 750, 75) {}
+
+	static std::array<gpio::Config, N> pins() {
+		const gpio::Config all[] = {gpio::Config::P0_2, gpio::Config::P0_3, gpio::Config::P0_4, gpio::Config::P0_5};
+		std::array<gpio::Config, N> pins;
+		for (int i = 0; i < N; ++i)
+			pins[i] = all[i];
+		return pins;
+	}
+};
+
+template <int C = 48>
+class LedStrip_UART_DMA_sim : public LedStrip_UART_DMA_Chunked<C> {
+public:
+	LedStrip_UART_DMA_sim(Loop_Queue &loop, sim::UartSimulator &sim, int clock = 170000, int bitTime = 1125)
+		: LedStrip_UART_DMA_Chunked<C>(loop, gpio::Config::PC4 | gpio::Config::AF7, sim.usartInfo(), sim.dmaInfo(),
+			LedStrip_UART_DMA::calcBrr(clock, bitTime),
+			LedStrip_UART_DMA::calcResetCount(clock, LedStrip_UART_DMA::calcBrr(clock, bitTime), 75)) {}
+};
+
+template <int C = 48>
+class LedStrip_SPI_DMA_sim : public LedStrip_SPI_DMA_Chunked<C> {
+public:
+	LedStrip_SPI_DMA_sim(Loop_Queue &loop, sim::SpiSimulator &sim, int symbolBits = 3, int clock = 170000,
+		int bitTime = 1125)
+		: LedStrip_SPI_DMA_Chunked<C>(loop, gpio::Config::PA7 | gpio::Config::AF5, sim.spiInfo(), sim.dmaInfo(),
+			LedStrip_SPI_DMA::calcPrescaler(clock, bitTime, symbolBits), symbolBits,
+			LedStrip_SPI_DMA::calcResetCount(clock, LedStrip_SPI_DMA::calcPrescaler(clock, bitTime, symbolBits), 75)) {}
+};
+
+// TIM1 CH1 - CHN with T0H = 400ns and T1H = 800ns
+template <int N, int C = 48>
+class LedStrip_TIM_DMA_sim : public LedStrip_TIM_DMA_Chunked<N, C> {
+public:
+	LedStrip_TIM_DMA_sim(Loop_Queue &loop, sim::PwmSimulator &sim, int clock = 170000, int bitTime = 1250)
+		: LedStrip_TIM_DMA_Chunked<N, C>(loop, pins(), sim.timerInfo(), sim.dmaInfo(), sim.timerDma(),
+			LedStrip_TIM_DMA::calcArr(clock, bitTime), LedStrip_TIM_DMA::calcCompare(clock, 400),
+			LedStrip_TIM_DMA::calcCompare(clock, 800),
+			LedStrip_TIM_DMA::calcResetCount(clock, LedStrip_TIM_DMA::calcArr(clock, bitTime), 75)) {}
+
+	static std::array<gpio::Config, N> pins() {
+		const gpio::Config all[] = {gpio::Config::PA8, gpio::Config::PA9, gpio::Config::PA10, gpio::Config::PA11};
+		std::array<gpio::Config, N> pins;
+		for (int i = 0; i < N; ++i)
+			pins[i] = all[i] | gpio::Config::AF6;
+		return pins;
+	}
+};
+
+class LedStrip_Parallel_TIM_DMA_sim : public LedStrip_Parallel_TIM_DMA_Chunked<> {
+public:
+	LedStrip_Parallel_TIM_DMA_sim(Loop_Queue &loop, sim::ParallelSimulator &sim, int firstPin, int clock = 170000,
+		int bitTime = 1125)
+		: LedStrip_Parallel_TIM_DMA_Chunked<>(loop, sim.port(), firstPin, sim.timerInfo(), sim.dmaInfo(),
+			sim.timerDma(), calcArr(clock, bitTime), calcResetCount(clock, calcArr(clock, bitTime), 75)) {}
+};
+
+constexpr double RESET_TIME = 75000;
+
+// RGB to GRB with gamma and white balance
+LedTransform makeTransform() {
+	LedTransform transform;
+	transform.setOrder({1, 0, 2});
+	transform.set(200, 2.2f, {255, 220, 180, 255});
+	return transform;
+}
+
+// apply a transform to whole pixels
+std::vector<uint8_t> applyTransform(const LedTransform &transform, const std::vector<uint8_t> &data) {
+	std::vector<uint8_t> result(data.size());
+	int n = transform.channelCount;
+	for (size_t i = 0; i < data.size(); ++i)
+		result[i] = transform(data.data() + i / n * n, i % n);
+	return result;
+}
+
+// generate test data with 16 bit channels
+std::vector<uint16_t> generateData16(int size) {
+	auto bytes = generateData(size * 2);
+	std::vector<uint16_t> data(size);
+	std::memcpy(data.data(), bytes.data(), bytes.size());
+	return data;
+}
+
+// store 16 bit channels MSB first
+void store16(const std::vector<uint16_t> &data, uint8_t *dst) {
+	for (auto value : data) {
+		*dst++ = value >> 8;
+		*dst++ = value;
+	}
+}
+
+// apply dithering to the data of one frame
+std::vector<uint8_t> applyDither(LedDither &dither, const std::vector<uint16_t> &data) {
+	std::vector<uint8_t> result(data.size());
+	for (size_t i = 0; i < data.size(); ++i)
+		result[i] = LedDither::next(data[i], dither.residual[i]);
+	return result;
+}
+
+
+// fixtures of the drivers for the common tests: simulator, driver with chunk size C, buffer, interrupt handler,
+// waveform of a strip and number of interrupts
+template <int N>
+struct PwmFixture {
+	static constexpr int STRIP_COUNT = N;
+	template <int C> using Driver = LedStrip_PWM_sim<N, C>;
+	template <int S> using Buffer = LedStrip_PWM::Buffer<S>;
+
+	static sim::NrfPwmSimulator simulator() {return sim::NrfPwmSimulator();}
+	static bool run(sim::NrfPwmSimulator &sim, LedStrip_PWM &ledStrip) {
+		return sim.run([&ledStrip] {ledStrip.PWM_IRQHandler();});
+	}
+
+	// in grouped mode (2 strips) the second strip is on OUT[2]
+	static const LedWaveform &waveform(sim::NrfPwmSimulator &sim, int strip) {
+		return sim.waveforms[N == 2 ? strip * 2 : strip];
+	}
+	static int irqCount(sim::NrfPwmSimulator &sim) {return sim.irq.count;}
+};
+
+struct SpiDmaFixture {
+	static constexpr int STRIP_COUNT = 1;
+	template <int C> using Driver = LedStrip_SPI_DMA_sim<C>;
+	template <int S> using Buffer = LedStrip_SPI_DMA::Buffer<S>;
+
+	static sim::SpiSimulator simulator() {return sim::SpiSimulator(170000000);}
+	static bool run(sim::SpiSimulator &sim, LedStrip_SPI_DMA &ledStrip) {
+		return sim.run([&ledStrip] {ledStrip.DMA_IRQHandler();});
+	}
+	static const LedWaveform &waveform(sim::SpiSimulator &sim, int) {return sim.waveform;}
+	static int irqCount(sim::SpiSimulator &sim) {return sim.dmaIrq.count;}
+};
+
+template <int N>
+struct TimDmaFixture {
+	static constexpr int STRIP_COUNT = N;
+	template <int C> using Driver = LedStrip_TIM_DMA_sim<N, C>;
+	template <int S> using Buffer = LedStrip_TIM_DMA::Buffer<S>;
+
+	static sim::PwmSimulator simulator() {return sim::PwmSimulator(170000000);}
+	static bool run(sim::PwmSimulator &sim, LedStrip_TIM_DMA &ledStrip) {
+		return sim.run([&ledStrip] {ledStrip.DMA_IRQHandler();});
+	}
+	static const LedWaveform &waveform(sim::PwmSimulator &sim, int strip) {return sim.waveforms[strip];}
+	static int irqCount(sim::PwmSimulator &sim) {return sim.dmaIrq.count;}
+};
+
+// get the part of a strip from data that contains all strips one after another
+std::vector<uint8_t> stripData(const std::vector<uint8_t> &data, int stripCount, int strip) {
+	int size = data.size() / stripCount;
+	return std::vector<uint8_t>(data.begin() + strip * size, data.begin() + (strip + 1) * size);
+}
+
+// the second transfer gets started from the interrupt handler while the first one is still running
+template <typename F>
+void testDoubleBuffer() {
+	constexpr int N = F::STRIP_COUNT;
+	auto sim = F::simulator();
+	Loop_Queue loop;
+	typename F::template Driver<48> ledStrip(loop, sim);
+	typename F::template Buffer<N * 300 * 3> buffer1(ledStrip);
+	typename F::template Buffer<N * 300 * 3> buffer2(ledStrip);
+
+	auto data1 = generateData(N * 300 * 3);
+	auto data2 = generateData(N * 5 * 3);
+	std::copy(data1.begin(), data1.end(), buffer1.template pointer<uint8_t>());
+	std::copy(data2.begin(), data2.end(), buffer2.template pointer<uint8_t>());
+	buffer1.startWrite(data1.size());
+	buffer2.startWrite(data2.size());
+	EXPECT_TRUE(F::run(sim, ledStrip));
+	EXPECT_EQ(loop.process(), 2);
+
+	for (int strip = 0; strip < N; ++strip) {
+		auto result = LedDecoder::decode(F::waveform(sim, strip), timings::WS2812B);
+		ASSERT_EQ(result.frames.size(), 2);
+		EXPECT_EQ(result.frames[0].data, stripData(data1, N, strip)) << "strip " << strip;
+		EXPECT_EQ(result.frames[1].data, stripData(data2, N, strip)) << "strip " << strip;
+		EXPECT_GE(result.reset.min, RESET_TIME);
+		EXPECT_EQ(result.errorCount, 0);
+	}
+}
+
+// send 2000 LEDs with chunk size C, returns the number of interrupts in addition to one per chunk
+template <typename F, int C>
+int testChunkSize() {
+	auto sim = F::simulator();
+	Loop_Queue loop;
+	typename F::template Driver<C> ledStrip(loop, sim);
+	typename F::template Buffer<2000 * 3> buffer(ledStrip);
+
+	auto data = generateData(2000 * 3);
+	std::copy(data.begin(), data.end(), buffer.template pointer<uint8_t>());
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(F::run(sim, ledStrip));
+	EXPECT_EQ(loop.process(), 1);
+
+	auto result = LedDecoder::decode(F::waveform(sim, 0), timings::WS2812B);
+	EXPECT_EQ(result.frames.size(), 1);
+	if (!result.frames.empty())
+		EXPECT_EQ(result.frames[0].data, data);
+	EXPECT_EQ(result.errorCount, 0);
+	EXPECT_GE(result.reset.min, RESET_TIME);
+
+	return F::irqCount(sim) - (2000 * 3 + C - 1) / C;
+}
+
+
+// LedStrip_I2S
+
+TEST(cocoTest, LedStrip_I2S) {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim ledStrip(loop);
+	LedStrip_I2S::Buffer<300 * 3> buffer(ledStrip);
+
+	EXPECT_NEAR(sim.bitTime().count(), 1125.0 / 3, 5.0);
+
+	// lengths that fill the LED buffer partially, exactly and multiple times
+	for (int size : {3, 48, 96, 100, 300 * 3}) {
+		auto data = generateData(size);
+		std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+		sim.waveform.clear();
+
+		buffer.startWrite(size);
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+		EXPECT_EQ(loop.process(), 1);
+
+		auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+		ASSERT_EQ(result.frames.size(), 1);
+		EXPECT_EQ(result.frames[0].data, data);
+		EXPECT_EQ(result.frames[0].bitCount, size * 8);
+		EXPECT_GE(result.frames[0].resetTime, RESET_TIME);
+		EXPECT_EQ(result.errorCount, 0);
+	}
+	EXPECT_EQ(sim.underrunCount, 0);
+	RecordProperty("maxIrqTimeNs", int(sim.irq.maxTime.count()));
+}
+
+TEST(cocoTest, LedStrip_I2S_DoubleBuffer) {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim ledStrip(loop);
+	LedStrip_I2S::Buffer<300 * 3> buffer1(ledStrip);
+	LedStrip_I2S::Buffer<300 * 3> buffer2(ledStrip);
+
+	// second transfer gets started by the interrupt handler when the first has finished
+	auto data1 = generateData(300 * 3);
+	auto data2 = generateData(5 * 3);
+	std::copy(data1.begin(), data1.end(), buffer1.pointer<uint8_t>());
+	std::copy(data2.begin(), data2.end(), buffer2.pointer<uint8_t>());
+	buffer1.startWrite(data1.size());
+	buffer2.startWrite(data2.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 2);
+	EXPECT_EQ(result.frames[0].data, data1);
+	EXPECT_EQ(result.frames[1].data, data2);
+	EXPECT_GE(result.reset.min, RESET_TIME);
+	EXPECT_EQ(result.errorCount, 0);
+	EXPECT_EQ(sim.underrunCount, 0);
+}
+
+TEST(cocoTest, LedStrip_I2S_BitTimes) {
+	// MCKFREQ gets rounded, check that the bit times are still within the timing specification of the LEDs
+	for (int bitTime : {1125, 1200, 1250}) {
+		sim::I2sSimulator sim;
+		Loop_Queue loop;
+		LedStrip_I2S_sim ledStrip(loop, bitTime);
+		LedStrip_I2S::Buffer<16 * 3> buffer(ledStrip);
+
+		auto data = generateData(16 * 3);
+		std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+		buffer.startWrite(data.size());
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+
+		auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+		ASSERT_EQ(result.frames.size(), 1);
+		EXPECT_EQ(result.frames[0].data, data);
+		EXPECT_EQ(result.errorCount, 0) << "bit time " << bitTime << "ns";
+
+		// 3 bits per LED bit can't meet the SK6812 low time of a one bit
+		EXPECT_GT(LedDecoder::decode(sim.waveform, timings::SK6812).errorCount, 0);
+	}
+}
+
+template <int C>
+void testChunkSize_I2S() {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim<C> ledStrip(loop);
+	LedStrip_I2S::Buffer<2000 * 3> buffer(ledStrip);
+
+	auto data = generateData(2000 * 3);
+	std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data, data);
+	EXPECT_EQ(result.errorCount, 0);
+	EXPECT_GE(result.reset.min, RESET_TIME);
+	EXPECT_EQ(sim.underrunCount, 0);
+
+	// one interrupt per chunk, some more for reset and idle
+	EXPECT_LE(sim.irq.count, (2000 * 3 + C - 1) / C + 8) << "chunk size " << C;
+}
+
+TEST(cocoTest, LedStrip_I2S_ChunkSizes) {
+	testChunkSize_I2S<12>();
+	testChunkSize_I2S<48>();
+	testChunkSize_I2S<192>();
+	testChunkSize_I2S<768>();
+}
+
+TEST(cocoTest, LedStrip_I2S_Transform) {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim ledStrip(loop);
+	LedStrip_I2S::Buffer<5 * 3> buffer1(ledStrip);
+	LedStrip_I2S::Buffer<300 * 3> buffer2(ledStrip);
+	LedStrip_I2S::CachedBuffer<300 * 3> buffer3(ledStrip);
+	auto transform = makeTransform();
+	ledStrip.setTransform(&transform);
+
+	// the first buffer leaves the LED buffer partially filled, so that the chunks of the second buffer split pixels
+	auto data1 = generateData(5 * 3);
+	auto data2 = generateData(300 * 3);
+	std::reverse(data2.begin(), data2.end());
+	std::copy(data1.begin(), data1.end(), buffer1.pointer<uint8_t>());
+	std::copy(data2.begin(), data2.end(), buffer2.pointer<uint8_t>());
+	std::copy(data2.begin(), data2.end(), buffer3.pointer<uint8_t>());
+	buffer1.startWrite(data1.size());
+	buffer2.startWrite(data2.size());
+	buffer3.startWrite(data2.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 3);
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 3);
+	EXPECT_EQ(result.frames[0].data, applyTransform(transform, data1));
+	EXPECT_EQ(result.frames[1].data, applyTransform(transform, data2));
+	EXPECT_EQ(result.frames[2].data, applyTransform(transform, data2));
+
+	// a change of the red channel of a cached buffer changes the second byte of the pixel
+	data2[30] = ~data2[30];
+	buffer3.pointer<uint8_t>()[30] = data2[30];
+	buffer3.setDirty(30, 31);
+	sim.waveform.clear();
+	buffer3.startWrite(data2.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data, applyTransform(transform, data2));
+}
+
+TEST(cocoTest, LedStrip_I2S_Dither) {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim ledStrip(loop);
+	LedStrip_I2S::Buffer<300 * 3 * 2> buffer1(ledStrip);
+	LedStrip_I2S::Buffer<300 * 3 * 2> buffer2(ledStrip);
+	LedDither_Buffer<300 * 3> dither;
+	LedDither_Buffer<300 * 3> expectedDither;
+	ledStrip.setDither(&dither);
+
+	// dark data where dithering makes a difference, the same frame gets sent four times
+	auto data = generateData16(300 * 3);
+	for (auto &value : data)
+		value >>= 6;
+	for (auto *buffer : {&buffer1, &buffer2}) {
+		store16(data, buffer->pointer<uint8_t>());
+		buffer->startWrite(data.size() * 2);
+	}
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+	for (auto *buffer : {&buffer1, &buffer2})
+		buffer->startWrite(data.size() * 2);
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 4);
+	for (auto &frame : result.frames)
+		EXPECT_EQ(frame.data, applyDither(expectedDither, data));
+	EXPECT_NE(result.frames[0].data, result.frames[1].data);
+}
+
+TEST(cocoTest, LedStrip_I2S_MultiBuffer) {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim ledStrip(loop);
+	LedStrip_I2S::Buffer<300 * 3> buffer1(ledStrip);
+	LedStrip_I2S::Buffer<300 * 3> buffer2(ledStrip);
+	LedStrip_I2S::Buffer<300 * 3> buffer3(ledStrip);
+	MultiBufferStrip<uint8_t, 3> strip(buffer1, buffer2, buffer3);
+	ASSERT_EQ(strip.size(), 300 * 3);
+
+	// render four frames faster than the LED strip: the first is in flight, the second and third get dropped
+	std::vector<std::vector<uint8_t>> frames;
+	for (int i = 0; i < 4; ++i) {
+		auto data = generateData(300 * 3);
+		std::rotate(data.begin(), data.begin() + i, data.end());
+		auto leds = strip.array();
+		std::copy(data.begin(), data.end(), leds.begin());
+		(void)strip.show();
+		frames.push_back(data);
+	}
+	EXPECT_EQ(strip.dropped, 2);
+
+	// the renderer always gets a free buffer
+	EXPECT_TRUE(buffer1.ready() || buffer2.ready() || buffer3.ready());
+
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 2);
+	EXPECT_EQ(result.frames[0].data, frames[0]);
+	EXPECT_EQ(result.frames[1].data, frames[3]);
+}
+
+TEST(cocoTest, LedStrip_I2S_CachedBuffer) {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim ledStrip(loop);
+	LedStrip_I2S::Buffer<5 * 3> buffer1(ledStrip);
+	LedStrip_I2S::CachedBuffer<300 * 3> buffer2(ledStrip);
+
+	// first transfer encodes all data
+	auto data = generateData(300 * 3);
+	std::copy(data.begin(), data.end(), buffer2.pointer<uint8_t>());
+	buffer2.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data, data);
+
+	// change some LEDs, a transfer of another buffer before leaves the LED buffer partially filled
+	for (int i = 30; i < 36; ++i)
+		data[i] = ~data[i];
+	data[600] = 0x55;
+	std::copy(data.begin(), data.end(), buffer2.pointer<uint8_t>());
+	buffer2.setDirty(30, 36);
+	buffer2.setDirty(600, 601);
+	auto data1 = generateData(5 * 3);
+	std::copy(data1.begin(), data1.end(), buffer1.pointer<uint8_t>());
+	sim.waveform.clear();
+	buffer1.startWrite(data1.size());
+	buffer2.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+	result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 2);
+	EXPECT_EQ(result.frames[0].data, data1);
+	EXPECT_EQ(result.frames[1].data, data);
+	EXPECT_EQ(result.errorCount, 0);
+	EXPECT_EQ(sim.underrunCount, 0);
+
+	// changes that are not marked as dirty don't get transferred
+	auto changed = data;
+	changed[0] = ~changed[0];
+	std::copy(changed.begin(), changed.end(), buffer2.pointer<uint8_t>());
+	sim.waveform.clear();
+	buffer2.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data, data);
+}
+
+
+TEST(cocoTest, LedStrip_I2S_CachedBufferRerender) {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim ledStrip(loop);
+	LedStrip_I2S::CachedBuffer<300 * 3> buffer1(ledStrip);
+	LedStrip_I2S::Buffer<5 * 3> buffer2(ledStrip);
+
+	// the cached buffer ends with a slice that the I2S reads from the cache, followed by a partial chunk
+	auto data1 = generateData(300 * 3);
+	auto data2 = generateData(5 * 3);
+	auto data3 = data1;
+	std::reverse(data3.begin(), data3.end());
+	std::copy(data1.begin(), data1.end(), buffer1.pointer<uint8_t>());
+	std::copy(data2.begin(), data2.end(), buffer2.pointer<uint8_t>());
+	buffer1.startWrite(data1.size());
+	buffer2.startWrite(data2.size());
+
+	// render the next frame into the cached buffer as soon as it is ready, this must not change the frame in progress
+	bool rendered = false;
+	EXPECT_TRUE(sim.run([&] {
+		ledStrip.I2S_IRQHandler();
+		loop.process();
+		if (!rendered && buffer1.ready()) {
+			std::copy(data3.begin(), data3.end(), buffer1.pointer<uint8_t>());
+			buffer1.setDirty(0, data3.size());
+			buffer1.startWrite(data3.size());
+			rendered = true;
+		}
+	}));
+	EXPECT_TRUE(rendered);
+	loop.process();
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 3);
+	EXPECT_EQ(result.frames[0].data, data1);
+	EXPECT_EQ(result.frames[1].data, data2);
+	EXPECT_EQ(result.frames[2].data, data3);
+	EXPECT_GE(result.reset.min, RESET_TIME);
+	EXPECT_EQ(result.errorCount, 0);
+}
+
+TEST(cocoTest, LedStrip_I2S_LargeTransfer) {
+	// cached buffers get transferred directly with one DMA pointer per chunk, the end gets copied into the LED buffer
+	constexpr int C = 4096;
+	for (int ledCount : {2000, 6000}) {
+		sim::I2sSimulator sim;
+		Loop_Queue loop;
+		LedStrip_I2S_sim<C> ledStrip(loop);
+		LedStrip_I2S::CachedBuffer<6000 * 3> buffer(ledStrip);
+
+		auto data = generateData(ledCount * 3);
+		std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+		buffer.startWrite(data.size());
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+		EXPECT_EQ(loop.process(), 1);
+
+		auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+		ASSERT_EQ(result.frames.size(), 1);
+		EXPECT_EQ(result.frames[0].data, data);
+		EXPECT_GE(result.frames[0].resetTime, RESET_TIME);
+		EXPECT_EQ(result.errorCount, 0);
+		EXPECT_EQ(sim.underrunCount, 0);
+
+		// one interrupt per chunk of data, a few for reset and idle
+		EXPECT_LE(sim.irq.count, (ledCount * 3 + C - 1) / C + 5);
+	}
+}
+
+TEST(cocoTest, LedStrip_I2S_Underrun) {
+	sim::I2sSimulator sim;
+	Loop_Queue loop;
+	LedStrip_I2S_sim ledStrip(loop);
+	LedStrip_I2S::Buffer<300 * 3> buffer(ledStrip);
+	ledStrip.enableUnderrunDetection(NRF_TIMER2, 0);
+
+	auto data = generateData(300 * 3);
+	std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+
+	// no underrun
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	auto &statistics = ledStrip.getStatistics();
+	EXPECT_EQ(statistics.underrunCount, 0);
+
+	// a delayed interrupt repeats a buffer which corrupts the frame
+	sim.waveform.clear();
+	sim.lateEvent = 5;
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.I2S_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	EXPECT_EQ(sim.underrunCount, 1);
+	EXPECT_EQ(statistics.underrunCount, 1);
+	EXPECT_EQ(statistics.frameCount, 2);
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].bitCount, (300 * 3 + 48) * 8);
+}
+
+
+// LedStrip_PWM
+
+template <int N>
+void testChannels_PWM() {
+	sim::NrfPwmSimulator sim;
+	Loop_Queue loop;
+	LedStrip_PWM_sim<N> ledStrip(loop, sim);
+	LedStrip_PWM::Buffer<4 * 300 * 3> buffer(ledStrip);
+
+	EXPECT_NEAR(sim.periodTime().count(), 1250, 1.0);
+
+	// lengths per strip that fill a sequence partially, exactly and multiple times
+	for (int size : {3, 48, 100, 300 * 3}) {
+		auto data = generateData(N * size);
+		std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+		for (auto &waveform : sim.waveforms)
+			waveform.clear();
+
+		buffer.startWrite(N * size);
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.PWM_IRQHandler();}));
+		EXPECT_EQ(loop.process(), 1);
+
+		// each channel sends its part of the buffer
+		for (int strip = 0; strip < N; ++strip) {
+			auto result = LedDecoder::decode(PwmFixture<N>::waveform(sim, strip), timings::WS2812B);
+			ASSERT_EQ(result.frames.size(), 1);
+			EXPECT_EQ(result.frames[0].data, std::vector<uint8_t>(data.begin() + strip * size,
+				data.begin() + (strip + 1) * size)) << "strips " << N << " strip " << strip;
+			EXPECT_EQ(result.frames[0].bitCount, size * 8);
+			EXPECT_GE(result.frames[0].resetTime, RESET_TIME);
+			EXPECT_EQ(result.errorCount, 0);
+		}
+	}
+}
+
+TEST(cocoTest, LedStrip_PWM) {
+	// common, grouped and individual load mode
+	testChannels_PWM<1>();
+	testChannels_PWM<2>();
+	testChannels_PWM<3>();
+	testChannels_PWM<4>();
+}
+
+TEST(cocoTest, LedStrip_PWM_DoubleBuffer) {
+	testDoubleBuffer<PwmFixture<4>>();
+}
+
+TEST(cocoTest, LedStrip_PWM_ChunkSizes) {
+	// one interrupt per chunk, some more for reset and idle
+	EXPECT_LE((testChunkSize<PwmFixture<1>, 12>()), 8);
+	EXPECT_LE((testChunkSize<PwmFixture<1>, 48>()), 8);
+	EXPECT_LE((testChunkSize<PwmFixture<1>, 192>()), 8);
+	EXPECT_LE((testChunkSize<PwmFixture<1>, 768>()), 8);
+}
+
+TEST(cocoTest, LedStrip_PWM_Statistics) {
+	ASSERT_TRUE(LedStripStatistics::ENABLED);
+	sim::NrfPwmSimulator sim;
+	Loop_Queue loop;
+	LedStrip_PWM_sim<2> ledStrip(loop, sim);
+	LedStrip_PWM::Buffer<2 * 300 * 3> buffer(ledStrip);
+
+	auto data = generateData(2 * 300 * 3);
+	std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+
+	// interrupts in time
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.PWM_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	auto &statistics = ledStrip.getStatistics();
+	EXPECT_EQ(statistics.irqCount, sim.irq.count);
+	EXPECT_GT(statistics.maxIrqTicks, 0);
+	EXPECT_EQ(statistics.underrunCount, 0);
+	EXPECT_EQ(statistics.frameCount, 1);
+	EXPECT_EQ(statistics.byteCount, data.size());
+
+	// a delayed interrupt sees both sequences ended
+	sim.lateEvent = 3;
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.PWM_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	EXPECT_EQ(statistics.underrunCount, 1);
+	EXPECT_EQ(statistics.frameCount, 2);
+	EXPECT_EQ(statistics.byteCount, 2 * data.size());
+
+	ledStrip.resetStatistics();
+	EXPECT_EQ(statistics.irqCount, 0);
+	EXPECT_EQ(statistics.byteCount, 0);
+}
+
+
+// LedStrip_UART_DMA
+
+TEST(cocoTest, LedStrip_UART_DMA) {
+	sim::UartSimulator sim(gpio::Config::PC4, 170000000);
+	Loop_Queue loop;
+	LedStrip_UART_DMA_sim ledStrip(loop, sim);
+	LedStrip_UART_DMA::Buffer<300 * 3> buffer(ledStrip);
+
+	EXPECT_NEAR(sim.bitTime().count(), 1125.0 / 3, 1e9 / 170000000);
+
+	for (int size : {3, 48, 96, 100, 300 * 3}) {
+		auto data = generateData(size);
+		std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+		sim.waveform.clear();
+
+		buffer.startWrite(size);
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+		EXPECT_EQ(loop.process(), 1);
+
+		// an incomplete last block is padded to whole UART frames
+		auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+		ASSERT_EQ(result.frames.size(), 1);
+		EXPECT_EQ(result.frames[0].data, data);
+		EXPECT_EQ(result.frames[0].bitCount, LedEncoder_UART::frameCount(size) * 3);
+		EXPECT_GE(result.frames[0].resetTime, RESET_TIME);
+		EXPECT_EQ(result.errorCount, 0);
+	}
+	RecordProperty("maxDmaIrqTimeNs", int(sim.dmaIrq.maxTime.count()));
+}
+
+TEST(cocoTest, LedStrip_UART_DMA_DoubleBuffer) {
+	sim::UartSimulator sim(gpio::Config::PC4, 170000000);
+	Loop_Queue loop;
+	LedStrip_UART_DMA_sim ledStrip(loop, sim);
+	LedStrip_UART_DMA::Buffer<300 * 3> buffer1(ledStrip);
+	LedStrip_UART_DMA::Buffer<300 * 3> buffer2(ledStrip);
+
+	auto data1 = generateData(300 * 3);
+	auto data2 = generateData(5 * 3);
+	std::copy(data1.begin(), data1.end(), buffer1.pointer<uint8_t>());
+	std::copy(data2.begin(), data2.end(), buffer2.pointer<uint8_t>());
+	buffer1.startWrite(data1.size());
+	buffer2.startWrite(data2.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 2);
+	EXPECT_EQ(result.frames[0].data, data1);
+	EXPECT_EQ(result.frames[1].data, data2);
+	EXPECT_GE(result.reset.min, RESET_TIME);
+	EXPECT_EQ(result.errorCount, 0);
+}
+
+template <int C>
+void testChunkSize_UART_DMA() {
+	sim::UartSimulator sim(gpio::Config::PC4, 170000000);
+	Loop_Queue loop;
+	LedStrip_UART_DMA_sim<C> ledStrip(loop, sim);
+	LedStrip_UART_DMA::Buffer<2000 * 3> buffer(ledStrip);
+
+	auto data = generateData(2000 * 3);
+	std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data, data);
+	EXPECT_EQ(result.errorCount, 0);
+	EXPECT_GE(result.reset.min, RESET_TIME);
+
+	// one DMA interrupt per chunk except the last, UART interrupts at the end of the data and of the reset time
+	EXPECT_EQ(sim.dmaIrq.count, (2000 * 3 + C - 1) / C - 1) << "chunk size " << C;
+	EXPECT_EQ(sim.uartIrq.count, 2);
+}
+
+TEST(cocoTest, LedStrip_UART_DMA_ChunkSizes) {
+	testChunkSize_UART_DMA<12>();
+	testChunkSize_UART_DMA<48>();
+	testChunkSize_UART_DMA<192>();
+	testChunkSize_UART_DMA<768>();
+}
+
+TEST(cocoTest, LedStrip_UART_DMA_Transform) {
+	sim::UartSimulator sim(gpio::Config::PC4, 170000000);
+	Loop_Queue loop;
+	LedStrip_UART_DMA_sim ledStrip(loop, sim);
+	LedStrip_UART_DMA::Buffer<300 * 3> buffer1(ledStrip);
+	LedStrip_UART_DMA::CachedBuffer<300 * 3> buffer2(ledStrip);
+	auto transform = makeTransform();
+	ledStrip.setTransform(&transform);
+
+	auto data = generateData(300 * 3);
+	std::copy(data.begin(), data.end(), buffer1.pointer<uint8_t>());
+	std::copy(data.begin(), data.end(), buffer2.pointer<uint8_t>());
+	buffer1.startWrite(data.size());
+	buffer2.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 2);
+	EXPECT_EQ(result.frames[0].data, applyTransform(transform, data));
+	EXPECT_EQ(result.frames[1].data, applyTransform(transform, data));
+
+	// a change of the red channel of a cached buffer changes the second byte of the pixel
+	data[33] = ~data[33];
+	buffer2.pointer<uint8_t>()[33] = data[33];
+	buffer2.setDirty(33, 34);
+	sim.waveform.clear();
+	buffer2.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data, applyTransform(transform, data));
+}
+
+TEST(cocoTest, LedStrip_UART_DMA_Dither) {
+	sim::UartSimulator sim(gpio::Config::PC4, 170000000);
+	Loop_Queue loop;
+	LedStrip_UART_DMA_sim ledStrip(loop, sim);
+	LedStrip_UART_DMA::Buffer<300 * 3 * 2> buffer1(ledStrip);
+	LedStrip_UART_DMA::Buffer<300 * 3 * 2> buffer2(ledStrip);
+	LedDither_Buffer<300 * 3> dither;
+	LedDither_Buffer<300 * 3> expectedDither;
+	ledStrip.setDither(&dither);
+
+	// dark data where dithering makes a difference, the same frame gets sent four times
+	auto data = generateData16(300 * 3);
+	for (auto &value : data)
+		value >>= 6;
+	for (auto *buffer : {&buffer1, &buffer2}) {
+		store16(data, buffer->pointer<uint8_t>());
+		buffer->startWrite(data.size() * 2);
+	}
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+	for (auto *buffer : {&buffer1, &buffer2})
+		buffer->startWrite(data.size() * 2);
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 2);
+
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 4);
+	for (auto &frame : result.frames)
+		EXPECT_EQ(frame.data, applyDither(expectedDither, data));
+	EXPECT_NE(result.frames[0].data, result.frames[1].data);
+}
+
+TEST(cocoTest, LedStrip_UART_DMA_CachedBuffer) {
+	sim::UartSimulator sim(gpio::Config::PC4, 170000000);
+	Loop_Queue loop;
+	LedStrip_UART_DMA_sim ledStrip(loop, sim);
+	LedStrip_UART_DMA::CachedBuffer<300 * 3> buffer(ledStrip);
+
+	// first transfer encodes all data, the CPU gets interrupted only at the end of the data and of the reset time
+	auto data = generateData(300 * 3);
+	std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data, data);
+	EXPECT_EQ(result.errorCount, 0);
+	EXPECT_GE(result.reset.min, RESET_TIME);
+	EXPECT_EQ(sim.dmaIrq.count, 0);
+	EXPECT_EQ(sim.uartIrq.count, 2);
+
+	// change some LEDs, the changed range does not start and end on a block boundary
+	for (int i = 31; i < 35; ++i)
+		data[i] = ~data[i];
+	std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+	buffer.setDirty(31, 35);
+	sim.waveform.clear();
+	buffer.startWrite(data.size());
+	EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+	EXPECT_EQ(loop.process(), 1);
+	result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data, data);
+
+	// transfer a size that is not a multiple of the block size (RGBW), then the full size again
+	for (int size : {100 * 4, 300 * 3}) {
+		sim.waveform.clear();
+		buffer.startWrite(size);
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+		EXPECT_EQ(loop.process(), 1);
+		result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+		ASSERT_EQ(result.frames.size(), 1);
+		EXPECT_EQ(result.frames[0].data, std::vector<uint8_t>(data.begin(), data.begin() + size));
+	}
+	EXPECT_EQ(sim.dmaIrq.count, 0);
+	EXPECT_EQ(sim.uartIrq.count, 4 * 2);
+}
+
+TEST(cocoTest, LedStrip_UART_DMA_Clocks) {
+	// peripheral clocks of the supported boards (stm32c031, stm32f334, stm32g431/g474) in kHz
+	for (int clock : {48000, 72000, 170000}) {
+		sim::UartSimulator sim(gpio::Config::PC4, clock * 1000);
+		Loop_Queue loop;
+		LedStrip_UART_DMA_sim ledStrip(loop, sim, clock);
+		LedStrip_UART_DMA::Buffer<16 * 3> buffer(ledStrip);
+
+		auto data = generateData(16 * 3);
+		std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+		buffer.startWrite(data.size());
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.UART_IRQHandler();}, [&ledStrip] {ledStrip.DMA_IRQHandler();}));
+
+		// check against the timing specification of the LEDs
+		auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+		ASSERT_EQ(result.frames.size(), 1);
+		EXPECT_EQ(result.frames[0].data, data);
+		EXPECT_EQ(result.errorCount, 0) << "clock " << clock << "kHz";
+		EXPECT_GE(result.reset.min, RESET_TIME);
+	}
+}
+
+
+// LedStrip_SPI_DMA
+
+TEST(cocoTest, LedStrip_SPI_DMA) {
+	// 170MHz / 64 with 3 SPI bits per LED bit and 104MHz / 32 with 4 SPI bits per LED bit
+	struct Config {int symbolBits; int clock; int bitTime;};
+	for (auto config : {Config{3, 170000, 1125}, Config{4, 104000, 1230}}) {
+		sim::SpiSimulator sim(config.clock * 1000);
+		Loop_Queue loop;
+		LedStrip_SPI_DMA_sim ledStrip(loop, sim, config.symbolBits, config.clock, config.bitTime);
+		LedStrip_SPI_DMA::Buffer<300 * 3> buffer(ledStrip);
+
+		EXPECT_NEAR(sim.bitTime().count() * config.symbolBits, config.bitTime, 10);
+
+		for (int size : {3, 48, 96, 100, 300 * 3}) {
+			auto data = generateData(size);
+			std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+			sim.waveform.clear();
+
+			buffer.startWrite(size);
+			EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.DMA_IRQHandler();}));
+			EXPECT_EQ(loop.process(), 1);
+
+			// the zeros that pad the last chunk only extend the reset time
+			auto result = LedDecoder::decode(sim.waveform, timings::WS2812B);
+			ASSERT_EQ(result.frames.size(), 1);
+			EXPECT_EQ(result.frames[0].data, data);
+			EXPECT_EQ(result.frames[0].bitCount, size * 8);
+			EXPECT_GE(result.frames[0].resetTime, RESET_TIME);
+			EXPECT_EQ(result.errorCount, 0) << config.symbolBits << " symbol bits";
+		}
+		RecordProperty("maxDmaIrqTimeNs", int(sim.dmaIrq.maxTime.count()));
+	}
+}
+
+TEST(cocoTest, LedStrip_SPI_DMA_DoubleBuffer) {
+	testDoubleBuffer<SpiDmaFixture>();
+}
+
+TEST(cocoTest, LedStrip_SPI_DMA_ChunkSizes) {
+	// one DMA interrupt per chunk and one for the half of zeros that is longer than the reset time
+	EXPECT_EQ((testChunkSize<SpiDmaFixture, 12>()), 1);
+	EXPECT_EQ((testChunkSize<SpiDmaFixture, 48>()), 1);
+	EXPECT_EQ((testChunkSize<SpiDmaFixture, 192>()), 1);
+	EXPECT_EQ((testChunkSize<SpiDmaFixture, 768>()), 1);
+}
+
+TEST(cocoTest, LedStrip_SPI_DMA_Prescaler) {
+	// nearest power of two divider
+	EXPECT_EQ(LedStrip_SPI_DMA::calcPrescaler(170000, 1125, 3), 5);
+	EXPECT_EQ(LedStrip_SPI_DMA::calcBitTime(170000, 5, 3), 1129);
+	EXPECT_EQ(LedStrip_SPI_DMA::calcPrescaler(104000, 1230, 4), 4);
+	EXPECT_EQ(LedStrip_SPI_DMA::calcPrescaler(1000000, 1, 3), 0);
+	EXPECT_EQ(LedStrip_SPI_DMA::calcPrescaler(1000, 1000000, 3), 7);
+
+	// 75us at 170MHz / 64 are 24.9 bytes
+	EXPECT_EQ(LedStrip_SPI_DMA::calcResetCount(170000, 5, 75), 25);
+}
+
+
+// LedStrip_TIM_DMA
+
+TEST(cocoTest, LedStrip_TIM_DMA) {
+	sim::PwmSimulator sim(170000000);
+	Loop_Queue loop;
+	LedStrip_TIM_DMA_sim<4> ledStrip(loop, sim);
+	LedStrip_TIM_DMA::Buffer<4 * 300 * 3> buffer(ledStrip);
+
+	EXPECT_NEAR(sim.periodTime().count(), 1250, 1e9 / 170000000);
+
+	for (int size : {3, 48, 100, 300 * 3}) {
+		auto data = generateData(4 * size);
+		std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+		for (auto &waveform : sim.waveforms)
+			waveform.clear();
+
+		buffer.startWrite(4 * size);
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.DMA_IRQHandler();}));
+		EXPECT_EQ(loop.process(), 1);
+
+		// each channel sends its part of the buffer
+		for (int strip = 0; strip < 4; ++strip) {
+			auto result = LedDecoder::decode(sim.waveforms[strip], timings::WS2812B);
+			ASSERT_EQ(result.frames.size(), 1);
+			EXPECT_EQ(result.frames[0].data, std::vector<uint8_t>(data.begin() + strip * size,
+				data.begin() + (strip + 1) * size)) << "strip " << strip;
+			EXPECT_EQ(result.frames[0].bitCount, size * 8);
+			EXPECT_GE(result.frames[0].resetTime, RESET_TIME);
+			EXPECT_EQ(result.errorCount, 0);
+		}
+	}
+	RecordProperty("maxDmaIrqTimeNs", int(sim.dmaIrq.maxTime.count()));
+}
+
+TEST(cocoTest, LedStrip_TIM_DMA_DoubleBuffer) {
+	testDoubleBuffer<TimDmaFixture<2>>();
+}
+
+TEST(cocoTest, LedStrip_TIM_DMA_ChunkSizes) {
+	// same DMA interrupts as LedStrip_SPI_DMA, the chunk size counts the bytes of one strip
+	EXPECT_EQ((testChunkSize<TimDmaFixture<1>, 12>()), 1);
+	EXPECT_EQ((testChunkSize<TimDmaFixture<1>, 48>()), 1);
+	EXPECT_EQ((testChunkSize<TimDmaFixture<1>, 192>()), 1);
+	EXPECT_EQ((testChunkSize<TimDmaFixture<1>, 768>()), 1);
+}
+
+TEST(cocoTest, LedStrip_TIM_DMA_Clocks) {
+	// timer clocks of the supported boards (stm32c031, stm32f334, stm32g431/g474) in kHz and 16MHz where the UART
+	// driver is too slow as it needs at least 8 clock cycles per UART bit
+	for (int clock : {16000, 48000, 72000, 170000}) {
+		sim::PwmSimulator sim(clock * 1000);
+		Loop_Queue loop;
+		LedStrip_TIM_DMA_sim<1> ledStrip(loop, sim, clock);
+		LedStrip_TIM_DMA::Buffer<16 * 3> buffer(ledStrip);
+
+		auto data = generateData(16 * 3);
+		std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+		buffer.startWrite(data.size());
+		EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.DMA_IRQHandler();}));
+
+		// check against the timing specification of the LEDs
+		auto result = LedDecoder::decode(sim.waveforms[0], timings::WS2812B);
+		ASSERT_EQ(result.frames.size(), 1);
+		EXPECT_EQ(result.frames[0].data, data);
+		EXPECT_EQ(result.errorCount, 0) << "clock " << clock << "kHz";
+		EXPECT_GE(result.reset.min, RESET_TIME);
+	}
+}
+
+
+// LedStrip_Parallel_TIM_DMA
+
+TEST(cocoTest, LedStrip_Parallel_TIM_DMA) {
+	for (int firstPin : {0, 8}) {
+		sim::ParallelSimulator sim(170000000);
+		Loop_Queue loop;
+		LedStrip_Parallel_TIM_DMA_sim ledStrip(loop, sim, firstPin);
+		LedStrip_Parallel_TIM_DMA::Buffer<8 * 300 * 3> buffer(ledStrip);
+
+		EXPECT_NEAR(sim.slotTime().count(), 1125.0 / 3, 1e9 / 170000000);
+
+		// lengths per strip that fill the LED buffer partially, exactly and multiple times
+		for (int size : {3, 16, 100, 300 * 3}) {
+			auto data = generateData(8 * size);
+			std::copy(data.begin(), data.end(), buffer.pointer<uint8_t>());
+			for (auto &waveform : sim.waveforms)
+				waveform.clear();
+
+			buffer.startWrite(data.size());
+			EXPECT_TRUE(sim.run([&ledStrip] {ledStrip.DMA_IRQHandler();}));
+			EXPECT_EQ(loop.process(), 1);
+
+			// one interrupt per chunk and one for the reset time
+			EXPECT_EQ(sim.dmaIrq.count, (size + 15) / 16 + 1);
+			sim.dmaIrq.count = 0;
+
+			for (int strip = 0; strip < 16; ++strip) {
+				auto result = LedDecoder::decode(sim.waveforms[strip], timings::WS2812B);
+				if (strip < firstPin || strip >= firstPin + 8) {
+					// other pins of the port stay low
+					EXPECT_EQ(result.frames.size(), 0);
+					continue;
+				}
+				ASSERT_EQ(result.frames.size(), 1);
+				auto begin = data.begin() + (strip - firstPin) * size;
+				EXPECT_EQ(result.frames[0].data, std::vector<uint8_t>(begin, begin + size)) << "strip " << strip;
+				EXPECT_GE(result.frames[0].resetTime, RESET_TIME);
+				EXPECT_EQ(result.errorCount, 0);
+			}
+		}
+	}
+}
+
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	int success = RUN_ALL_TESTS();
+	return success;
+}
@@ -1,4 +1,6 @@
 //#include <coco/debug.hpp>
+#include <coco/FrameScheduler.hpp>
+#include <coco/MultiBufferStrip.hpp>
 #include <LedStripTest.hpp>
 
 
@@ -35,41 +37,15 @@ struct SingleBufferStrip {
 	}
 };
 
-struct DoubleBufferStrip {
-	// number of LEDs
-	int count;
-
-	// double buffer
-	Buffer *buffers[2];
-	Buffer *buffer;
-
-	DoubleBufferStrip(Buffer &buffer1, Buffer &buffer2) : buffers{&buffer1, &buffer2} {
-		this->count = std::min(buffer1.capacity(), buffer2.capacity()) / sizeof(Color);
-		this->buffer = &buffer1;
-	}
-
-	int size() {return this->count;}
-
-	// get array of colors, only valid until show() is called
-	Array<Color> array() {
-		return {this->buffer->pointer<Color>(), this->count};
-	}
-
-	[[nodiscard]] Awaitable<> show() {
-		// start writeing buffer
-		this->buffer->startWrite(this->count * sizeof(Color));
-
-		// toggle buffer
-		this->buffer = this->buffer == this->buffers[0] ? this->buffers[1] : this->buffers[0];
-
-		// wait until other buffer is finished
-		return this->buffer->untilReadyOrDisabled();
-	}
-};
-
 template <typename S>
 Coroutine effect(Loop &loop, S &strip) {
+	// 60 frames per second
+	FrameScheduler scheduler(loop, 16667us);
 	while (true) {
+		// wait for next frame slot
+		co_await scheduler.untilFrame();
+		scheduler.beginFrame();
+
 		// get time in milliseconds
 		auto time = int((loop.now() - Loop::Time(0)) / 1ms);
 		int rOffset = time / 32;
@@ -91,14 +67,16 @@ Coroutine effect(Loop &loop, S &strip) {
 			int bx = i + bOffset;
 			color.b = (bx & 256) ? 255 - bx : bx;
 		}
-		co_await strip.show();
+		auto shown = strip.show();
+		scheduler.endFrame();
+		co_await shown;
 	}
 }
 
 
 int main() {
 	//SingleBufferStrip strip(drivers.buffer);
-	DoubleBufferStrip strip(drivers.buffer1, drivers.buffer2);
+	MultiBufferStrip<Color, 3> strip(drivers.buffer1, drivers.buffer2, drivers.buffer3);
 	effect(drivers.loop, strip);
 
 	drivers.loop.run();
@@ -1,5 +1,5 @@
-// generated by generateI2S()
-const uint32_t bitTable[256] = {
+// reference table, formerly generated by generateI2S() of the generator tool
+constexpr uint32_t bitTable_I2S[256] = {
 	9586980, 9586982, 9586996, 9586998, 9587108, 9587110, 9587124, 9587126, 9588004, 9588006, 9588020, 9588022, 9588132, 9588134, 9588148, 9588150, 
 	9595172, 9595174, 9595188, 9595190, 9595300, 9595302, 9595316, 9595318, 9596196, 9596198, 9596212, 9596214, 9596324, 9596326, 9596340, 9596342, 
 	9652516, 9652518, 9652532, 9652534, 9652644, 9652646, 9652660, 9652662, 9653540, 9653542, 9653556, 9653558, 9653668, 9653670, 9653684, 9653686, 
@@ -1,5 +1,5 @@
-// generated by generateUART()
-const uint16_t bitTable[64] = {
+// reference table, formerly generated by generateUART() of the generator tool
+constexpr uint16_t bitTable_UART[64] = {
 	9252, 25636, 11300, 27684, 9508, 25892, 11556, 27940, 9316, 25700, 11364, 27748, 9572, 25956, 11620, 28004, 
 	9260, 25644, 11308, 27692, 9516, 25900, 11564, 27948, 9324, 25708, 11372, 27756, 9580, 25964, 11628, 28012, 
 	9253, 25637, 11301, 27685, 9509, 25893, 11557, 27941, 9317, 25701, 11365, 27749, 9573, 25957, 11621, 28005, 
@@ -13,6 +13,7 @@ struct Drivers {
 	LedStrip_emu ledStrip{loop};
 	LedStrip_emu::Buffer buffer1{LEDSTRIP_LENGTH, ledStrip};
 	LedStrip_emu::Buffer buffer2{LEDSTRIP_LENGTH, ledStrip};
+	LedStrip_emu::Buffer buffer3{LEDSTRIP_LENGTH, ledStrip};
 };
 
 Drivers drivers;
@@ -0,0 +1,1218 @@
+#include <gtest/gtest.h>
+#include <coco/FrameCodec.hpp>
+#include <coco/FrameScheduler.hpp>
+#include <coco/FrameStatistics.hpp>
+#include <coco/LedCapture.hpp>
+#include <coco/LedDecoder.hpp>
+#include <coco/LedDither.hpp>
+#include <coco/LedEncoder.hpp>
+#include <coco/LedPlayer.hpp>
+#include <coco/LedTransform.hpp>
+#include <coco/MultiBufferStrip.hpp>
+#include <coco/PixelFormat.hpp>
+#include <coco/platform/LedStrip_cout.hpp>
+#ifndef _WIN32
+#include <coco/platform/LedFileWriter.hpp>
+#include <coco/platform/LedRecorder.hpp>
+#include <coco/platform/LedStrip_file.hpp>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <thread>
+#include <vector>
+
+
+using namespace coco;
+
+// literal tables of the former generator tool
+namespace reference {
+#include "bitTable_I2S.hpp"
+#include "bitTable_UART.hpp"
+}
+
+// helpers
+
+// generate test data
+std::vector<uint8_t> generateData(int size) {
+	std::vector<uint8_t> data(size);
+	uint32_t x = 12345;
+	for (int i = 0; i < size; ++i) {
+		x = x * 1103515245 + 12345;
+		data[i] = x >> 16;
+	}
+	return data;
+}
+
+// append LED bit symbols (MSB first) of the given bytes to a line level sequence
+void appendSymbols(std::vector<bool> &line, std::span<const uint8_t> data, int zero, int one, int bitsPerSymbol) {
+	for (uint8_t byte : data) {
+		for (int i = 7; i >= 0; --i) {
+			int symbol = (byte >> i) & 1 ? one : zero;
+			for (int j = bitsPerSymbol - 1; j >= 0; --j)
+				line.push_back((symbol >> j) & 1);
+		}
+	}
+}
+
+// append bits of words (MSB first) to a line level sequence
+template <typename T>
+void appendBits(std::vector<bool> &line, std::span<const T> words, int bitsPerWord) {
+	for (T word : words) {
+		for (int j = bitsPerWord - 1; j >= 0; --j)
+			line.push_back((word >> j) & 1);
+	}
+}
+
+// append 7N1 UART frames with inverted data and output to a line level sequence
+void appendUartFrames(std::vector<bool> &line, std::span<const uint8_t> frames) {
+	for (uint8_t frame : frames) {
+		// inverted start bit
+		line.push_back(true);
+
+		// data bits, LSB first (inverted twice)
+		for (int j = 0; j < 7; ++j)
+			line.push_back((frame >> j) & 1);
+
+		// inverted stop bit
+		line.push_back(false);
+	}
+}
+
+
+// LedBitTable
+
+TEST(cocoTest, LedBitTable) {
+	// compare against the literal tables
+	constexpr auto i2s = makeBitTable<uint32_t, 8, symbols::WS2812_3>();
+	EXPECT_TRUE(std::equal(i2s.begin(), i2s.end(), std::begin(reference::bitTable_I2S), std::end(reference::bitTable_I2S)));
+	constexpr auto uart = makeUartBitTable<uint16_t, 6, 7, symbols::WS2812_3>();
+	EXPECT_TRUE(std::equal(uart.begin(), uart.end(), std::begin(reference::bitTable_UART), std::end(reference::bitTable_UART)));
+
+	// tables are generated at compile time
+	static_assert(makeBitTable<uint8_t, 2, symbols::SPI_4>()[1] == 0b10001110);
+	static_assert(makeBitTable<uint16_t, 4, symbols::SK6812_4>()[0b0101] == 0b1000110010001100);
+
+	// other symbol patterns, e.g. SK6812 with 4 bits per LED bit
+	constexpr auto sk6812 = makeBitTable<uint32_t, 8, symbols::SK6812_4>();
+	for (int j = 0; j < 256; ++j) {
+		uint8_t data = j;
+		std::vector<bool> expected;
+		appendSymbols(expected, std::span(&data, 1), 0b1000, 0b1100, 4);
+		std::vector<bool> line;
+		appendBits<uint32_t>(line, std::span(&sk6812[j], 1), 32);
+		EXPECT_EQ(line, expected);
+	}
+}
+
+
+// LedEncoder
+
+TEST(cocoTest, LedEncoder_I2S) {
+	auto data = generateData(300 * 3);
+	std::vector<uint32_t> words(data.size() + 1);
+
+	int count = LedEncoder_I2S::encode(data, words);
+	EXPECT_EQ(count, data.size());
+	EXPECT_EQ(LedEncoder_I2S::wordCount(count), data.size());
+
+	std::vector<bool> expected;
+	appendSymbols(expected, data, 0b100, 0b110, 3);
+	std::vector<bool> line;
+	appendBits<uint32_t>(line, std::span(words).first(count), 24);
+	EXPECT_EQ(line, expected);
+
+	// destination smaller than source
+	count = LedEncoder_I2S::encode(data, std::span(words).first(10));
+	EXPECT_EQ(count, 10);
+}
+
+TEST(cocoTest, LedEncoder_I2S_SIMD) {
+	// all byte values and lengths that are not a multiple of the vector size
+	std::vector<uint8_t> data(256 + 21);
+	for (int i = 0; i < int(data.size()); ++i)
+		data[i] = i * 7;
+	for (int size : {0, 1, 15, 16, 17, 31, 256 + 21}) {
+		std::vector<uint32_t> words(size);
+		std::vector<uint32_t> expected(size);
+		EXPECT_EQ(LedEncoder_I2S::encode(std::span(data).first(size), words), size);
+		EXPECT_EQ(LedEncoder_I2S::encodeTable(std::span(data).first(size), expected), size);
+		EXPECT_EQ(words, expected);
+	}
+}
+
+TEST(cocoTest, LedEncoder_UART) {
+	for (int size : {300 * 3, 3, 4, 5}) {
+		auto data = generateData(size);
+		std::vector<uint32_t> words(LedEncoder_UART::wordCount(size));
+
+		int count = LedEncoder_UART::encode(data, words);
+		EXPECT_EQ(count, size);
+
+		// incomplete last block gets padded with zeros
+		data.resize(count + (LedEncoder_UART::BLOCK_BYTES - count % LedEncoder_UART::BLOCK_BYTES) % LedEncoder_UART::BLOCK_BYTES);
+		std::vector<bool> expected;
+		appendSymbols(expected, data, 0b100, 0b110, 3);
+
+		// UART sends the bytes in memory order (little endian)
+		std::vector<bool> line;
+		appendUartFrames(line, std::span(reinterpret_cast<const uint8_t *>(words.data()), words.size() * 4));
+		EXPECT_EQ(line, expected);
+	}
+
+	// only the frames that contain data need to be sent, e.g. 301 RGBW LEDs
+	for (int size : {300 * 3, 301 * 4, 1, 2, 3}) {
+		auto data = generateData(size);
+		std::vector<uint32_t> words(LedEncoder_UART::wordCount(size));
+		LedEncoder_UART::encode(data, words);
+		int frameCount = LedEncoder_UART::frameCount(size);
+		EXPECT_LE(frameCount, words.size() * 4);
+
+		std::vector<bool> expected;
+		appendSymbols(expected, data, 0b100, 0b110, 3);
+		std::vector<bool> line;
+		appendUartFrames(line, std::span(reinterpret_cast<const uint8_t *>(words.data()), frameCount));
+		EXPECT_GE(line.size(), expected.size());
+		EXPECT_LT(line.size(), expected.size() + 9);
+		line.resize(expected.size());
+		EXPECT_EQ(line, expected);
+	}
+
+	// destination smaller than source: only complete blocks
+	auto data = generateData(30);
+	uint32_t words[5];
+	EXPECT_EQ(LedEncoder_UART::encode(data, words), 6);
+}
+
+TEST(cocoTest, LedEncoder_SPI) {
+	auto data = generateData(300 * 3);
+	for (int size : {1, 2, 5, 13, 300 * 3}) {
+		auto src = std::span(data).first(size);
+		std::vector<uint8_t> bytes(LedEncoder_SPI<3>::wordCount(size));
+		int count = LedEncoder_SPI<3>::encode(src, bytes);
+		EXPECT_EQ(count, size);
+
+		std::vector<bool> expected;
+		appendSymbols(expected, src, 0b100, 0b110, 3);
+		std::vector<bool> line;
+		appendBits<uint8_t>(line, bytes, 8);
+		EXPECT_EQ(line, expected);
+	}
+	{
+		std::vector<uint8_t> bytes(LedEncoder_SPI<4>::wordCount(data.size()));
+		int count = LedEncoder_SPI<4>::encode(data, bytes);
+		EXPECT_EQ(count, data.size());
+
+		std::vector<bool> expected;
+		appendSymbols(expected, data, 0b1000, 0b1110, 4);
+		std::vector<bool> line;
+		appendBits<uint8_t>(line, bytes, 8);
+		EXPECT_EQ(line, expected);
+	}
+	{
+		std::vector<uint8_t> bytes(LedEncoder_SPI<8>::wordCount(data.size()));
+		int count = LedEncoder_SPI<8>::encode(data, bytes);
+		EXPECT_EQ(count, data.size());
+
+		std::vector<bool> expected;
+		appendSymbols(expected, data, 0b11000000, 0b11111000, 8);
+		std::vector<bool> line;
+		appendBits<uint8_t>(line, bytes, 8);
+		EXPECT_EQ(line, expected);
+	}
+}
+
+template <int N>
+void testEncoderParallel() {
+	using Encoder = LedEncoder_Parallel<N>;
+	using Word = typename Encoder::Word;
+	int stride = 300 * 3 + 7;
+	auto data = generateData(N * stride);
+	for (int size : {1, 2, 5, 13, 300 * 3}) {
+		std::vector<Word> words(Encoder::wordCount(size));
+		int count = Encoder::encode(data.data(), stride, size, words);
+		EXPECT_EQ(count, size);
+
+		// each strip gets the [1 DATA 0] symbols of its data
+		for (int strip = 0; strip < N; ++strip) {
+			auto src = std::span(data).subspan(strip * stride, size);
+			std::vector<bool> expected;
+			appendSymbols(expected, src, 0b100, 0b110, 3);
+			std::vector<bool> line;
+			for (Word word : words)
+				line.push_back((word >> strip) & 1);
+			EXPECT_EQ(line, expected) << "strip " << strip;
+		}
+	}
+
+	// destination too small
+	Word words[50];
+	EXPECT_EQ(Encoder::encode(data.data(), stride, 5, words), 2);
+}
+
+TEST(cocoTest, LedEncoder_Parallel) {
+	// transpose against bit by bit reference
+	auto data = generateData(32);
+	uint64_t x;
+	std::memcpy(&x, data.data(), 8);
+	uint64_t t = transpose8x8(x);
+	uint16_t rows[16];
+	uint16_t bits[16];
+	std::memcpy(rows, data.data(), 32);
+	transpose16x16(rows, bits);
+	for (int i = 0; i < 8; ++i) {
+		for (int j = 0; j < 8; ++j)
+			EXPECT_EQ((t >> (i * 8 + j)) & 1, (x >> (j * 8 + i)) & 1);
+	}
+	for (int i = 0; i < 16; ++i) {
+		for (int j = 0; j < 16; ++j)
+			EXPECT_EQ((bits[i] >> j) & 1, (rows[j] >> i) & 1);
+	}
+	static_assert(transpose8x8(0x8000000000000001ULL) == 0x8000000000000001ULL);
+	static_assert(transpose8x8(0xFF) == 0x0101010101010101ULL);
+
+	testEncoderParallel<8>();
+	testEncoderParallel<16>();
+}
+
+TEST(cocoTest, LedEncoder_PWM) {
+	// compare values for 170MHz and T0H = 400ns, T1H = 800ns
+	const uint8_t zero = 68;
+	const uint8_t one = 136;
+	int stride = 300 * 3 + 7;
+	auto data = generateData(6 * stride);
+	for (int stripCount : {1, 2, 3, 4, 6}) {
+		for (int size : {1, 2, 5, 13, 300 * 3}) {
+			std::vector<uint8_t> words(LedEncoder_PWM<>::wordCount(size, stripCount));
+			int count = LedEncoder_PWM<>::encode(data.data(), stride, stripCount, size, zero, one, words);
+			EXPECT_EQ(count, size);
+
+			// each strip gets one compare value per LED bit, MSB first, interleaved with the other strips
+			for (int strip = 0; strip < stripCount; ++strip) {
+				std::vector<uint8_t> expected;
+				for (int i = 0; i < size; ++i) {
+					for (int j = 7; j >= 0; --j)
+						expected.push_back(((data[strip * stride + i] >> j) & 1) ? one : zero);
+				}
+				std::vector<uint8_t> line;
+				for (size_t k = strip; k < words.size(); k += stripCount)
+					line.push_back(words[k]);
+				EXPECT_EQ(line, expected) << "strips " << stripCount << " strip " << strip;
+			}
+		}
+	}
+
+	// destination too small
+	uint8_t words[50];
+	EXPECT_EQ(LedEncoder_PWM<>::encode(data.data(), stride, 3, 5, zero, one, words), 2);
+}
+
+TEST(cocoTest, LedEncoder_PWM_16) {
+	// sequence values of the nrf52 PWM at 16MHz, T0H = 375ns, T1H = 750ns, bit 15 is the polarity
+	const uint16_t zero = 6 | 0x8000;
+	const uint16_t one = 12 | 0x8000;
+	int stride = 300 * 3 + 7;
+	auto data = generateData(4 * stride);
+
+	// the load modes of the nrf52 PWM read 1, 2 or 4 values per step
+	for (auto [stripCount, stepSize] : {std::pair{1, 1}, {2, 2}, {3, 4}, {4, 4}}) {
+		for (int size : {1, 5, 300 * 3}) {
+			std::vector<uint16_t> words(LedEncoder_PWM<uint16_t>::wordCount(size, stepSize));
+			int count = LedEncoder_PWM<uint16_t>::encode(data.data(), stride, stripCount, size, zero, one, words,
+				stepSize);
+			EXPECT_EQ(count, size);
+
+			for (int strip = 0; strip < stepSize; ++strip) {
+				// missing strips get zero bits
+				std::vector<uint16_t> expected;
+				for (int i = 0; i < size; ++i) {
+					for (int j = 7; j >= 0; --j) {
+						bool bit = strip < stripCount && ((data[strip * stride + i] >> j) & 1);
+						expected.push_back(bit ? one : zero);
+					}
+				}
+				std::vector<uint16_t> line;
+				for (size_t k = strip; k < words.size(); k += stepSize)
+					line.push_back(words[k]);
+				EXPECT_EQ(line, expected) << "strips " << stripCount << " strip " << strip;
+			}
+		}
+	}
+}
+
+
+
+// LedTransform
+
+// apply a transform to whole pixels
+std::vector<uint8_t> applyTransform(const LedTransform &transform, std::span<const uint8_t> data) {
+	std::vector<uint8_t> result(data.size());
+	int n = transform.channelCount;
+	for (size_t i = 0; i < data.size(); ++i)
+		result[i] = transform(data.data() + i / n * n, i % n);
+	return result;
+}
+
+TEST(cocoTest, LedTransform) {
+	// identity
+	LedTransform identity;
+	for (int i = 0; i < 256; ++i)
+		EXPECT_EQ(identity.table[2][i], i);
+
+	// RGB to GRB with half brightness, gamma and white balance
+	LedTransform grb;
+	grb.setOrder({1, 0, 2});
+	grb.set(128, 2.2f, {255, 200, 100, 255});
+	uint8_t pixel[] = {255, 255, 255};
+	EXPECT_EQ(grb(pixel, 0), 100); // green
+	EXPECT_EQ(grb(pixel, 1), 128); // red
+	EXPECT_EQ(grb(pixel, 2), 50); // blue
+	uint8_t rgb[] = {10, 20, 30};
+	EXPECT_EQ(identity(rgb, 0), 10);
+	EXPECT_EQ(grb(rgb, 0), grb.table[0][20]);
+	EXPECT_EQ(grb.table[1][128], int(std::pow(128 / 255.0f, 2.2f) * 128 + 0.5f));
+
+	// extend to whole pixels
+	int begin = 4;
+	int end = 7;
+	grb.extend(begin, end);
+	EXPECT_EQ(begin, 3);
+	EXPECT_EQ(end, 9);
+
+	// RGBW
+	LedTransform wrgb(4);
+	wrgb.setOrder({3, 0, 1, 2});
+	wrgb.set(255, 1.0f);
+
+	// fused encoders against transform followed by encoder, starting at every channel of the pixel
+	auto data = generateData(300 * 4);
+	for (auto *transform : {&identity, &grb, &wrgb}) {
+		auto transformed = applyTransform(*transform, data);
+		for (int offset = 0; offset < 4; ++offset) {
+			for (int size : {1, 2, 5, 13, 300 * 3}) {
+				auto src = std::span(data).subspan(offset, size);
+				auto expected = std::span<const uint8_t>(transformed).subspan(offset, size);
+				int channel = offset % transform->channelCount;
+
+				std::vector<uint32_t> words(LedEncoder_I2S::wordCount(size));
+				std::vector<uint32_t> expectedWords(words.size());
+				EXPECT_EQ(LedEncoder_I2S::encode(src, words, *transform, channel), size);
+				LedEncoder_I2S::encode(expected, expectedWords);
+				EXPECT_EQ(words, expectedWords);
+
+				words.assign(LedEncoder_UART::wordCount(size), 0);
+				expectedWords.assign(words.size(), 0);
+				EXPECT_EQ(LedEncoder_UART::encode(src, words, *transform, channel), size);
+				LedEncoder_UART::encode(expected, expectedWords);
+				EXPECT_EQ(words, expectedWords);
+			}
+		}
+	}
+}
+
+
+// LedDither
+
+TEST(cocoTest, LedDither) {
+	// full range without flicker
+	for (int r = 0; r < 256; ++r) {
+		uint8_t residual = r;
+		EXPECT_EQ(LedDither::next(0, residual), 0);
+		EXPECT_EQ(residual, r);
+		EXPECT_EQ(LedDither::next(65535, residual), 255);
+		EXPECT_EQ(residual, r);
+	}
+
+	// average over 256 frames equals the 16 bit value
+	for (int value : {1, 100, 255, 256, 257, 1000, 12345, 65534}) {
+		uint8_t residual = 77;
+		int sum = 0;
+		for (int i = 0; i < 256; ++i)
+			sum += LedDither::next(value, residual);
+		EXPECT_EQ(sum, value - (value >> 8));
+		EXPECT_EQ(residual, 77);
+	}
+
+	// channels start with different accumulators
+	LedDither_Buffer<900> dither;
+	EXPECT_NE(dither.residual[0], dither.residual[1]);
+
+	// encoders against dithering followed by encoder, for some frames, 16 bit channels are MSB first
+	auto bytes = generateData(300 * 3 * 2);
+	std::vector<uint16_t> data(300 * 3);
+	for (int i = 0; i < 300 * 3; ++i)
+		data[i] = (bytes[i * 2] << 8) | bytes[i * 2 + 1];
+	LedDither_Buffer<900> dither2;
+	for (int frame = 0; frame < 3; ++frame) {
+		for (int offset : {0, 1, 2}) {
+			int size = 300 * 3 - offset - 2;
+			LedDither_Buffer<900> expectedDither;
+			std::copy(dither.data, dither.data + 900, expectedDither.data);
+			std::vector<uint8_t> expected(size);
+			for (int i = 0; i < size; ++i)
+				expected[i] = LedDither::next(data[offset + i], expectedDither.residual[offset + i]);
+
+			std::copy(dither.data, dither.data + 900, dither2.data);
+			std::vector<uint32_t> words(LedEncoder_I2S::wordCount(size));
+			std::vector<uint32_t> expectedWords(words.size());
+			EXPECT_EQ(LedEncoder_I2S::encode(dither2.reader(bytes.data(), offset), size, words), size);
+			LedEncoder_I2S::encode(expected, expectedWords);
+			EXPECT_EQ(words, expectedWords);
+			EXPECT_TRUE(std::equal(dither2.data, dither2.data + 900, expectedDither.data));
+
+			std::copy(dither.data, dither.data + 900, dither2.data);
+			words.assign(LedEncoder_UART::wordCount(size), 0);
+			expectedWords.assign(words.size(), 0);
+			EXPECT_EQ(LedEncoder_UART::encode(dither2.reader(bytes.data(), offset), size, words), size);
+			LedEncoder_UART::encode(expected, expectedWords);
+			EXPECT_EQ(words, expectedWords);
+			EXPECT_TRUE(std::equal(dither2.data, dither2.data + 900, expectedDither.data));
+		}
+
+		// next frame
+		for (int i = 0; i < 900; ++i)
+			LedDither::next(data[i], dither.residual[i]);
+	}
+}
+
+
+// LedDecoder
+
+TEST(cocoTest, LedDecoder) {
+	// round trip of random data through the encoders and the decoder
+	uint32_t x = 1;
+	for (int iteration = 0; iteration < 200; ++iteration) {
+		x = x * 1103515245 + 12345;
+		int size = (x >> 16) % 301 + 1;
+		auto data = generateData(size + iteration);
+		data.erase(data.begin(), data.begin() + iteration);
+
+		// I2S with T = 1125ns
+		{
+			std::vector<uint32_t> words(LedEncoder_I2S::wordCount(size));
+			LedEncoder_I2S::encode(data, words);
+			LedWaveform waveform;
+			waveform.appendI2S(words, 375);
+			waveform.append(false, 80000);
+			auto result = LedDecoder::decode(waveform, timings::WS2812B);
+			ASSERT_EQ(result.frames.size(), 1);
+			EXPECT_EQ(result.frames[0].data, data);
+			EXPECT_EQ(result.errorCount, 0);
+		}
+
+		// UART with T = 1125ns, the last frame may contain padding
+		{
+			std::vector<uint32_t> words(LedEncoder_UART::wordCount(size));
+			LedEncoder_UART::encode(data, words);
+			LedWaveform waveform;
+			waveform.appendUART(std::span(reinterpret_cast<const uint8_t *>(words.data()),
+				LedEncoder_UART::frameCount(size)), 7, 375);
+			waveform.append(false, 80000);
+			auto result = LedDecoder::decode(waveform, timings::WS2812B);
+			ASSERT_EQ(result.frames.size(), 1);
+			EXPECT_EQ(result.frames[0].data, data);
+			EXPECT_EQ(result.errorCount, 0);
+		}
+
+		// SPI at 3.2MHz and 6.4MHz
+		{
+			std::vector<uint8_t> bytes(LedEncoder_SPI<4>::wordCount(size));
+			LedEncoder_SPI<4>::encode(data, bytes);
+			LedWaveform waveform;
+			waveform.appendSPI(bytes, 312.5);
+			waveform.append(false, 80000);
+			auto result = LedDecoder::decode(waveform, timings::WS2812B);
+			ASSERT_EQ(result.frames.size(), 1);
+			EXPECT_EQ(result.frames[0].data, data);
+			EXPECT_EQ(result.errorCount, 0);
+		}
+		{
+			std::vector<uint8_t> bytes(LedEncoder_SPI<8>::wordCount(size));
+			LedEncoder_SPI<8>::encode(data, bytes);
+			LedWaveform waveform;
+			waveform.appendSPI(bytes, 156.25);
+			waveform.append(false, 80000);
+			auto result = LedDecoder::decode(waveform, timings::WS2812B);
+			ASSERT_EQ(result.frames.size(), 1);
+			EXPECT_EQ(result.frames[0].data, data);
+			EXPECT_EQ(result.errorCount, 0);
+		}
+
+		// parallel on GPIO with T = 1125ns, the data is the second of 8 strips
+		{
+			std::vector<uint8_t> strips(8 * size);
+			std::copy(data.begin(), data.end(), strips.begin() + size);
+			std::vector<uint8_t> words(LedEncoder_Parallel<8>::wordCount(size));
+			LedEncoder_Parallel<8>::encode(strips.data(), size, size, words);
+			LedWaveform waveform;
+			waveform.appendParallel<uint8_t>(words, 1, 375);
+			waveform.append(false, 80000);
+			auto result = LedDecoder::decode(waveform, timings::WS2812B);
+			ASSERT_EQ(result.frames.size(), 1);
+			EXPECT_EQ(result.frames[0].data, data);
+			EXPECT_EQ(result.errorCount, 0);
+		}
+	}
+}
+
+TEST(cocoTest, LedDecoder_Timing) {
+	uint8_t data = 0b01000000;
+
+	// T = 1125ns meets WS2812B, WS2813 except for the reset time and SK6812 except for the low time of a one bit
+	LedWaveform waveform;
+	uint32_t word;
+	LedEncoder_I2S::encode(std::span(&data, 1), std::span(&word, 1));
+	waveform.appendI2S(std::span(&word, 1), 375);
+	waveform.append(false, 80000);
+	auto result = LedDecoder::decode(waveform, timings::WS2812B);
+	EXPECT_EQ(result.errorCount, 0);
+	EXPECT_EQ(result.t0h.min, 375);
+	EXPECT_EQ(result.t1h.max, 750);
+	EXPECT_EQ(result.t0l.max, 750);
+	EXPECT_EQ(result.t1l.min, 375);
+	EXPECT_EQ(result.reset.min, 80000 + 750);
+	EXPECT_EQ(LedDecoder::decode(waveform, timings::WS2813).errorCount, 1);
+	EXPECT_EQ(LedDecoder::decode(waveform, timings::SK6812).errorCount, 1);
+
+	// missing reset at the end
+	waveform.clear();
+	waveform.appendI2S(std::span(&word, 1), 375);
+	result = LedDecoder::decode(waveform, timings::WS2812B);
+	ASSERT_EQ(result.frames.size(), 1);
+	EXPECT_EQ(result.frames[0].data[0], data);
+	EXPECT_EQ(result.errorCount, 1);
+}
+
+
+// PixelFormat
+
+TEST(cocoTest, PixelFormat) {
+	EXPECT_EQ(pixelFormats::RGB.size(), 3);
+	EXPECT_EQ(pixelFormats::RGBW.size(), 4);
+	EXPECT_EQ(pixelFormats::RGB16.size(), 6);
+	EXPECT_EQ(pixelFormats::RGBW16.size(), 8);
+
+	uint8_t rgb[3];
+	const uint8_t rgbPixel[] = {10, 20, 30};
+	pixelFormats::RGB.toRgb(rgbPixel, rgb);
+	EXPECT_EQ(rgb[0], 10); EXPECT_EQ(rgb[1], 20); EXPECT_EQ(rgb[2], 30);
+
+	// white gets added and saturates
+	const uint8_t rgbwPixel[] = {10, 20, 250, 100};
+	pixelFormats::RGBW.toRgb(rgbwPixel, rgb);
+	EXPECT_EQ(rgb[0], 110); EXPECT_EQ(rgb[1], 120); EXPECT_EQ(rgb[2], 255);
+
+	// high byte of 16 bit channels (MSB first)
+	const uint8_t rgb16Pixel[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+	pixelFormats::RGB16.toRgb(rgb16Pixel, rgb);
+	EXPECT_EQ(rgb[0], 0x12); EXPECT_EQ(rgb[1], 0x56); EXPECT_EQ(rgb[2], 0x9a);
+	const uint8_t rgbw16Pixel[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0x01, 0xff};
+	pixelFormats::RGBW16.toRgb(rgbw16Pixel, rgb);
+	EXPECT_EQ(rgb[0], 0x13); EXPECT_EQ(rgb[1], 0x57); EXPECT_EQ(rgb[2], 0x9b);
+}
+
+TEST(cocoTest, PixelFormat_Dither) {
+	// the same 16 bit frame shows the same colors on the emulator (toRgb) and on the LED strip (dithering), high and
+	// low bytes differ so that a different byte order would show up
+	std::vector<uint8_t> frame(100 * 6);
+	for (int i = 0; i < 100 * 3; ++i) {
+		frame[i * 2] = i * 37;
+		frame[i * 2 + 1] = 255 - i * 37;
+	}
+	LedDither_Buffer<100 * 3> dither;
+	for (int repeat = 0; repeat < 3; ++repeat) {
+		auto reader = dither.reader(frame.data(), 0);
+		for (int i = 0; i < 100; ++i) {
+			uint8_t rgb[3];
+			pixelFormats::RGB16.toRgb(frame.data() + i * 6, rgb);
+			for (int j = 0; j < 3; ++j)
+				EXPECT_NEAR(reader.next(), rgb[j], 1) << "channel " << i * 3 + j;
+		}
+	}
+}
+
+
+// FrameStatistics
+
+TEST(cocoTest, FrameStatistics) {
+	FrameStatistics statistics;
+	EXPECT_EQ(statistics.average(), 0);
+
+	for (int time : {16000, 17000, 16500, 40000})
+		statistics.add(time);
+	EXPECT_EQ(statistics.count, 4);
+	EXPECT_EQ(statistics.min, 16000);
+	EXPECT_EQ(statistics.max, 40000);
+	EXPECT_EQ(statistics.average(), 22375);
+
+	statistics.reset();
+	statistics.add(-5);
+	EXPECT_EQ(statistics.min, -5);
+	EXPECT_EQ(statistics.max, -5);
+	EXPECT_EQ(statistics.average(), -5);
+}
+
+
+// FrameScheduler
+
+// gives access to the current frame slot
+class TestFrameScheduler : public FrameScheduler {
+public:
+	using FrameScheduler::FrameScheduler;
+
+	// offset of the current frame slot to the given time in microseconds
+	int slotOffset(Loop::Time time) {return (this->slot - time) / 1us;}
+};
+
+// wait on the host until the given time has passed
+void waitUntil(Loop &loop, Loop::Time time) {
+	while ((loop.now() - time) / 1us < 0)
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+TEST(cocoTest, FrameScheduler) {
+	Loop_native loop;
+	TestFrameScheduler scheduler(loop, 10000us);
+
+	// first frame slot is now
+	auto before = loop.now();
+	(void)scheduler.untilFrame();
+	int offset = scheduler.slotOffset(before);
+	EXPECT_GE(offset, 0);
+	EXPECT_LT(offset, 10000);
+	auto first = before;
+	first += Microseconds<>{offset};
+	scheduler.beginFrame();
+	scheduler.endFrame();
+
+	// second frame slot follows after one period
+	(void)scheduler.untilFrame();
+	EXPECT_EQ(scheduler.slotOffset(first), 10000);
+	EXPECT_EQ(scheduler.missed, 0);
+
+	// a frame that begins late does not shift the grid
+	auto late = first;
+	late += 13000us;
+	waitUntil(loop, late);
+	scheduler.beginFrame();
+	scheduler.endFrame();
+	(void)scheduler.untilFrame();
+	EXPECT_EQ(scheduler.slotOffset(first), 20000);
+	EXPECT_EQ(scheduler.missed, 0);
+
+	// rendering that takes longer than two periods misses the slots that have passed entirely
+	auto slow = first;
+	slow += 45000us;
+	waitUntil(loop, slow);
+	(void)scheduler.untilFrame();
+	EXPECT_EQ(scheduler.slotOffset(first) % 10000, 0);
+	EXPECT_GE(scheduler.slotOffset(first), 40000);
+	EXPECT_GE(scheduler.missed, 1);
+	EXPECT_EQ(scheduler.missed, scheduler.slotOffset(first) / 10000 - 3);
+	scheduler.beginFrame();
+
+	// statistics: frame time from the second frame on, jitter of each frame, late frames have positive jitter
+	EXPECT_EQ(scheduler.jitter.count, 3);
+	EXPECT_EQ(scheduler.frameTime.count, 2);
+	EXPECT_EQ(scheduler.renderTime.count, 2);
+	EXPECT_GE(scheduler.jitter.max, 3000);
+	EXPECT_GE(scheduler.frameTime.min, 13000);
+	EXPECT_GE(scheduler.renderTime.min, 0);
+
+	// reset keeps the grid
+	scheduler.resetStatistics();
+	EXPECT_EQ(scheduler.missed, 0);
+	EXPECT_EQ(scheduler.jitter.count, 0);
+	int slot = scheduler.slotOffset(first);
+	(void)scheduler.untilFrame();
+	EXPECT_EQ(scheduler.slotOffset(first) % 10000, 0);
+	EXPECT_GE(scheduler.slotOffset(first), slot + 10000);
+}
+
+
+// FrameCodec
+
+TEST(cocoTest, FrameCodec) {
+	// sequence of frames: key frame, few changes, red channel changed, uniform change, random, unchanged
+	std::vector<std::vector<uint8_t>> frames;
+	auto frame = generateData(300 * 3);
+	frames.push_back(frame);
+	frame[10] ^= 0x55;
+	frame[11] ^= 0x01;
+	frame[500] = 0;
+	frames.push_back(frame);
+	for (int i = 0; i < 300; ++i)
+		frame[i * 3] += 7;
+	frames.push_back(frame);
+	for (int i = 100; i < 200; ++i)
+		frame[i] ^= 0x10;
+	frames.push_back(frame);
+	auto random = generateData(300 * 3 + 7);
+	frame.assign(random.begin() + 7, random.end());
+	frames.push_back(frame);
+	frames.push_back(frame);
+
+	for (int planes : {1, 3}) {
+		std::vector<uint8_t> decoded(frame.size());
+		std::vector<uint8_t> streamed(frame.size());
+		const std::vector<uint8_t> *reference = nullptr;
+		for (auto &f : frames) {
+			std::vector<uint8_t> encoded(FrameCodec::maxSize(f.size()));
+			int size = FrameCodec::encode(reference ? std::span<const uint8_t>(*reference) : std::span<const uint8_t>(),
+				f, encoded.data(), planes);
+			EXPECT_LE(size, FrameCodec::maxSize(f.size()));
+			encoded.resize(size);
+
+			// decode at once
+			EXPECT_TRUE(FrameCodec::decode(encoded, decoded, planes));
+			EXPECT_EQ(decoded, f);
+
+			// decode in chunks of 7 bytes
+			FrameCodec::Decoder decoder(streamed, planes);
+			for (int i = 0; i < size; i += 7)
+				EXPECT_TRUE(decoder.decode(std::span(encoded).subspan(i, std::min(7, size - i))));
+			EXPECT_TRUE(decoder.complete());
+			EXPECT_EQ(streamed, f);
+			reference = &f;
+		}
+	}
+
+	// unchanged frame encodes to nothing, single change is small, changes of the red channel are small using planes
+	std::vector<uint8_t> encoded(FrameCodec::maxSize(frame.size()));
+	EXPECT_EQ(FrameCodec::encode(frames[4], frames[5], encoded.data()), 0);
+	EXPECT_EQ(FrameCodec::encode(frames[0], frames[1], encoded.data()), 1 + 3 + 4 + 2);
+	EXPECT_EQ(FrameCodec::encode(frames[1], frames[2], encoded.data(), 3), 5 * 2);
+
+	// random data does not exceed the maximum size
+	EXPECT_LE(FrameCodec::encode({}, random, encoded.data()), FrameCodec::maxSize(random.size()));
+
+	// encoded data that exceeds the frame
+	std::vector<uint8_t> small(10);
+	const uint8_t invalid[] = {0x05, 0xc2, 0xff};
+	EXPECT_FALSE(FrameCodec::decode(invalid, small));
+}
+
+
+// LedCapture
+
+// capture writer into a vector
+class VectorCapture : public LedCapture::Writer {
+public:
+	VectorCapture(int pixelSize) : LedCapture::Writer(pixelSize) {}
+
+	std::vector<uint8_t> data;
+
+protected:
+	uint8_t *reserve(int size) override {
+		this->data.resize(this->used + size);
+		return this->data.data() + this->used;
+	}
+
+	void commit(int size) override {
+		this->used += size;
+		this->data.resize(this->used);
+	}
+
+	size_t used = 0;
+};
+
+TEST(cocoTest, LedCapture) {
+	// frames where only some pixels change
+	std::vector<std::vector<uint8_t>> frames;
+	auto frame = generateData(300 * 3);
+	frames.push_back(frame);
+	frame[0] ^= 1;
+	frame[5 * 3 + 2] ^= 1;
+	frame[7 * 3] ^= 1;
+	frame[299 * 3 + 1] ^= 1;
+	frames.push_back(frame);
+	frames.push_back(frame);
+	frame.resize(310 * 3, 7);
+	frames.push_back(frame);
+	frame.resize(10 * 3);
+	frames.push_back(frame);
+
+	VectorCapture capture(3);
+	for (int i = 0; i < int(frames.size()); ++i)
+		EXPECT_TRUE(capture.add(frames[i], 1000000 + i * 16667));
+	EXPECT_EQ(capture.frameCount, int(frames.size()));
+
+	// first frame is complete, the unchanged pixels 1 - 4 get included in the span but 8 - 298 not
+	size_t size = sizeof(LedCapture::Header)
+		+ LedCapture::maxFrameSize(300, 3)
+		+ sizeof(LedCapture::Frame) + 2 * sizeof(LedCapture::Span) + 24 + 4
+		+ sizeof(LedCapture::Frame)
+		+ sizeof(LedCapture::Frame) + sizeof(LedCapture::Span) + 32
+		+ sizeof(LedCapture::Frame);
+	EXPECT_EQ(capture.data.size(), size);
+
+	// replay
+	LedCapture::Reader reader(capture.data);
+	EXPECT_TRUE(reader.valid());
+	EXPECT_EQ(reader.pixelSize, 3);
+	std::vector<uint8_t> replay;
+	for (int i = 0; i < int(frames.size()); ++i) {
+		ASSERT_TRUE(reader.next());
+		EXPECT_EQ(reader.time(), i * 16667);
+		replay.resize(reader.length() * reader.pixelSize);
+		reader.apply(replay);
+		EXPECT_EQ(replay, frames[i]);
+	}
+	EXPECT_FALSE(reader.next());
+
+	// compare
+	EXPECT_EQ(LedCapture::compare(capture.data, capture.data), -1);
+	VectorCapture capture2(3);
+	for (int i = 0; i < int(frames.size()); ++i) {
+		auto f = frames[i];
+		if (i >= 2)
+			f[3] += 1;
+		capture2.add(f, i * 20000);
+	}
+	EXPECT_EQ(LedCapture::compare(capture.data, capture2.data), 2);
+	EXPECT_EQ(LedCapture::compare(capture.data, capture2.data, 1), -1);
+	size_t firstSize = sizeof(LedCapture::Header) + LedCapture::maxFrameSize(300, 3);
+	EXPECT_EQ(LedCapture::compare(capture.data, std::span(capture2.data).subspan(0, firstSize + 10)), 1);
+
+	// invalid capture has no frames
+	LedCapture::Reader invalid(std::span(capture.data).subspan(4));
+	EXPECT_FALSE(invalid.valid());
+	EXPECT_FALSE(invalid.next());
+}
+
+
+// LedPlayer
+
+// buffer that records the transferred frames, one transfer is in flight until the next starts
+class RecordingBuffer : public BufferImpl {
+public:
+	RecordingBuffer(int size) : BufferImpl(new uint8_t[size], size, deviceState) {}
+	~RecordingBuffer() override {delete [] this->p.data;}
+
+	bool start(Op) override {
+		transfers.emplace_back(this->p.data, this->p.data + this->p.size);
+		if (inFlight != nullptr)
+			inFlight->setReady();
+		setBusy();
+		inFlight = this;
+		return true;
+	}
+	bool cancel() override {return false;}
+
+	static inline RecordingBuffer *inFlight = nullptr;
+	static inline State deviceState = State::READY;
+	static inline std::vector<std::vector<uint8_t>> transfers;
+};
+
+TEST(cocoTest, LedPlayer) {
+	// show of 20 frames of 20 RGB LEDs where some pixels change and a frame gets shorter
+	std::vector<std::vector<uint8_t>> frames;
+	auto frame = generateData(20 * 3);
+	for (int i = 0; i < 20; ++i) {
+		frame[(i * 7 % 20) * 3] += 1;
+		frame[(i * 3 % 20) * 3 + 2] += 1;
+		if (i == 15)
+			frame.resize(12 * 3);
+		frames.push_back(frame);
+	}
+	VectorCapture capture(3);
+	for (int i = 0; i < int(frames.size()); ++i)
+		capture.add(frames[i], i * 10000);
+
+	// play the second half of the LEDs using 3 buffers
+	Loop_native loop;
+	RecordingBuffer buffer1(10 * 3);
+	RecordingBuffer buffer2(10 * 3);
+	RecordingBuffer buffer3(10 * 3);
+	LedPlayer<3> player(loop, LedCapture::Reader(capture.data), 10, buffer1, buffer2, buffer3);
+	for (int round = 0; round < 2; ++round) {
+		RecordingBuffer::transfers.clear();
+		while (player.next()) {
+			(void)player.untilFrame();
+			(void)player.show();
+		}
+		ASSERT_EQ(RecordingBuffer::transfers.size(), frames.size());
+		for (int i = 0; i < int(frames.size()); ++i) {
+			std::vector<uint8_t> expected(frames[i].begin() + 10 * 3, frames[i].end());
+			EXPECT_EQ(RecordingBuffer::transfers[i], expected);
+		}
+		EXPECT_EQ(player.frameTime(), 190000);
+		player.rewind();
+	}
+
+	// raw frames at 50 frames/s
+	std::vector<uint8_t> raw;
+	for (int i = 0; i < 5; ++i)
+		raw.insert(raw.end(), frames[i].begin(), frames[i].end());
+	LedPlayer<2, LedRawReader> rawPlayer(loop, LedRawReader(raw, 3, 20, 20000us), 0, buffer1, buffer2);
+	RecordingBuffer::transfers.clear();
+	while (rawPlayer.next()) {
+		(void)rawPlayer.untilFrame();
+		(void)rawPlayer.show();
+	}
+	ASSERT_EQ(RecordingBuffer::transfers.size(), 5);
+	EXPECT_EQ(RecordingBuffer::transfers[4], std::vector<uint8_t>(frames[4].begin(), frames[4].begin() + 10 * 3));
+	EXPECT_EQ(rawPlayer.frameTime(), 80000);
+}
+
+
+// LedStrip_cout
+
+TEST(cocoTest, LedStrip_cout) {
+	// black, white, dark gray, red
+	const uint8_t data[] = {0, 0, 0, 255, 255, 255, 40, 40, 40, 255, 0, 0};
+	std::string line = "x";
+	LedStrip_cout::render(line, data, 4);
+	EXPECT_EQ(line, "x @!7\n");
+
+	// RGBW with white added to red, green and blue
+	const uint8_t rgbw[] = {0, 0, 0, 255, 0, 0, 0, 0};
+	line.clear();
+	LedStrip_cout::render(line, rgbw, 2, pixelFormats::RGBW);
+	EXPECT_EQ(line, "@ \n");
+
+	// escape sequence only if the color changes
+	line.clear();
+	LedStrip_cout::renderColor(line, data, 4);
+	EXPECT_EQ(line, "\x1b[48;2;0;0;0m \x1b[48;2;255;255;255m \x1b[48;2;40;40;40m \x1b[48;2;255;0;0m \x1b[0m\n");
+	const uint8_t same[] = {1, 2, 3, 1, 2, 3};
+	line.clear();
+	LedStrip_cout::renderColor(line, same, 2);
+	EXPECT_EQ(line, "\x1b[48;2;1;2;3m  \x1b[0m\n");
+}
+
+TEST(cocoTest, MultiBufferStrip_cout) {
+	// LedStrip_cout::Buffer::cancel() aborts any transfer, therefore only the queued frame may get cancelled
+	Loop_native loop;
+	LedStrip_cout ledStrip(loop, pixelFormats::RGB, LedStrip_cout::Mode::NONE);
+	LedStrip_cout::Buffer buffer1(10, ledStrip);
+	LedStrip_cout::Buffer buffer2(10, ledStrip);
+	LedStrip_cout::Buffer buffer3(10, ledStrip);
+	MultiBufferStrip<uint8_t, 3> strip(buffer1, buffer2, buffer3);
+
+	// the first frame is in flight and the second one is queued
+	(void)strip.show();
+	(void)strip.show();
+	EXPECT_EQ(strip.dropped, 0);
+	EXPECT_FALSE(buffer1.ready());
+	EXPECT_FALSE(buffer2.ready());
+
+	// the third frame replaces the queued one, the frame in flight stays
+	(void)strip.show();
+	EXPECT_EQ(strip.dropped, 1);
+	EXPECT_FALSE(buffer1.ready());
+	EXPECT_TRUE(buffer2.ready());
+	EXPECT_FALSE(buffer3.ready());
+}
+
+
+// LedFileWriter
+
+#ifndef _WIN32
+TEST(cocoTest, LedFileWriter) {
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+	int resetBytes = LedFileWriter::calcResetBytes(3, 1250, 80);
+	EXPECT_EQ(resetBytes, 24);
+
+	// write some frames into a pipe
+	auto data = generateData(300 * 3);
+	std::vector<uint8_t> expected;
+	{
+		LedFileWriter writer(fds[1], 3, resetBytes);
+		for (int size : {300 * 3, 10 * 3, 1}) {
+			std::vector<uint8_t> encoded(LedEncoder_SPI<3>::wordCount(size));
+			LedEncoder_SPI<3>::encode(std::span(data).subspan(0, size), encoded);
+			expected.insert(expected.end(), encoded.begin(), encoded.end());
+			expected.insert(expected.end(), resetBytes, 0);
+
+			EXPECT_TRUE(writer.write(std::span(data).subspan(0, size)));
+		}
+		writer.flush();
+		EXPECT_EQ(writer.frameCount, 3);
+		EXPECT_EQ(writer.errorCount, 0);
+	}
+	close(fds[1]);
+
+	// read back
+	std::vector<uint8_t> result(expected.size() + 1);
+	int size = 0;
+	while (true) {
+		int r = read(fds[0], result.data() + size, result.size() - size);
+		if (r <= 0)
+			break;
+		size += r;
+	}
+	close(fds[0]);
+	result.resize(size);
+	EXPECT_EQ(result, expected);
+}
+
+TEST(cocoTest, LedFileWriter_Error) {
+	// writing to a file that is open for reading fails
+	int fd = open("/dev/null", O_RDONLY);
+	ASSERT_GE(fd, 0);
+	{
+		LedFileWriter writer(fd, 3, LedFileWriter::calcResetBytes(3, 1250, 80));
+		auto data = generateData(10 * 3);
+		EXPECT_TRUE(writer.write(data));
+		writer.flush();
+		EXPECT_EQ(writer.frameCount, 0);
+		EXPECT_EQ(writer.errorCount, 1);
+	}
+	close(fd);
+}
+
+TEST(cocoTest, LedFileWriter_Throughput) {
+	int fd = open("/dev/null", O_WRONLY);
+	ASSERT_GE(fd, 0);
+	auto data = generateData(300 * 3);
+
+	// 300 LEDs to /dev/null needs to sustain more than 1000 frames/s
+	const int frameCount = 10000;
+	auto start = std::chrono::steady_clock::now();
+	{
+		LedFileWriter writer(fd, 3, LedFileWriter::calcResetBytes(3, 1250, 80));
+		for (int i = 0; i < frameCount; ++i) {
+			while (!writer.write(data))
+				std::this_thread::yield();
+		}
+		writer.flush();
+		EXPECT_EQ(writer.frameCount, frameCount);
+		EXPECT_LE(writer.writeCount, frameCount);
+	}
+	auto time = std::chrono::steady_clock::now() - start;
+	close(fd);
+
+	double fps = frameCount / std::chrono::duration<double>(time).count();
+	RecordProperty("framesPerSecond", int(fps));
+	EXPECT_GT(fps, 1000);
+}
+
+
+// LedStrip_file
+
+// gives access to the handler that the event loop calls
+class TestLedStrip_file : public LedStrip_file {
+public:
+	using LedStrip_file::LedStrip_file;
+	using LedStrip_file::handle;
+};
+
+TEST(cocoTest, LedStrip_file) {
+	Loop_native loop;
+
+	// a file that can't be opened disables the device
+	{
+		TestLedStrip_file ledStrip(loop, testing::TempDir() + "missing/LedStrip_file.bin", 1250ns, 80us);
+		LedStrip_file::Buffer buffer(10 * 3, ledStrip);
+		EXPECT_EQ(ledStrip.state(), Device::State::DISABLED);
+		EXPECT_FALSE(buffer.ready());
+	}
+
+	// a cancelled transfer does not get written
+	std::string path = testing::TempDir() + "LedStrip_file.bin";
+	{
+		TestLedStrip_file ledStrip(loop, path, 1250ns, 80us);
+		LedStrip_file::Buffer buffer(10 * 3, ledStrip);
+		EXPECT_EQ(ledStrip.state(), Device::State::READY);
+		buffer.startWrite(10 * 3);
+		EXPECT_FALSE(buffer.ready());
+		EXPECT_TRUE(buffer.cancel());
+		EXPECT_TRUE(buffer.ready());
+		ledStrip.handle();
+
+		buffer.startWrite(10 * 3);
+		ledStrip.handle();
+		EXPECT_TRUE(buffer.ready());
+	}
+	struct stat s;
+	ASSERT_EQ(stat(path.c_str(), &s), 0);
+	EXPECT_EQ(s.st_size, LedEncoder_SPI<3>::wordCount(10 * 3) + LedFileWriter::calcResetBytes(3, 1250, 80));
+	unlink(path.c_str());
+}
+
+TEST(cocoTest, LedStrip_file_Backpressure) {
+	Loop_native loop;
+	std::string path = testing::TempDir() + "LedStrip_file.fifo";
+	unlink(path.c_str());
+	ASSERT_EQ(mkfifo(path.c_str(), 0600), 0);
+	int reader = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+	ASSERT_GE(reader, 0);
+	char data[4096];
+	std::thread drain;
+	{
+		TestLedStrip_file ledStrip(loop, path, 1250ns, 80us);
+		LedStrip_file::Buffer buffer(300 * 3, ledStrip);
+
+		// nobody reads: the frames fill the pipe and the ring of the writer until the buffer stays busy
+		int count = 0;
+		while (true) {
+			buffer.startWrite(300 * 3);
+			ledStrip.handle();
+			if (!buffer.ready())
+				break;
+			++count;
+			ASSERT_LT(count, 1000);
+		}
+		EXPECT_GE(count, LedFileWriter::FRAME_COUNT);
+
+		// read from the pipe: the buffer gets handed to the writer at the next call of the handler
+		for (int i = 0; i < 1000 && !buffer.ready(); ++i) {
+			while (read(reader, data, sizeof(data)) > 0);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			ledStrip.handle();
+		}
+		EXPECT_TRUE(buffer.ready());
+
+		// read the remaining frames while the destructor flushes the writer
+		fcntl(reader, F_SETFL, 0);
+		drain = std::thread([reader, &data] {while (read(reader, data, sizeof(data)) > 0);});
+	}
+	drain.join();
+	close(reader);
+	unlink(path.c_str());
+}
+
+
+// LedRecorder
+
+TEST(cocoTest, LedRecorder) {
+	std::string path = testing::TempDir() + "LedRecorder.bin";
+	auto frame = generateData(300 * 3);
+	size_t size;
+	{
+		// record 1000 frames where one pixel changes, the file has to grow
+		LedRecorder recorder(path, 3);
+		ASSERT_TRUE(recorder.isOpen());
+		for (int i = 0; i < 1000; ++i) {
+			frame[(i % 300) * 3] ^= 0x80;
+			EXPECT_TRUE(recorder.add(frame, i * 1000));
+		}
+		size = recorder.size();
+	}
+
+	// read back
+	MappedFile file(path);
+	ASSERT_TRUE(file.isOpen());
+	EXPECT_EQ(file.size(), size);
+	LedCapture::Reader reader(file.data());
+	std::vector<uint8_t> replay(300 * 3);
+	int count = 0;
+	while (reader.next()) {
+		reader.apply(replay);
+		++count;
+	}
+	EXPECT_EQ(count, 1000);
+	EXPECT_EQ(reader.time(), 999000);
+	EXPECT_EQ(replay, frame);
+	unlink(path.c_str());
+}
+#endif
+
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	int success = RUN_ALL_TESTS();
+	return success;
+}
@@ -13,6 +13,7 @@ struct Drivers {
 	LedStrip_cout ledStrip{loop};
 	LedStrip_cout::Buffer buffer1{LEDSTRIP_LENGTH, ledStrip};
 	LedStrip_cout::Buffer buffer2{LEDSTRIP_LENGTH, ledStrip};
+	LedStrip_cout::Buffer buffer3{LEDSTRIP_LENGTH, ledStrip};
 };
 
 Drivers drivers;
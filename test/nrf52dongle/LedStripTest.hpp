@@ -20,6 +20,7 @@ struct Drivers {
 		75us}; // reset time
 	LedStrip_I2S::Buffer<LEDSTRIP_LENGTH * 3> buffer1{ledStrip};
 	LedStrip_I2S::Buffer<LEDSTRIP_LENGTH * 3> buffer2{ledStrip};
+	LedStrip_I2S::Buffer<LEDSTRIP_LENGTH * 3> buffer3{ledStrip};
 };
 
 Drivers drivers;
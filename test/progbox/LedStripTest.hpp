@@ -31,6 +31,7 @@ struct Drivers {
 		50us}; // reset time
 	LedStrip::Buffer<LEDSTRIP_LENGTH * 3> buffer1{ledStrip};
 	LedStrip::Buffer<LEDSTRIP_LENGTH * 3> buffer2{ledStrip};
+	LedStrip::Buffer<LEDSTRIP_LENGTH * 3> buffer3{ledStrip};
 
 	Drivers() {
 		// set RS4xx_DE1 high
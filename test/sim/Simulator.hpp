@@ -0,0 +1,675 @@
+#pragma once
+
+#include <coco/LedDecoder.hpp>
+#include <coco/platform/TimerDma.hpp>
+#include <coco/platform/dma.hpp>
+#include <coco/platform/gpio.hpp>
+#include <coco/platform/spi.hpp>
+#include <coco/platform/timer.hpp>
+#include <coco/platform/usart.hpp>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+
+namespace coco {
+namespace sim {
+
+/**
+	Statistics of the interrupt handler calls
+*/
+struct IrqStats {
+	// number of calls
+	int count = 0;
+
+	// total and maximum host time spent in the interrupt handler
+	std::chrono::nanoseconds totalTime = {};
+	std::chrono::nanoseconds maxTime = {};
+
+	void call(const std::function<void ()> &handler) {
+		auto start = std::chrono::steady_clock::now();
+		handler();
+		auto time = std::chrono::steady_clock::now() - start;
+		++this->count;
+		this->totalTime += time;
+		this->maxTime = std::max(this->maxTime, std::chrono::duration_cast<std::chrono::nanoseconds>(time));
+	}
+};
+
+/**
+	Simulator of the nrf52 I2S peripheral in 24 bit stereo mode. Records the waveform on SDOUT. Only TXD.PTR is double
+	buffered, therefore RXTXD.MAXCNT has to stay the same while the peripheral runs. The TXPTRUPD events
+	can be counted by NRF_TIMER2 via PPI, the simulated timer captures its counter continuously into CC[0] as the
+	interrupt handler gets called synchronously.
+	Create before the driver as the constructor resets the registers.
+	Usage: sim.run([] {drivers.ledStrip.I2S_IRQHandler();});
+*/
+class I2sSimulator {
+public:
+	I2sSimulator() {
+		sim::i2s = {};
+		sim::timer2 = {};
+		sim::ppi = {};
+	}
+
+	/**
+		Get the duration of one bit on the line
+	*/
+	std::chrono::duration<double, std::nano> bitTime() const {
+		// MCK = 32MHz * MCKFREQ / 2^32, SCK = MCK for 24 bit stereo and RATIO 48X
+		double mck = 32.0 * NRF_I2S->CONFIG.MCKFREQ / double(int64_t(1) << 32);
+		return std::chrono::duration<double, std::nano>(1000.0 / mck);
+	}
+
+	/**
+		Run the peripheral until it gets stopped by the driver
+		@param irqHandler I2S interrupt handler of the driver
+		@param maxWords maximum number of words to transmit to prevent an endless loop
+		@return true if the peripheral was stopped, false if maxWords was reached
+	*/
+	bool run(const std::function<void ()> &irqHandler, int maxWords = 1 << 24) {
+		auto i2s = NRF_I2S;
+		if (!i2s->TASKS_START.written)
+			return true;
+		i2s->TASKS_START.written = false;
+		i2s->TASKS_STOP.written = false;
+
+		double bitTime = this->bitTime().count();
+		int count = i2s->RXTXD.MAXCNT;
+		int wordCount = 0;
+		int eventIndex = 0;
+		while (wordCount < maxWords) {
+			// latch the pointer, an underrun occurs when the driver did not set a new pointer since the last latch
+			if (!i2s->TXD.PTR.written)
+				++this->underrunCount;
+			i2s->TXD.PTR.written = false;
+			auto data = reinterpret_cast<const uint32_t *>(uintptr_t(i2s->TXD.PTR));
+			assert(int(i2s->RXTXD.MAXCNT) == count);
+
+			// the driver sets the next pointer in the interrupt handler while the current buffer gets transmitted
+			i2s->EVENTS_TXPTRUPD = 1;
+			countEvent();
+			bool late = eventIndex++ == this->lateEvent;
+			if (!late && (i2s->INTENSET & N(I2S_INTENSET_TXPTRUPD, Set)) != 0)
+				this->irq.call(irqHandler);
+
+			// transmit 24 bit words, MSB first
+			this->waveform.appendI2S(std::span(data, count), bitTime);
+			wordCount += count;
+
+			if (i2s->TASKS_STOP.written) {
+				i2s->TASKS_STOP.written = false;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// waveform on SDOUT
+	LedWaveform waveform;
+
+	// number of buffers that were transmitted twice because the driver did not set a new pointer in time
+	int underrunCount = 0;
+
+	// index of the TXPTRUPD event in a run whose interrupt gets delayed after the next event (e.g. by the radio)
+	int lateEvent = -1;
+
+	IrqStats irq;
+
+protected:
+	// count TXPTRUPD event if PPI connects it to the timer
+	void countEvent() {
+		auto ppi = NRF_PPI;
+		auto timer = NRF_TIMER2;
+		for (int i = 0; i < 20; ++i) {
+			if ((ppi->CHENSET & (1 << i)) != 0 && ppi->CH[i].EEP == uintptr_t(&NRF_I2S->EVENTS_TXPTRUPD)
+				&& ppi->CH[i].TEP == uintptr_t(&timer->TASKS_COUNT) && timer->TASKS_START.written)
+			{
+				if (timer->TASKS_CLEAR.written) {
+					timer->TASKS_CLEAR.written = false;
+					timer->CC[0] = 0;
+				}
+				++timer->CC[0];
+			}
+		}
+	}
+};
+
+/**
+	Simulator of the nrf52 PWM peripheral that plays SEQ0 and SEQ1 in a loop (LOOP = 1 with shortcut from LOOPSDONE to
+	SEQSTART0). Records the waveform on each of the 4 outputs.
+	Usage: sim.run([] {drivers.ledStrip.PWM_IRQHandler();});
+*/
+class NrfPwmSimulator {
+public:
+	/**
+		Get the simulated PWM instance for the driver
+	*/
+	NRF_PWM_Type *pwm() {return &this->instance;}
+
+	/**
+		Get the duration of one PWM period
+	*/
+	std::chrono::duration<double, std::nano> periodTime() const {
+		return std::chrono::duration<double, std::nano>(this->instance.COUNTERTOP * clockTime());
+	}
+
+	/**
+		Run the PWM until it gets stopped by the driver
+		@param irqHandler PWM interrupt handler of the driver
+		@param maxPeriods maximum number of PWM periods to prevent an endless loop
+		@return true if the PWM was stopped, false if maxPeriods was reached
+	*/
+	bool run(const std::function<void ()> &irqHandler, int maxPeriods = 1 << 24) {
+		auto pwm = &this->instance;
+		if (!pwm->TASKS_SEQSTART[0].written)
+			return true;
+		pwm->TASKS_SEQSTART[0].written = false;
+		pwm->TASKS_STOP.written = false;
+		assert(pwm->LOOP == 1 && (pwm->SHORTS & N(PWM_SHORTS_LOOPSDONE_SEQSTART0, Enabled)) != 0);
+
+		// number of values per step depends on the load mode of the decoder
+		int load = (pwm->DECODER >> PWM_DECODER_LOAD_Pos) & PWM_DECODER_LOAD_Msk;
+		int step = load == PWM_DECODER_LOAD_Common ? 1 : (load == PWM_DECODER_LOAD_Grouped ? 2 : 4);
+
+		double clockTime = this->clockTime();
+		int period = pwm->COUNTERTOP;
+		int seq = 0;
+		int periodCount = 0;
+		int eventIndex = 0;
+		while (periodCount < maxPeriods) {
+			// the sequence registers get latched when the sequence starts
+			auto data = reinterpret_cast<const uint16_t *>(pwm->SEQ[seq].PTR);
+			int count = pwm->SEQ[seq].CNT;
+			assert(count > 0 && count % step == 0);
+
+			for (int i = 0; i < count; i += step) {
+				for (int out = 0; out < 4; ++out) {
+					if (pwm->PSEL.OUT[out] == 0xffffffff)
+						continue;
+
+					// bit 15 set: high until the counter reaches the compare value, otherwise low
+					uint16_t value = data[i + (step == 1 ? 0 : (step == 2 ? out / 2 : out))];
+					bool polarity = (value & 0x8000) != 0;
+					int high = std::min(value & 0x7fff, period);
+					if (high > 0)
+						this->waveforms[out].append(polarity, high * clockTime);
+					if (high < period)
+						this->waveforms[out].append(!polarity, (period - high) * clockTime);
+				}
+				++periodCount;
+			}
+
+			// the other sequence starts and the driver refills this one
+			pwm->EVENTS_SEQEND[seq] = 1;
+			bool late = eventIndex++ == this->lateEvent;
+			if (!late && (pwm->INTENSET & (N(PWM_INTENSET_SEQEND0, Set) << seq)) != 0)
+				this->irq.call(irqHandler);
+
+			if (pwm->TASKS_STOP.written) {
+				pwm->TASKS_STOP.written = false;
+				return true;
+			}
+			seq ^= 1;
+		}
+		return false;
+	}
+
+	// waveforms on the outputs
+	std::array<LedWaveform, 4> waveforms;
+
+	// index of the SEQEND event in a run whose interrupt gets delayed after the next SEQEND event, the simulation does
+	// not replay the stale sequence but the driver sees both events at once
+	int lateEvent = -1;
+
+	IrqStats irq;
+
+protected:
+	// duration of a PWM clock cycle in ns (16MHz / 2^PRESCALER)
+	double clockTime() const {
+		return 62.5 * (1 << this->instance.PRESCALER);
+	}
+
+	NRF_PWM_Type instance;
+};
+
+/**
+	Simulator of a stm32 USART with a DMA channel for transmitting. Records the waveform on the TX pin.
+	Usage: sim.run([] {drivers.ledStrip.UART_IRQHandler();}, [] {drivers.ledStrip.DMA_IRQHandler();});
+*/
+class UartSimulator {
+public:
+	/**
+		Constructor
+		@param txPin transmit pin of the USART
+		@param clock peripheral clock frequency in Hz
+	*/
+	UartSimulator(gpio::Config txPin, int clock) : txPin(txPin), clock(clock) {}
+
+	/**
+		Get info of the simulated USART for the driver
+	*/
+	usart::Info usartInfo() {return {&this->uart, USART1_IRQn, {}};}
+
+	/**
+		Get info of the simulated DMA channel for the driver
+	*/
+	dma::Info dmaInfo() {return {{}, DMA1_Channel1_IRQn, &this->dma};}
+
+	/**
+		Get the duration of one bit on the line
+	*/
+	std::chrono::duration<double, std::nano> bitTime() const {
+		// baud rate = 2 * clock / USARTDIV for 8x oversampling
+		uint32_t brr = this->uart.BRR;
+		int div = ((brr & ~15) | ((brr & 7) << 1));
+		return std::chrono::duration<double, std::nano>(div * 1e9 / (2.0 * this->clock));
+	}
+
+	/**
+		Run the peripheral until no transfer is active and no interrupt is enabled
+		@param uartIrqHandler USART interrupt handler of the driver
+		@param dmaIrqHandler DMA interrupt handler of the driver
+		@param maxFrames maximum number of frames to transmit to prevent an endless loop
+		@return true if the peripheral is idle, false if maxFrames was reached
+	*/
+	bool run(const std::function<void ()> &uartIrqHandler, const std::function<void ()> &dmaIrqHandler,
+		int maxFrames = 1 << 24)
+	{
+		auto uart = &this->uart;
+		auto dma = &this->dma;
+		int frameCount = 0;
+		while (frameCount < maxFrames) {
+			bool enabled = (uart->CR1 & (USART_CR1_UE | USART_CR1_TE)) == (USART_CR1_UE | USART_CR1_TE);
+			if (enabled && (uart->CR3 & USART_CR3_DMAT) != 0 && dma->enabled && dma->count > 0) {
+				// new data clears the transmission complete flag
+				uart->ISR &= ~USART_ISR_TC;
+
+				// DMA transfers bytes to the USART
+				transmit(dma->memoryAddress, dma->count,
+					(dma->config & uint32_t(dma::Channel::Config::INCREMENT_MEMORY)) != 0);
+				frameCount += dma->count;
+				dma->count = 0;
+				dma->transferComplete = true;
+				if ((dma->config & uint32_t(dma::Channel::Config::TRANSFER_COMPLETE_INTERRUPT)) != 0)
+					this->dmaIrq.call(dmaIrqHandler);
+			} else {
+				// transmission complete
+				uart->ISR |= USART_ISR_TC;
+				if ((uart->CR1 & USART_CR1_TCIE) == 0)
+					return true;
+				this->uartIrq.call(uartIrqHandler);
+			}
+		}
+		return false;
+	}
+
+	// waveform on the TX pin
+	LedWaveform waveform;
+
+	IrqStats uartIrq;
+	IrqStats dmaIrq;
+
+protected:
+	void transmit(const void *memory, int count, bool increment) {
+		auto uart = &this->uart;
+		auto &pin = sim::pins[gpio::getPinIndex(this->txPin)];
+		bool m1 = (uart->CR1 & USART_CR1_M1) != 0;
+		bool m0 = (uart->CR1 & USART_CR1_M0) != 0;
+		int dataBits = m1 ? 7 : (m0 ? 9 : 8);
+		bool dataInv = (uart->CR2 & USART_CR2_DATAINV) != 0;
+		bool txInv = (uart->CR2 & USART_CR2_TXINV) != 0;
+		double bitTime = this->bitTime().count();
+
+		auto data = static_cast<const uint8_t *>(memory);
+		for (int i = 0; i < count; ++i) {
+			int value = data[increment ? i : 0];
+			if (dataInv)
+				value = ~value;
+
+			// start bit, data bits (LSB first), stop bit
+			int bitCount = dataBits + 2;
+			for (int j = 0; j < bitCount; ++j) {
+				bool bit = j == 0 ? false : (j == bitCount - 1 ? true : ((value >> (j - 1)) & 1) != 0);
+				if (pin.mode == gpio::Mode::ALTERNATE)
+					this->waveform.append(bit != txInv, bitTime);
+				else
+					this->waveform.append(pin.level, bitTime);
+			}
+		}
+	}
+
+	gpio::Config txPin;
+	int clock;
+
+	USART_TypeDef uart;
+	sim::DmaChannel dma;
+};
+
+/**
+	Simulator of a stm32 SPI with a DMA channel for transmitting, supports circular mode with half transfer interrupt.
+	Records the waveform on MOSI.
+	Usage: sim.run([] {drivers.ledStrip.DMA_IRQHandler();});
+*/
+class SpiSimulator {
+public:
+	/**
+		Constructor
+		@param clock peripheral clock frequency in Hz
+	*/
+	SpiSimulator(int clock) : clock(clock) {}
+
+	/**
+		Get info of the simulated SPI for the driver
+	*/
+	spi::Info spiInfo() {return {&this->spi, SPI1_IRQn, {}};}
+
+	/**
+		Get info of the simulated DMA channel for the driver
+	*/
+	dma::Info dmaInfo() {return {{}, DMA1_Channel3_IRQn, &this->dma};}
+
+	/**
+		Get the duration of one bit on the line
+	*/
+	std::chrono::duration<double, std::nano> bitTime() const {
+		// SPI clock = clock / 2^(BR + 1)
+		int br = (this->spi.CR1 >> SPI_CR1_BR_Pos) & 7;
+		return std::chrono::duration<double, std::nano>((2 << br) * 1e9 / this->clock);
+	}
+
+	/**
+		Run the peripheral until the DMA channel gets disabled or has transferred all data in normal mode
+		@param dmaIrqHandler DMA interrupt handler of the driver
+		@param maxBytes maximum number of bytes to transmit to prevent an endless loop
+		@return true if the DMA channel is idle, false if maxBytes was reached
+	*/
+	bool run(const std::function<void ()> &dmaIrqHandler, int maxBytes = 1 << 24) {
+		auto spi = &this->spi;
+		auto dma = &this->dma;
+		int byteCount = 0;
+		while (byteCount < maxBytes) {
+			bool enabled = (spi->CR1 & SPI_CR1_SPE) != 0 && (spi->CR2 & SPI_CR2_TXDMAEN) != 0;
+			if (!enabled || !dma->enabled || dma->count == 0)
+				return true;
+			uint32_t config = dma->config;
+			bool circular = (config & uint32_t(dma::Channel::Config::CIRCULAR)) != 0;
+			auto data = static_cast<const uint8_t *>(dma->memoryAddress);
+			int count = dma->count;
+			int half = count / 2;
+
+			// the driver refills a half in the interrupt handler while the other half gets transmitted
+			int enableCount = dma->enableCount;
+			transmit(data, half);
+			dma->halfTransfer = true;
+			if ((config & uint32_t(dma::Channel::Config::HALF_TRANSFER_INTERRUPT)) != 0)
+				this->dmaIrq.call(dmaIrqHandler);
+			byteCount += half;
+
+			// the driver may have stopped the DMA or started a new transfer in the interrupt handler
+			if (dma->enableCount != enableCount)
+				continue;
+			if (!dma->enabled)
+				return true;
+			transmit(data + half, count - half);
+			byteCount += count - half;
+			if (!circular)
+				dma->count = 0;
+			dma->transferComplete = true;
+			if ((config & uint32_t(dma::Channel::Config::TRANSFER_COMPLETE_INTERRUPT)) != 0)
+				this->dmaIrq.call(dmaIrqHandler);
+		}
+		return false;
+	}
+
+	// waveform on MOSI
+	LedWaveform waveform;
+
+	IrqStats dmaIrq;
+
+protected:
+	void transmit(const uint8_t *data, int count) {
+		// 8 bit data frames, MSB first
+		assert(((this->spi.CR2 >> SPI_CR2_DS_Pos) & 15) == 7 && (this->spi.CR1 & SPI_CR1_LSBFIRST) == 0);
+		this->waveform.appendSPI(std::span(data, count), this->bitTime().count());
+	}
+
+	int clock;
+
+	SPI_TypeDef spi;
+	sim::DmaChannel dma;
+};
+
+/**
+	Simulator of a stm32 timer that triggers a DMA channel which writes to the output data register of a GPIO port.
+	Records the waveform on each of the 16 pins of the port.
+	Usage: sim.run([] {drivers.ledStrip.DMA_IRQHandler();});
+*/
+class ParallelSimulator {
+public:
+	/**
+		Constructor
+		@param clock timer clock frequency in Hz
+	*/
+	ParallelSimulator(int clock) : clock(clock) {}
+
+	/**
+		Get the simulated GPIO port for the driver
+	*/
+	GPIO_TypeDef *port() {return &this->gpio;}
+
+	/**
+		Get info of the simulated timer for the driver
+	*/
+	timer::Info timerInfo() {return {&this->timer, TIM1_UP_TIM16_IRQn, {}};}
+
+	/**
+		Get info of the simulated DMA channel for the driver
+	*/
+	dma::Info dmaInfo() {return {{}, DMA1_Channel2_IRQn, &this->dma};}
+
+	/**
+		Get the registers and DMAMUX request of the simulated DMA channel for the driver
+	*/
+	TimerDma timerDma() {return {&this->dmaChannel, &this->dmaMux, TIM_UP_REQUEST};}
+
+	/**
+		Get the duration of one timer period
+	*/
+	std::chrono::duration<double, std::nano> slotTime() const {
+		return std::chrono::duration<double, std::nano>((this->timer.PSC + 1) * (this->timer.ARR + 1) * 1e9
+			/ this->clock);
+	}
+
+	/**
+		Run the timer until it gets stopped by the driver
+		@param dmaIrqHandler DMA interrupt handler of the driver
+		@param maxSlots maximum number of timer periods to prevent an endless loop
+		@return true if the timer was stopped, false if maxSlots was reached or the timer runs without DMA transfer
+	*/
+	bool run(const std::function<void ()> &dmaIrqHandler, int maxSlots = 1 << 24) {
+		auto channel = &this->dmaChannel;
+		int slotCount = 0;
+		while (slotCount < maxSlots) {
+			if ((this->timer.CR1 & TIM_CR1_CEN) == 0)
+				return true;
+			uint32_t config = channel->CCR;
+			if ((this->timer.DIER & TIM_DIER_UDE) == 0 || (config & DMA_CCR_EN) == 0 || channel->CNDTR == 0)
+				return false;
+			assert(this->dmaMux == TIM_UP_REQUEST && (config & DMA_CCR_DIR) != 0);
+
+			// each update event transfers one byte to the port
+			double slotTime = this->slotTime().count();
+			bool increment = (config & DMA_CCR_MINC) != 0;
+			auto data = reinterpret_cast<const uint8_t *>(channel->CMAR);
+			auto dst = reinterpret_cast<volatile uint8_t *>(channel->CPAR);
+			int count = channel->CNDTR;
+			for (int i = 0; i < count; ++i) {
+				*dst = data[increment ? i : 0];
+				uint32_t odr = this->gpio.ODR;
+				for (int pin = 0; pin < 16; ++pin)
+					this->waveforms[pin].append((odr >> pin) & 1, slotTime);
+			}
+			slotCount += count;
+			channel->CNDTR = 0;
+			this->dma.transferComplete = true;
+			if ((config & DMA_CCR_TCIE) != 0)
+				this->dmaIrq.call(dmaIrqHandler);
+		}
+		return false;
+	}
+
+	// waveforms on the pins of the port
+	std::array<LedWaveform, 16> waveforms;
+
+	IrqStats dmaIrq;
+
+protected:
+	int clock;
+
+	// DMAMUX request of the timer update
+	static constexpr int TIM_UP_REQUEST = 42;
+
+	GPIO_TypeDef gpio;
+	TIM_TypeDef timer;
+	sim::DmaChannel dma;
+	DMA_Channel_TypeDef dmaChannel;
+	uint32_t dmaMux = 0;
+};
+
+/**
+	Simulator of a stm32 timer in PWM mode whose update event triggers a DMA burst to the compare registers, supports
+	circular mode with half transfer interrupt. Records the waveform on each of the 4 channels.
+	Usage: sim.run([] {drivers.ledStrip.DMA_IRQHandler();});
+*/
+class PwmSimulator {
+public:
+	/**
+		Constructor
+		@param clock timer clock frequency in Hz
+	*/
+	PwmSimulator(int clock) : clock(clock) {}
+
+	/**
+		Get info of the simulated timer for the driver
+	*/
+	timer::Info timerInfo() {return {&this->timer, TIM1_UP_TIM16_IRQn, {}};}
+
+	/**
+		Get info of the simulated DMA channel for the driver
+	*/
+	dma::Info dmaInfo() {return {{}, DMA1_Channel2_IRQn, &this->dma};}
+
+	/**
+		Get the registers and DMAMUX request of the simulated DMA channel for the driver
+	*/
+	TimerDma timerDma() {return {&this->dmaChannel, &this->dmaMux, TIM_UP_REQUEST};}
+
+	/**
+		Get the duration of one timer period
+	*/
+	std::chrono::duration<double, std::nano> periodTime() const {
+		return std::chrono::duration<double, std::nano>((this->timer.PSC + 1) * (this->timer.ARR + 1) * 1e9
+			/ this->clock);
+	}
+
+	/**
+		Run the timer until it gets stopped by the driver
+		@param dmaIrqHandler DMA interrupt handler of the driver
+		@param maxPeriods maximum number of timer periods to prevent an endless loop
+		@return true if the timer was stopped, false if maxPeriods was reached
+	*/
+	bool run(const std::function<void ()> &dmaIrqHandler, int maxPeriods = 1 << 24) {
+		auto timer = &this->timer;
+		auto channel = &this->dmaChannel;
+		uint32_t *ccr = &timer->CCR1;
+		int periodCount = 0;
+		while (periodCount < maxPeriods) {
+			if ((timer->CR1 & TIM_CR1_CEN) == 0)
+				return true;
+
+			// update event: the preloaded compare values become active
+			for (int i = 0; i < 4; ++i)
+				this->compare[i] = ccr[i];
+
+			// DMA burst to the compare registers
+			uint32_t config = channel->CCR;
+			if ((timer->DIER & TIM_DIER_UDE) != 0 && (config & DMA_CCR_EN) != 0 && channel->CNDTR > 0) {
+				if (channel->CCR.written) {
+					// new transfer
+					channel->CCR.written = false;
+					this->position = 0;
+				}
+				assert(this->dmaMux == TIM_UP_REQUEST && (config & DMA_CCR_DIR) != 0);
+				assert(channel->CPAR == uintptr_t(&timer->DMAR));
+				assert((config & DMA_CCR_MINC) != 0 && (config & DMA_CCR_PSIZE_0) != 0);
+				int first = (timer->DCR >> TIM_DCR_DBA_Pos) & 31;
+				int length = ((timer->DCR >> TIM_DCR_DBL_Pos) & 31) + 1;
+				auto data = reinterpret_cast<const uint8_t *>(channel->CMAR);
+				int count = channel->CNDTR;
+				for (int i = 0; i < length; ++i) {
+					int index = first + i - int(offsetof(TIM_TypeDef, CCR1) / 4);
+					assert(index >= 0 && index < 4);
+					ccr[index] = data[this->position++];
+					if (this->position == count / 2) {
+						this->dma.halfTransfer = true;
+						if ((config & DMA_CCR_HTIE) != 0)
+							this->dmaIrq.call(dmaIrqHandler);
+					} else if (this->position == count) {
+						this->position = 0;
+						if ((config & DMA_CCR_CIRC) == 0)
+							channel->CNDTR = 0;
+						this->dma.transferComplete = true;
+						if ((config & DMA_CCR_TCIE) != 0)
+							this->dmaIrq.call(dmaIrqHandler);
+					}
+				}
+				if ((timer->CR1 & TIM_CR1_CEN) == 0)
+					return true;
+			}
+
+			// PWM mode 1: high until the counter reaches the compare value
+			double clockTime = 1e9 / this->clock * (timer->PSC + 1);
+			int period = timer->ARR + 1;
+			for (int i = 0; i < 4; ++i) {
+				if ((timer->CCER & (TIM_CCER_CC1E << (i * 4))) == 0)
+					continue;
+				bool invert = (timer->CCER & (TIM_CCER_CC1P << (i * 4))) != 0;
+				int high = std::min(int(this->compare[i]), period);
+				if (high > 0)
+					this->waveforms[i].append(!invert, high * clockTime);
+				if (high < period)
+					this->waveforms[i].append(invert, (period - high) * clockTime);
+			}
+			++periodCount;
+		}
+		return false;
+	}
+
+	// waveforms on the channels
+	std::array<LedWaveform, 4> waveforms;
+
+	IrqStats dmaIrq;
+
+protected:
+	int clock;
+
+	// DMAMUX request of the timer update
+	static constexpr int TIM_UP_REQUEST = 42;
+
+	TIM_TypeDef timer;
+	sim::DmaChannel dma;
+	DMA_Channel_TypeDef dmaChannel;
+	uint32_t dmaMux = 0;
+
+	// active compare values
+	uint32_t compare[4] = {};
+
+	// position of the DMA in the memory
+	int position = 0;
+};
+
+} // namespace sim
+} // namespace coco
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <deque>
+
+
+namespace coco {
+
+/**
+	Simulated event loop that receives handlers from interrupt handlers. The simulation calls process() to let the
+	handlers run, e.g. to set a buffer to ready state after the transfer has finished.
+*/
+class Loop_Queue {
+public:
+	/**
+		Handler that gets called from the event loop
+	*/
+	class Handler {
+	public:
+		virtual ~Handler() {}
+		virtual void handle() = 0;
+	};
+
+	/**
+		Push a handler from an interrupt handler
+	*/
+	void push(Handler &handler) {
+		this->handlers.push_back(&handler);
+	}
+
+	/**
+		Call all pushed handlers
+		@return number of handlers that were called
+	*/
+	int process() {
+		int count = 0;
+		while (!this->handlers.empty()) {
+			auto handler = this->handlers.front();
+			this->handlers.pop_front();
+			handler->handle();
+			++count;
+		}
+		return count;
+	}
+
+protected:
+	std::deque<Handler *> handlers;
+};
+
+} // namespace coco
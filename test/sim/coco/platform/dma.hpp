@@ -0,0 +1,121 @@
+#pragma once
+
+#include "platform.hpp"
+
+
+namespace coco {
+namespace sim {
+
+/**
+	State of a simulated DMA channel
+*/
+struct DmaChannel {
+	const volatile void *peripheralAddress = nullptr;
+	const void *memoryAddress = nullptr;
+	int count = 0;
+	uint32_t config = 0;
+	bool enabled = false;
+
+	// number of times the channel was enabled, e.g. to detect that a driver has started a new transfer
+	int enableCount = 0;
+
+	// half transfer and transfer complete flags
+	bool halfTransfer = false;
+	bool transferComplete = false;
+};
+
+} // namespace sim
+
+namespace dma {
+
+/**
+	Simulated rcc clock of a DMA or peripheral
+*/
+struct Rcc {
+	void enableClock() const {}
+};
+
+/**
+	Status of a simulated DMA channel
+*/
+class Status {
+public:
+	enum class Flags : uint32_t {
+		NONE = 0,
+		TRANSFER_COMPLETE = 1 << 1,
+		HALF_TRANSFER = 1 << 2,
+		ALL = 0xf
+	};
+
+	Status() = default;
+	Status(sim::DmaChannel *channel) : channel(channel) {}
+
+	Flags get() const {
+		return Flags((this->channel->transferComplete ? uint32_t(Flags::TRANSFER_COMPLETE) : 0)
+			| (this->channel->halfTransfer ? uint32_t(Flags::HALF_TRANSFER) : 0));
+	}
+
+	void clear(Flags flags) {
+		if ((uint32_t(flags) & uint32_t(Flags::TRANSFER_COMPLETE)) != 0)
+			this->channel->transferComplete = false;
+		if ((uint32_t(flags) & uint32_t(Flags::HALF_TRANSFER)) != 0)
+			this->channel->halfTransfer = false;
+	}
+
+protected:
+	sim::DmaChannel *channel = nullptr;
+};
+constexpr Status::Flags operator &(Status::Flags a, Status::Flags b) {return Status::Flags(uint32_t(a) & uint32_t(b));}
+constexpr bool operator ==(Status::Flags a, int b) {return uint32_t(a) == uint32_t(b);}
+
+/**
+	Simulated DMA channel
+*/
+class Channel {
+public:
+	enum class Config : uint32_t {
+		NONE = 0,
+		TRANSFER_COMPLETE_INTERRUPT = 1 << 1,
+		HALF_TRANSFER_INTERRUPT = 1 << 2,
+		MEMORY_TO_PERIPHERAL = 1 << 4,
+		CIRCULAR = 1 << 5,
+		INCREMENT_MEMORY = 1 << 7,
+
+		// transmit from memory to a peripheral
+		TX = MEMORY_TO_PERIPHERAL | INCREMENT_MEMORY
+	};
+
+	Channel() = default;
+	Channel(sim::DmaChannel *channel) : channel(channel) {}
+
+	void setPeripheralAddress(const volatile void *address) {this->channel->peripheralAddress = address;}
+	void setMemoryAddress(const void *address) {this->channel->memoryAddress = address;}
+	void setCount(int count) {this->channel->count = count;}
+
+	void enable(Config config) {
+		this->channel->config = uint32_t(config);
+		this->channel->enabled = true;
+		++this->channel->enableCount;
+	}
+
+	void disable() {this->channel->enabled = false;}
+
+protected:
+	sim::DmaChannel *channel = nullptr;
+};
+constexpr Channel::Config operator |(Channel::Config a, Channel::Config b) {return Channel::Config(uint32_t(a) | uint32_t(b));}
+
+/**
+	Info of a simulated DMA channel
+*/
+struct Info {
+	Rcc rcc;
+	int irq;
+	sim::DmaChannel *channel_;
+
+	Status status() const {return {this->channel_};}
+	Channel channel() const {return {this->channel_};}
+};
+
+} // namespace dma
+} // namespace coco
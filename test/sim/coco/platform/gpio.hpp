@@ -0,0 +1,93 @@
+#pragma once
+
+#include "platform.hpp"
+
+
+namespace coco {
+namespace gpio {
+
+/**
+	Simulated pin configuration, the lower 8 bits are the pin index
+*/
+enum class Config : uint32_t {
+	NONE = 0,
+
+	// nrf52 pins
+	P0_2 = 2,
+	P0_3 = 3,
+	P0_4 = 4,
+	P0_5 = 5,
+	P1_14 = 32 + 14,
+
+	// stm32 pins
+	PA7 = 64 + 7,
+	PA8 = 64 + 8,
+	PA9 = 64 + 9,
+	PA10 = 64 + 10,
+	PA11 = 64 + 11,
+	PC4 = 96 + 4,
+
+	PIN_MASK = 0xff,
+
+	// alternate function
+	AF5 = 5 << 8,
+	AF6 = 6 << 8,
+	AF7 = 7 << 8,
+
+	// output speed
+	SPEED_HIGH = 1 << 12,
+
+	// invert the output
+	INVERT = 1 << 13,
+};
+constexpr Config operator |(Config a, Config b) {return Config(uint32_t(a) | uint32_t(b));}
+constexpr Config operator &(Config a, Config b) {return Config(uint32_t(a) & uint32_t(b));}
+constexpr bool extract(Config config, Config flag) {return (uint32_t(config) & uint32_t(flag)) != 0;}
+
+enum class Mode {
+	INPUT,
+	OUTPUT,
+	ALTERNATE,
+	ANALOG
+};
+
+constexpr int getPinIndex(Config config) {return int(config & Config::PIN_MASK);}
+
+} // namespace gpio
+
+namespace sim {
+
+/**
+	State of a simulated pin
+*/
+struct Pin {
+	gpio::Mode mode = gpio::Mode::INPUT;
+
+	// output level on the pin, i.e. after applying the INVERT flag
+	bool level = false;
+};
+inline Pin pins[256];
+
+} // namespace sim
+
+namespace gpio {
+
+inline void setMode(Config config, Mode mode) {
+	sim::pins[getPinIndex(config)].mode = mode;
+}
+
+inline void setOutput(Config config, bool value) {
+	sim::pins[getPinIndex(config)].level = value != extract(config, Config::INVERT);
+}
+
+inline void configureOutput(Config config, bool value) {
+	setOutput(config, value);
+	setMode(config, Mode::OUTPUT);
+}
+
+inline void configureAlternate(Config config) {
+	setMode(config, Mode::ALTERNATE);
+}
+
+} // namespace gpio
+} // namespace coco
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "platform.hpp"
+#include <algorithm>
+#include <deque>
+
+
+namespace coco {
+namespace nvic {
+
+enum class Priority {
+	HIGH,
+	MEDIUM,
+	LOW
+};
+
+// interrupts are called by the simulators, therefore enable and priority have no effect
+inline void enable(int irq) {}
+inline void disable(int irq) {}
+inline void setPriority(int irq, Priority priority) {}
+
+/**
+	Queue that is shared between application and interrupt handler. The simulators call the interrupt handlers
+	synchronously, therefore no locking is needed.
+*/
+template <typename T>
+class Queue {
+public:
+	bool empty() const {return this->elements.empty();}
+
+	/**
+		Add an element to the queue
+		@return true if the queue was empty
+	*/
+	bool push(int irq, T &element) {
+		bool wasEmpty = this->elements.empty();
+		this->elements.push_back(&element);
+		return wasEmpty;
+	}
+
+	/**
+		Remove the first element if popFunction returns true and call nextFunction for the next element if there is one
+		@return true if an element was removed
+	*/
+	template <typename P, typename N>
+	bool pop(P popFunction, N nextFunction) {
+		if (this->elements.empty() || !popFunction(*this->elements.front()))
+			return false;
+		this->elements.pop_front();
+		if (!this->elements.empty())
+			nextFunction(*this->elements.front());
+		return true;
+	}
+
+	/**
+		Remove an element from the queue
+		@param removeFirst remove the element also if it is the first (i.e. active) element
+		@return true if the element was removed
+	*/
+	bool remove(int irq, T &element, bool removeFirst = true) {
+		auto it = std::find(this->elements.begin(), this->elements.end(), &element);
+		if (it == this->elements.end() || (it == this->elements.begin() && !removeFirst))
+			return false;
+		this->elements.erase(it);
+		return true;
+	}
+
+protected:
+	std::deque<T *> elements;
+};
+
+} // namespace nvic
+} // namespace coco
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <cstdint>
+
+
+/*
+	Simulated peripheral registers so that the nrf52 and stm32 drivers compile on the native platform. The registers
+	are plain memory, the simulators in Simulator.hpp react on the values the drivers write.
+*/
+
+namespace coco {
+namespace sim {
+
+/**
+	Register that records that it was written, e.g. to detect that a driver has set a new DMA pointer
+*/
+template <typename T>
+struct Register {
+	T value = 0;
+	bool written = false;
+
+	Register &operator =(T value) {
+		this->value = value;
+		this->written = true;
+		return *this;
+	}
+	operator T() const {return this->value;}
+};
+
+} // namespace sim
+} // namespace coco
+
+
+// nrf52
+
+#define N(field, value) (field##_##value << field##_Pos)
+constexpr int TRIGGER = 1;
+
+enum IRQn_Type {
+	I2S_IRQn = 37,
+	PWM0_IRQn = 28,
+	SPI1_IRQn = 35,
+	USART1_IRQn = 53,
+	DMA1_Channel1_IRQn = 11,
+	DMA1_Channel2_IRQn = 12,
+	DMA1_Channel3_IRQn = 13,
+	TIM1_UP_TIM16_IRQn = 25,
+};
+
+#define I2S_CONFIG_MODE_MODE_Pos 0
+#define I2S_CONFIG_MODE_MODE_Master 0
+#define I2S_CONFIG_TXEN_TXEN_Pos 0
+#define I2S_CONFIG_TXEN_TXEN_Enabled 1
+#define I2S_CONFIG_MCKEN_MCKEN_Pos 0
+#define I2S_CONFIG_MCKEN_MCKEN_Enabled 1
+#define I2S_CONFIG_RATIO_RATIO_Pos 0
+#define I2S_CONFIG_RATIO_RATIO_48X 2
+#define I2S_CONFIG_SWIDTH_SWIDTH_Pos 0
+#define I2S_CONFIG_SWIDTH_SWIDTH_24Bit 1
+#define I2S_CONFIG_FORMAT_FORMAT_Pos 0
+#define I2S_CONFIG_FORMAT_FORMAT_Aligned 1
+#define I2S_CONFIG_CHANNELS_CHANNELS_Pos 0
+#define I2S_CONFIG_CHANNELS_CHANNELS_Stereo 0
+#define I2S_INTENSET_TXPTRUPD_Pos 5
+#define I2S_INTENSET_TXPTRUPD_Set 1
+#define I2S_ENABLE_ENABLE_Pos 0
+#define I2S_ENABLE_ENABLE_Enabled 1
+
+struct NRF_I2S_Type {
+	coco::sim::Register<uint32_t> TASKS_START;
+	coco::sim::Register<uint32_t> TASKS_STOP;
+	uint32_t EVENTS_TXPTRUPD = 0;
+	uint32_t INTENSET = 0;
+	uint32_t ENABLE = 0;
+	struct {
+		uint32_t MODE = 0;
+		uint32_t RXEN = 0;
+		uint32_t TXEN = 0;
+		uint32_t MCKEN = 0;
+		uint32_t MCKFREQ = 0;
+		uint32_t RATIO = 0;
+		uint32_t SWIDTH = 0;
+		uint32_t ALIGN = 0;
+		uint32_t FORMAT = 0;
+		uint32_t CHANNELS = 0;
+	} CONFIG;
+	struct {
+		// pointer has host size
+		coco::sim::Register<uintptr_t> PTR;
+	} TXD;
+	struct {
+		uint32_t MAXCNT = 0;
+	} RXTXD;
+	struct {
+		uint32_t MCK = 0xffffffff;
+		uint32_t SCK = 0xffffffff;
+		uint32_t LRCK = 0xffffffff;
+		uint32_t SDIN = 0xffffffff;
+		uint32_t SDOUT = 0xffffffff;
+	} PSEL;
+};
+
+namespace coco {
+namespace sim {
+inline NRF_I2S_Type i2s;
+}
+}
+#define NRF_I2S (&coco::sim::i2s)
+
+#define TIMER_MODE_MODE_Pos 0
+#define TIMER_MODE_MODE_Counter 1
+#define TIMER_BITMODE_BITMODE_Pos 0
+#define TIMER_BITMODE_BITMODE_32Bit 3
+
+struct NRF_TIMER_Type {
+	coco::sim::Register<uint32_t> TASKS_START;
+	coco::sim::Register<uint32_t> TASKS_STOP;
+	coco::sim::Register<uint32_t> TASKS_COUNT;
+	coco::sim::Register<uint32_t> TASKS_CLEAR;
+	coco::sim::Register<uint32_t> TASKS_CAPTURE[4];
+	uint32_t MODE = 0;
+	uint32_t BITMODE = 0;
+	uint32_t CC[4] = {};
+};
+
+struct NRF_PPI_Type {
+	struct {
+		// addresses have host size
+		uintptr_t EEP = 0;
+		uintptr_t TEP = 0;
+	} CH[20];
+	uint32_t CHENSET = 0;
+};
+
+namespace coco {
+namespace sim {
+inline NRF_TIMER_Type timer2;
+inline NRF_PPI_Type ppi;
+}
+}
+#define NRF_TIMER2 (&coco::sim::timer2)
+#define NRF_PPI (&coco::sim::ppi)
+
+#define PWM_MODE_UPDOWN_Pos 0
+#define PWM_MODE_UPDOWN_Up 0
+#define PWM_PRESCALER_PRESCALER_Pos 0
+#define PWM_PRESCALER_PRESCALER_DIV_1 0
+#define PWM_DECODER_LOAD_Pos 0
+#define PWM_DECODER_LOAD_Common 0
+#define PWM_DECODER_LOAD_Grouped 1
+#define PWM_DECODER_LOAD_Individual 2
+#define PWM_DECODER_LOAD_Msk 3
+#define PWM_DECODER_MODE_Pos 8
+#define PWM_DECODER_MODE_RefreshCount 0
+#define PWM_SHORTS_LOOPSDONE_SEQSTART0_Pos 2
+#define PWM_SHORTS_LOOPSDONE_SEQSTART0_Enabled 1
+#define PWM_INTENSET_SEQEND0_Pos 4
+#define PWM_INTENSET_SEQEND0_Set 1
+#define PWM_INTENSET_SEQEND1_Pos 5
+#define PWM_INTENSET_SEQEND1_Set 1
+#define PWM_ENABLE_ENABLE_Pos 0
+#define PWM_ENABLE_ENABLE_Enabled 1
+
+struct NRF_PWM_Type {
+	coco::sim::Register<uint32_t> TASKS_STOP;
+	coco::sim::Register<uint32_t> TASKS_SEQSTART[2];
+	uint32_t EVENTS_SEQEND[2] = {};
+	uint32_t SHORTS = 0;
+	uint32_t INTENSET = 0;
+	uint32_t ENABLE = 0;
+	uint32_t MODE = 0;
+	uint32_t COUNTERTOP = 0;
+	uint32_t PRESCALER = 0;
+	uint32_t DECODER = 0;
+	uint32_t LOOP = 0;
+	struct {
+		// pointer has host size
+		uintptr_t PTR = 0;
+		uint32_t CNT = 0;
+		uint32_t REFRESH = 0;
+		uint32_t ENDDELAY = 0;
+	} SEQ[2];
+	struct {
+		uint32_t OUT[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+	} PSEL;
+};
+
+
+// stm32
+
+#define USART_CR1_UE (1 << 0)
+#define USART_CR1_TE (1 << 3)
+#define USART_CR1_TCIE (1 << 6)
+#define USART_CR1_M0 (1 << 12)
+#define USART_CR1_OVER8 (1 << 15)
+#define USART_CR1_M1 (1 << 28)
+#define USART_CR2_TXINV (1 << 17)
+#define USART_CR2_DATAINV (1 << 18)
+#define USART_CR3_DMAT (1 << 7)
+#define USART_ISR_TC (1 << 6)
+#define USART_ISR_TEACK (1 << 21)
+
+struct USART_TypeDef {
+	uint32_t CR1 = 0;
+	uint32_t CR2 = 0;
+	uint32_t CR3 = 0;
+	uint32_t BRR = 0;
+
+	// transmitter is always ready and idle when not transmitting
+	uint32_t ISR = USART_ISR_TEACK | USART_ISR_TC;
+	uint32_t TDR = 0;
+};
+
+#define SPI_CR1_MSTR (1 << 2)
+#define SPI_CR1_BR_Pos 3
+#define SPI_CR1_SPE (1 << 6)
+#define SPI_CR1_LSBFIRST (1 << 7)
+#define SPI_CR1_SSI (1 << 8)
+#define SPI_CR1_SSM (1 << 9)
+#define SPI_CR1_BIDIOE (1 << 14)
+#define SPI_CR1_BIDIMODE (1 << 15)
+#define SPI_CR2_TXDMAEN (1 << 1)
+#define SPI_CR2_DS_Pos 8
+
+struct SPI_TypeDef {
+	uint32_t CR1 = 0;
+	uint32_t CR2 = 0;
+	uint32_t DR = 0;
+};
+
+#define TIM_CR1_CEN (1 << 0)
+#define TIM_DIER_UDE (1 << 8)
+#define TIM_CCMR1_OC1PE (1 << 3)
+#define TIM_CCMR1_OC1M_1 (1 << 5)
+#define TIM_CCMR1_OC1M_2 (1 << 6)
+#define TIM_CCER_CC1E (1 << 0)
+#define TIM_CCER_CC1P (1 << 1)
+#define TIM_BDTR_MOE (1 << 15)
+#define TIM_DCR_DBA_Pos 0
+#define TIM_DCR_DBL_Pos 8
+
+struct TIM_TypeDef {
+	uint32_t CR1 = 0;
+	uint32_t DIER = 0;
+	uint32_t CCMR1 = 0;
+	uint32_t CCMR2 = 0;
+	uint32_t CCER = 0;
+	uint32_t PSC = 0;
+	uint32_t ARR = 0;
+
+	// compare registers (preload)
+	uint32_t CCR1 = 0;
+	uint32_t CCR2 = 0;
+	uint32_t CCR3 = 0;
+	uint32_t CCR4 = 0;
+	uint32_t BDTR = 0;
+
+	// DMA burst
+	uint32_t DCR = 0;
+	uint32_t DMAR = 0;
+};
+
+#define DMA_CCR_EN (1 << 0)
+#define DMA_CCR_TCIE (1 << 1)
+#define DMA_CCR_HTIE (1 << 2)
+#define DMA_CCR_DIR (1 << 4)
+#define DMA_CCR_CIRC (1 << 5)
+#define DMA_CCR_MINC (1 << 7)
+#define DMA_CCR_PSIZE_0 (1 << 8)
+
+struct DMA_Channel_TypeDef {
+	// configuration, the simulators detect a new transfer when it was written
+	coco::sim::Register<uint32_t> CCR;
+	uint32_t CNDTR = 0;
+	uintptr_t CPAR = 0;
+	uintptr_t CMAR = 0;
+};
+
+struct GPIO_TypeDef {
+	uint32_t MODER = 0;
+	uint32_t OSPEEDR = 0;
+	uint32_t ODR = 0;
+	uint32_t BSRR = 0;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "dma.hpp"
+
+
+namespace coco {
+namespace spi {
+
+/**
+	Info of a simulated SPI
+*/
+struct Info {
+	SPI_TypeDef *spi;
+	int irq;
+	dma::Rcc rcc;
+
+	void mapTx(const dma::Info &dmaInfo) const {}
+};
+
+} // namespace spi
+} // namespace coco
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "dma.hpp"
+
+
+namespace coco {
+namespace timer {
+
+/**
+	Info of a simulated timer
+*/
+struct Info {
+	TIM_TypeDef *timer;
+	int irq;
+	dma::Rcc rcc;
+};
+
+} // namespace timer
+} // namespace coco
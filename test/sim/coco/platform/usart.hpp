@@ -0,0 +1,21 @@
+#pragma once
+
+#include "dma.hpp"
+
+
+namespace coco {
+namespace usart {
+
+/**
+	Info of a simulated USART
+*/
+struct Info {
+	USART_TypeDef *usart;
+	int irq;
+	dma::Rcc rcc;
+
+	void mapTx(const dma::Info &dmaInfo) const {}
+};
+
+} // namespace usart
+} // namespace coco
@@ -25,6 +25,7 @@ struct Drivers {
 		75us}; // reset time
 	LedStrip::Buffer<LEDSTRIP_LENGTH * 3> buffer1{ledStrip};
 	LedStrip::Buffer<LEDSTRIP_LENGTH * 3> buffer2{ledStrip};
+	LedStrip::Buffer<LEDSTRIP_LENGTH * 3> buffer3{ledStrip};
 };
 
 Drivers drivers;